@@ -30,6 +30,8 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QTranslator>
@@ -103,6 +105,14 @@ static int usage(const QStringList &args)
         "           Default is absolute.\n\n"
         "    -no-ui-lines\n"
         "           Drop line numbers from references to UI files.\n\n"
+        "    -stream\n"
+        "           Write each message as soon as it is read instead of loading the\n"
+        "           whole file first, so memory use stays constant. Applies to a single\n"
+        "           input file converted to TS or PO without -sort-contexts; other\n"
+        "           conversions load the file as usual. Duplicate messages are not\n"
+        "           merged, messages are grouped into contexts only as far as they\n"
+        "           are adjacent in the input, TS locations are absolute unless\n"
+        "           -locations says otherwise, and PO output always uses Qt contexts.\n\n"
         "    -verbose\n"
         "           be a bit more verbose\n\n"
         "Long options can be specified with only one leading dash, too.\n\n"
@@ -120,6 +130,112 @@ struct File
     QString format;
 };
 
+struct Options
+{
+    QString targetLanguage;
+    QString sourceLanguage;
+    bool dropTranslations;
+    bool noObsolete;
+    bool noFinished;
+    bool noUntranslated;
+    bool noUiLines;
+    Translator::LocationsType locations;
+};
+
+// Filters and writes each message as soon as it has been loaded.
+class StreamConverter : public TranslatorMessageSink
+{
+public:
+    StreamConverter(TranslatorStreamWriter &writer, const Options &options)
+        : m_writer(writer), m_options(options), m_headerWritten(false), m_numPlurals(1),
+          m_truncated(false)
+    {}
+
+    void put(const Translator &translator, const TranslatorMessage &msg) override
+    {
+        if (!m_headerWritten)
+            writeHeader(translator);
+
+        TranslatorMessage::Type type = msg.type();
+        if (m_options.noObsolete
+            && (type == TranslatorMessage::Obsolete || type == TranslatorMessage::Vanished))
+            return;
+        if (m_options.noFinished && type == TranslatorMessage::Finished)
+            return;
+        if (m_options.noUntranslated && !msg.isTranslated())
+            return;
+
+        TranslatorMessage out = msg;
+        if (m_options.dropTranslations)
+            Translator::dropTranslation(out);
+        if (m_options.noUiLines)
+            Translator::dropUiLines(out);
+        if (Translator::normalizeTranslation(out, m_numPlurals))
+            m_truncated = true;
+        m_writer.writeMessage(out);
+    }
+
+    bool finish(const Translator &translator, ConversionData &cd)
+    {
+        if (!m_headerWritten)
+            writeHeader(translator);
+        if (m_truncated)
+            Translator::reportTruncatedTranslations(cd);
+        return m_writer.finish();
+    }
+
+private:
+    void writeHeader(const Translator &translator)
+    {
+        Translator header;
+        header.setLanguageCode(m_options.targetLanguage.isEmpty()
+                               ? translator.languageCode() : m_options.targetLanguage);
+        header.setSourceLanguageCode(m_options.sourceLanguage.isEmpty()
+                                     ? translator.sourceLanguageCode() : m_options.sourceLanguage);
+        header.setDependencies(translator.dependencies());
+        header.setExtras(translator.extras());
+        // The input's own locations type is only known once it has been read entirely
+        if (m_options.locations != Translator::DefaultLocations)
+            header.setLocationsType(m_options.locations);
+        m_writer.writeHeader(header);
+        m_numPlurals = Translator::numerusFormCount(header.languageCode());
+        m_headerWritten = true;
+    }
+
+    TranslatorStreamWriter &m_writer;
+    const Options &m_options;
+    bool m_headerWritten;
+    int m_numPlurals;
+    bool m_truncated;
+};
+
+static int streamConvert(const File &inFile, const QString &outFileName,
+                         const QString &outFormat, const Options &options, ConversionData &cd)
+{
+    QFile out;
+    QScopedPointer<TranslatorStreamWriter> writer(
+            Translator::createStreamWriter(out, outFileName, cd, outFormat));
+    if (!writer) {
+        std::cerr << qPrintable(cd.error());
+        return 3;
+    }
+
+    Translator tr;
+    tr.setLanguageCode(Translator::guessLanguageCodeFromFileName(inFile.name));
+    StreamConverter converter(*writer, options);
+    tr.setMessageSink(&converter);
+    if (!tr.load(inFile.name, cd, inFile.format)) {
+        std::cerr << qPrintable(cd.error());
+        return 2;
+    }
+    bool ok = converter.finish(tr, cd);
+    if (!cd.errors().isEmpty()) {
+        std::cerr << qPrintable(cd.error());
+        cd.clearErrors();
+    }
+    return ok ? 0 : 3;
+}
+
 int main(int argc, char *argv[])
 {
     QCoreApplication app(argc, argv);
@@ -142,15 +258,15 @@ int main(int argc, char *argv[])
     QString inFormat(QLatin1String("auto"));
     QString outFileName;
     QString outFormat(QLatin1String("auto"));
-    QString targetLanguage;
-    QString sourceLanguage;
-    bool dropTranslations = false;
-    bool noObsolete = false;
-    bool noFinished = false;
-    bool noUntranslated = false;
+    Options options;
+    options.dropTranslations = false;
+    options.noObsolete = false;
+    options.noFinished = false;
+    options.noUntranslated = false;
+    options.noUiLines = false;
+    options.locations = Translator::DefaultLocations;
     bool verbose = false;
-    bool noUiLines = false;
-    Translator::LocationsType locations = Translator::DefaultLocations;
+    bool stream = false;
 
     ConversionData cd;
     Translator tr;
@@ -186,39 +302,41 @@ int main(int argc, char *argv[])
                 return usage(args);
             cd.m_dropTags.append(args[i]);
         } else if (args[i] == QLatin1String("-drop-translations")) {
-            dropTranslations = true;
+            options.dropTranslations = true;
         } else if (args[i] == QLatin1String("-target-language")) {
             if (++i >= args.size())
                 return usage(args);
-            targetLanguage = args[i];
+            options.targetLanguage = args[i];
         } else if (args[i] == QLatin1String("-source-language")) {
             if (++i >= args.size())
                 return usage(args);
-            sourceLanguage = args[i];
+            options.sourceLanguage = args[i];
         } else if (args[i].startsWith(QLatin1String("-h"))) {
             usage(args);
             return 0;
         } else if (args[i] == QLatin1String("-no-obsolete")) {
-            noObsolete = true;
+            options.noObsolete = true;
         } else if (args[i] == QLatin1String("-no-finished")) {
-            noFinished = true;
+            options.noFinished = true;
         } else if (args[i] == QLatin1String("-no-untranslated")) {
-            noUntranslated = true;
+            options.noUntranslated = true;
         } else if (args[i] == QLatin1String("-sort-contexts")) {
             cd.m_sortContexts = true;
         } else if (args[i] == QLatin1String("-locations")) {
             if (++i >= args.size())
                 return usage(args);
             if (args[i] == QLatin1String("none"))
-                locations = Translator::NoLocations;
+                options.locations = Translator::NoLocations;
             else if (args[i] == QLatin1String("relative"))
-                locations = Translator::RelativeLocations;
+                options.locations = Translator::RelativeLocations;
             else if (args[i] == QLatin1String("absolute"))
-                locations = Translator::AbsoluteLocations;
+                options.locations = Translator::AbsoluteLocations;
             else
                 return usage(args);
         } else if (args[i] == QLatin1String("-no-ui-lines")) {
-            noUiLines = true;
+            options.noUiLines = true;
+        } else if (args[i] == QLatin1String("-stream")) {
+            stream = true;
         } else if (args[i] == QLatin1String("-verbose")) {
             verbose = true;
         } else if (args[i].startsWith(QLatin1Char('-'))) {
@@ -234,6 +352,15 @@ int main(int argc, char *argv[])
     if (inFiles.isEmpty())
         return usage(args);
 
+    if (stream) {
+        if (inFiles.size() == 1 && !cd.m_sortContexts
+            && Translator::canStream(outFileName, outFormat)) {
+            return streamConvert(inFiles[0], outFileName, outFormat, options, cd);
+        }
+        if (verbose)
+            std::cerr << qPrintable(LC::tr("Cannot stream this conversion, loading it entirely.\n"));
+    }
+
     tr.setLanguageCode(Translator::guessLanguageCodeFromFileName(inFiles[0].name));
 
     if (!tr.load(inFiles[0].name, cd, inFiles[0].format)) {
@@ -253,22 +380,22 @@ int main(int argc, char *argv[])
             tr.replaceSorted(tr2.message(j));
     }
 
-    if (!targetLanguage.isEmpty())
-        tr.setLanguageCode(targetLanguage);
-    if (!sourceLanguage.isEmpty())
-        tr.setSourceLanguageCode(sourceLanguage);
-    if (noObsolete)
+    if (!options.targetLanguage.isEmpty())
+        tr.setLanguageCode(options.targetLanguage);
+    if (!options.sourceLanguage.isEmpty())
+        tr.setSourceLanguageCode(options.sourceLanguage);
+    if (options.noObsolete)
         tr.stripObsoleteMessages();
-    if (noFinished)
+    if (options.noFinished)
         tr.stripFinishedMessages();
-    if (noUntranslated)
+    if (options.noUntranslated)
         tr.stripUntranslatedMessages();
-    if (dropTranslations)
+    if (options.dropTranslations)
         tr.dropTranslations();
-    if (noUiLines)
+    if (options.noUiLines)
         tr.dropUiLines();
-    if (locations != Translator::DefaultLocations)
-        tr.setLocationsType(locations);
+    if (options.locations != Translator::DefaultLocations)
+        tr.setLocationsType(options.locations);
 
     tr.normalizeTranslations(cd);
     if (!cd.errors().isEmpty()) {
@@ -103,6 +103,21 @@ void BatchTranslationDialog::startTranslation()
     dlgProgress = new QProgressDialog(tr("Searching, please wait..."), tr("&Cancel"), 0, messageCount, this);
     dlgProgress->show();
 
+    // Go through them in the order the user specified in the phrasebookList.
+    // The first phrase with a given source wins, as in a linear search.
+    QHash<QString, QString> targets;
+    for (int b = 0; b < m_model.rowCount(); ++b) {
+        QModelIndex idx(m_model.index(b, 0));
+        QVariant checkState = m_model.data(idx, Qt::CheckStateRole);
+        if (checkState == Qt::Checked) {
+            PhraseBook *pb = m_phrasebooks[m_model.data(idx, Qt::UserRole).toInt()];
+            foreach (const Phrase *ph, pb->phrases()) {
+                if (!targets.contains(ph->source()))
+                    targets.insert(ph->source(), ph->target());
+            }
+        }
+    }
+
     int msgidx = 0;
     const bool translateTranslated = m_ui.ckTranslateTranslated->isChecked();
     const bool translateFinished = m_ui.ckTranslateFinished->isChecked();
@@ -111,32 +126,21 @@ void BatchTranslationDialog::startTranslation()
             if (!m->isObsolete()
                 && (translateTranslated || m->translation().isEmpty())
                 && (translateFinished || !m->isFinished())) {
-
-                // Go through them in the order the user specified in the phrasebookList
-                for (int b = 0; b < m_model.rowCount(); ++b) {
-                    QModelIndex idx(m_model.index(b, 0));
-                    QVariant checkState = m_model.data(idx, Qt::CheckStateRole);
-                    if (checkState == Qt::Checked) {
-                        PhraseBook *pb = m_phrasebooks[m_model.data(idx, Qt::UserRole).toInt()];
-                        foreach (const Phrase *ph, pb->phrases()) {
-                            if (ph->source() == m->text()) {
-                                m_dataModel->setTranslation(it, ph->target());
-                                m_dataModel->setFinished(it, m_ui.ckMarkFinished->isChecked());
-                                ++translatedcount;
-                                goto done; // break 2;
-                            }
-                        }
-                    }
+                QHash<QString, QString>::ConstIterator target = targets.constFind(m->text());
+                if (target != targets.constEnd()) {
+                    m_dataModel->setTranslation(it, *target);
+                    m_dataModel->setFinished(it, m_ui.ckMarkFinished->isChecked());
+                    ++translatedcount;
                 }
             }
         }
-      done:
         ++msgidx;
-        if (!(msgidx & 15))
+        if (!(msgidx & 15)) {
             dlgProgress->setValue(msgidx);
-        qApp->processEvents();
-        if (dlgProgress->wasCanceled())
-            break;
+            qApp->processEvents();
+            if (dlgProgress->wasCanceled())
+                break;
+        }
     }
     dlgProgress->hide();
 
@@ -31,8 +31,13 @@
 
 #include <quiloader.h>
 
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSet>
 #include <QtCore/QTime>
+#include <QtCore/QTimer>
 
 #include <QtWidgets/QAction>
 #include <QtWidgets/QApplication>
@@ -481,6 +486,24 @@ static void highlightTargets(const QList<TranslatableEntry> &targets, bool on)
         highlightTarget(target, on);
 }
 
+// Instantiating complex forms is slow, so a few of them are kept around.
+static const int MaxCachedForms = 8;
+
+struct PreviewForm
+{
+    PreviewForm() : widget(0) {}
+    ~PreviewForm()
+    {
+        delete widget;
+        destroyTargets(&targets);
+    }
+
+    QString fileName;
+    QDateTime lastModified;
+    QWidget *widget;
+    TargetsHash targets;
+};
+
 FormPreviewView::FormPreviewView(QWidget *parent, MultiDataModel *dataModel)
   : QMainWindow(parent), m_form(0), m_dataModel(dataModel)
 {
@@ -491,6 +514,120 @@ FormPreviewView::FormPreviewView(QWidget *parent, MultiDataModel *dataModel)
     setCentralWidget(m_mdiArea);
     m_mdiArea->setHorizontalScrollBarPolicy(Qt::ScrollBarAsNeeded);
     m_mdiArea->setVerticalScrollBarPolicy(Qt::ScrollBarAsNeeded);
+
+    // Give the user interface a chance to react between two forms.
+    m_preloadTimer = new QTimer(this);
+    m_preloadTimer->setSingleShot(true);
+    m_preloadTimer->setInterval(100);
+    connect(m_preloadTimer, SIGNAL(timeout()), SLOT(preloadNextForm()));
+}
+
+FormPreviewView::~FormPreviewView()
+{
+    qDeleteAll(m_forms);
+}
+
+PreviewForm *FormPreviewView::loadForm(const QString &fileName)
+{
+    static QUiLoader *uiLoader;
+    if (!uiLoader) {
+        uiLoader = new QUiLoader(this);
+        uiLoader->setLanguageChangeEnabled(true);
+        uiLoader->setTranslationEnabled(false);
+    }
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "CANNOT OPEN FORM" << fileName;
+        return 0;
+    }
+    QWidget *widget = uiLoader->load(&file, m_mdiSubWindow);
+    if (!widget) {
+        qDebug() << "CANNOT LOAD FORM" << fileName;
+        return 0;
+    }
+    file.close();
+
+    PreviewForm *form = new PreviewForm;
+    form->fileName = fileName;
+    form->lastModified = QFileInfo(fileName).lastModified();
+    form->widget = widget;
+    buildTargets(widget, &form->targets);
+
+    // This also hides the widget until it is shown in the sub-window.
+    widget->setWindowFlags(Qt::Widget);
+    widget->setWindowModality(Qt::NonModal);
+    widget->setFocusPolicy(Qt::NoFocus);
+    return form;
+}
+
+// Removes the form from the cache, unless the file changed meanwhile.
+PreviewForm *FormPreviewView::takeForm(const QString &fileName)
+{
+    for (int i = 0; i < m_forms.count(); ++i) {
+        PreviewForm *form = m_forms.at(i);
+        if (form->fileName == fileName) {
+            m_forms.removeAt(i);
+            if (form->lastModified == QFileInfo(fileName).lastModified())
+                return form;
+            delete form;
+            return 0;
+        }
+    }
+    return 0;
+}
+
+void FormPreviewView::cacheForm(PreviewForm *form, int index)
+{
+    m_forms.insert(index, form);
+    while (m_forms.count() > MaxCachedForms)
+        delete m_forms.takeLast();
+}
+
+// Instantiates the other forms of the context while the user looks at the current one.
+void FormPreviewView::schedulePreload(int model, const MessageItem *messageItem)
+{
+    m_pendingForms.clear();
+    const ContextItem *contextItem = m_dataModel->model(model)->findContext(messageItem->context());
+    if (!contextItem)
+        return;
+    QDir dir = QFileInfo(m_dataModel->srcFileName(model)).dir();
+    QSet<QString> seen;
+    seen.insert(m_lastFormName);
+    for (int i = 0; i < contextItem->messageCount(); ++i) {
+        const QString name = contextItem->messageItem(i)->fileName();
+        if (!name.endsWith(QLatin1String(".ui"), Qt::CaseInsensitive)
+            && !name.endsWith(QLatin1String(".jui"), Qt::CaseInsensitive)) {
+            continue;
+        }
+        const QString fileName = QDir::cleanPath(dir.absoluteFilePath(name));
+        if (seen.contains(fileName))
+            continue;
+        seen.insert(fileName);
+        // More would push the current form out of the cache.
+        if (m_pendingForms.count() == MaxCachedForms - 1)
+            break;
+        m_pendingForms << fileName;
+    }
+    if (!m_pendingForms.isEmpty())
+        m_preloadTimer->start();
+}
+
+void FormPreviewView::preloadNextForm()
+{
+    while (!m_pendingForms.isEmpty()) {
+        const QString fileName = m_pendingForms.takeFirst();
+        PreviewForm *form = takeForm(fileName);
+        if (!form)
+            form = loadForm(fileName);
+        if (form) {
+            // Behind the current form, which must stay cached.
+            cacheForm(form, m_form ? 1 : 0);
+            break;
+        }
+    }
+    if (!m_pendingForms.isEmpty())
+        m_preloadTimer->start();
 }
 
 void FormPreviewView::setSourceContext(int model, MessageItem *messageItem)
@@ -503,56 +640,52 @@ void FormPreviewView::setSourceContext(int model, MessageItem *messageItem)
     QDir dir = QFileInfo(m_dataModel->srcFileName(model)).dir();
     QString fileName = QDir::cleanPath(dir.absoluteFilePath(messageItem->fileName()));
     if (m_lastFormName != fileName) {
-        delete m_form;
-        m_form = 0;
+        if (m_form) {
+            highlightTargets(m_highlights, false);
+            // Detaching reparents the form to nothing, which would make it a window.
+            QWidget *oldWidget = m_form->widget;
+            m_mdiSubWindow->setWidget(0);
+            oldWidget->setParent(m_mdiSubWindow);
+            oldWidget->hide();
+            m_form = 0;
+        }
         m_lastFormName.clear();
         m_highlights.clear();
-        destroyTargets(&m_targets);
+        m_pendingForms.clear();
 
-        static QUiLoader *uiLoader;
-        if (!uiLoader) {
-            uiLoader = new QUiLoader(this);
-            uiLoader->setLanguageChangeEnabled(true);
-            uiLoader->setTranslationEnabled(false);
-        }
-
-        QFile file(fileName);
-        if (!file.open(QIODevice::ReadOnly)) {
-            qDebug() << "CANNOT OPEN FORM" << fileName;
-            m_mdiSubWindow->hide();
-            return;
-        }
-        m_form = uiLoader->load(&file, m_mdiSubWindow);
-        if (!m_form) {
-            qDebug() << "CANNOT LOAD FORM" << fileName;
+        PreviewForm *form = takeForm(fileName);
+        if (!form)
+            form = loadForm(fileName);
+        if (!form) {
             m_mdiSubWindow->hide();
             return;
         }
-        file.close();
-        buildTargets(m_form, &m_targets);
+        cacheForm(form, 0);
+        m_form = form;
 
         setToolTip(fileName);
 
-        m_form->setWindowFlags(Qt::Widget);
-        m_form->setWindowModality(Qt::NonModal);
-        m_form->setFocusPolicy(Qt::NoFocus);
-        m_form->show(); // needed, otherwide the Qt::NoFocus is not propagated.
-        m_mdiSubWindow->setWidget(m_form);
-        m_mdiSubWindow->setWindowTitle(m_form->windowTitle());
+        QWidget *widget = form->widget;
+        m_mdiSubWindow->setWidget(widget);
+        widget->show(); // needed, otherwide the Qt::NoFocus is not propagated.
+        m_mdiSubWindow->setWindowTitle(widget->windowTitle());
         m_mdiSubWindow->show();
         m_mdiArea->cascadeSubWindows();
         m_lastFormName = fileName;
         m_lastClassName = messageItem->context();
+        // Cached forms show the translations from when they were last shown.
         m_lastModel = -1;
+        schedulePreload(model, messageItem);
     } else {
         highlightTargets(m_highlights, false);
     }
+    TargetsHash &targets = m_form->targets;
     QUiTranslatableStringValue tsv;
     tsv.setValue(messageItem->text().toUtf8());
     tsv.setQualifier(messageItem->comment().toUtf8());
-    m_highlights = m_targets.value(tsv);
+    m_highlights = targets.value(tsv);
     if (m_lastModel != model) {
-        for (TargetsHash::Iterator it = m_targets.begin(), end = m_targets.end(); it != end; ++it)
+        for (TargetsHash::Iterator it = targets.begin(), end = targets.end(); it != end; ++it)
             retranslateTargets(*it, it.key(), m_dataModel->model(model), m_lastClassName);
         m_lastModel = model;
     } else {
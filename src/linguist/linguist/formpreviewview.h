@@ -33,6 +33,7 @@
 
 #include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QStringList>
 
 #include <QtWidgets/QMainWindow>
 
@@ -47,6 +48,7 @@ class QListWidgetItem;
 class QGridLayout;
 class QMdiArea;
 class QMdiSubWindow;
+class QTimer;
 class QToolBox;
 class QTableWidgetItem;
 class QTreeWidgetItem;
@@ -87,21 +89,35 @@ struct TranslatableEntry {
 
 typedef QHash<QUiTranslatableStringValue, QList<TranslatableEntry> > TargetsHash;
 
+struct PreviewForm;
+
 class FormPreviewView : public QMainWindow
 {
     Q_OBJECT
 public:
     FormPreviewView(QWidget *parent, MultiDataModel *dataModel);
+    ~FormPreviewView();
 
     void setSourceContext(int model, MessageItem *messageItem);
 
+private slots:
+    void preloadNextForm();
+
 private:
+    PreviewForm *loadForm(const QString &fileName);
+    PreviewForm *takeForm(const QString &fileName);
+    void cacheForm(PreviewForm *form, int index);
+    void schedulePreload(int model, const MessageItem *messageItem);
+
     bool m_isActive;
     QString m_currentFileName;
     QMdiArea *m_mdiArea;
     QMdiSubWindow *m_mdiSubWindow;
-    QWidget *m_form;
-    TargetsHash m_targets;
+    PreviewForm *m_form;
+    // Instantiated forms, most recently shown first. The first one is m_form, if any.
+    QList<PreviewForm *> m_forms;
+    QStringList m_pendingForms;
+    QTimer *m_preloadTimer;
     QList<TranslatableEntry> m_highlights;
     MultiDataModel *m_dataModel;
 
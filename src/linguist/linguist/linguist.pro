@@ -26,10 +26,12 @@ SOURCES += \
     phraseview.cpp \
     printout.cpp \
     recentfiles.cpp \
+    searchindex.cpp \
     sourcecodeview.cpp \
     statistics.cpp \
     translatedialog.cpp \
     translationsettingsdialog.cpp \
+    validator.cpp \
     ../shared/simtexth.cpp
 
 HEADERS += \
@@ -49,10 +51,12 @@ HEADERS += \
     phraseview.h \
     printout.h \
     recentfiles.h \
+    searchindex.h \
     sourcecodeview.h \
     statistics.h \
     translatedialog.h \
     translationsettingsdialog.h \
+    validator.h \
     ../shared/simtexth.h
 
 contains(QT_PRODUCT, OpenSource.*):DEFINES *= QT_OPENSOURCE
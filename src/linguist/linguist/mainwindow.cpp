@@ -73,101 +73,27 @@
 #include <QPrinter>
 #include <QProcess>
 #include <QRegExp>
+#include <QRunnable>
 #include <QSettings>
 #include <QSortFilterProxyModel>
 #include <QStackedWidget>
 #include <QStatusBar>
 #include <QTextStream>
+#include <QThreadPool>
 #include <QToolBar>
 #include <QUrl>
 #include <QWhatsThis>
 
-#include <ctype.h>
-
 QT_BEGIN_NAMESPACE
 
 static const int MessageMS = 2500;
 
-enum Ending {
-    End_None,
-    End_FullStop,
-    End_Interrobang,
-    End_Colon,
-    End_Ellipsis
-};
-
 static bool hasFormPreview(const QString &fileName)
 {
     return fileName.endsWith(QLatin1String(".ui"))
       || fileName.endsWith(QLatin1String(".jui"));
 }
 
-static QString leadingWhitespace(const QString &str)
-{
-    int i = 0;
-    for (; i < str.size(); i++) {
-        if (!str[i].isSpace()) {
-            break;
-        }
-    }
-    return str.left(i);
-}
-
-static QString trailingWhitespace(const QString &str)
-{
-    int i = str.size();
-    while (--i >= 0) {
-        if (!str[i].isSpace()) {
-            break;
-        }
-    }
-    return str.mid(i + 1);
-}
-
-static Ending ending(QString str, QLocale::Language lang)
-{
-    str = str.simplified();
-    if (str.isEmpty())
-        return End_None;
-
-    switch (str.at(str.length() - 1).unicode()) {
-    case 0x002e: // full stop
-        if (str.endsWith(QLatin1String("...")))
-            return End_Ellipsis;
-        else
-            return End_FullStop;
-    case 0x0589: // armenian full stop
-    case 0x06d4: // arabic full stop
-    case 0x3002: // ideographic full stop
-        return End_FullStop;
-    case 0x0021: // exclamation mark
-    case 0x003f: // question mark
-    case 0x00a1: // inverted exclamation mark
-    case 0x00bf: // inverted question mark
-    case 0x01c3: // latin letter retroflex click
-    case 0x037e: // greek question mark
-    case 0x061f: // arabic question mark
-    case 0x203c: // double exclamation mark
-    case 0x203d: // interrobang
-    case 0x2048: // question exclamation mark
-    case 0x2049: // exclamation question mark
-    case 0x2762: // heavy exclamation mark ornament
-    case 0xff01: // full width exclamation mark
-    case 0xff1f: // full width question mark
-        return End_Interrobang;
-    case 0x003b: // greek 'compatibility' questionmark
-        return lang == QLocale::Greek ? End_Interrobang : End_None;
-    case 0x003a: // colon
-    case 0xff1a: // full width colon
-        return End_Colon;
-    case 0x2026: // horizontal ellipsis
-        return End_Ellipsis;
-    default:
-        return End_None;
-    }
-}
-
-
 class ContextItemDelegate : public QItemDelegate
 {
 public:
@@ -389,6 +315,7 @@ MainWindow::MainWindow()
     m_errorsDock->setAllowedAreas(Qt::AllDockWidgetAreas);
     m_errorsDock->setWindowTitle(tr("Warnings"));
     m_errorsView = new ErrorsView(m_dataModel, this);
+    m_validator = new Validator(m_dataModel, this);
     m_errorsDock->setWidget(m_errorsView);
 
     // Arrange dock widgets
@@ -582,6 +509,17 @@ struct OpenedFile {
     bool langGuessed;
 };
 
+struct ReadFile {
+    ReadFile() : readWrite(false), ok(false) {}
+    ReadFile(const QString &_name, bool _readWrite)
+        : name(_name), readWrite(_readWrite), ok(false) {}
+    QString name;
+    bool readWrite;
+    Translator tor;
+    ConversionData cd;
+    bool ok;
+};
+
 bool MainWindow::openFiles(const QStringList &names, bool globalReadWrite)
 {
     if (names.isEmpty())
@@ -591,14 +529,11 @@ bool MainWindow::openFiles(const QStringList &names, bool globalReadWrite)
     statusBar()->showMessage(tr("Loading..."));
     qApp->processEvents();
 
-    QList<OpenedFile> opened;
-    bool closeOld = false;
-    foreach (QString name, names) {
-        if (!waitCursor) {
-            QApplication::setOverrideCursor(Qt::WaitCursor);
-            waitCursor = true;
-        }
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    waitCursor = true;
 
+    QVector<ReadFile> files;
+    foreach (QString name, names) {
         bool readWrite = globalReadWrite;
         if (name.startsWith(QLatin1Char('='))) {
             name.remove(0, 1);
@@ -609,10 +544,42 @@ bool MainWindow::openFiles(const QStringList &names, bool globalReadWrite)
             name = fi.canonicalFilePath();
         if (m_dataModel->isFileLoaded(name) >= 0)
             continue;
+        files.append(ReadFile(name, readWrite));
+    }
+
+    // Parsing is what takes long, so all files are read in parallel up front.
+    // Everything which may ask the user is done afterwards, in order.
+    {
+        ReadFile *file = files.data();
+        QThreadPool pool;
+        for (int i = 0; i < files.size(); ++i) {
+            pool.start(QRunnable::create([file, i]() {
+                file[i].ok = file[i].tor.load(file[i].name, file[i].cd, QLatin1String("auto"));
+            }));
+        }
+        pool.waitForDone();
+    }
+
+    QList<OpenedFile> opened;
+    bool closeOld = false;
+    for (int i = 0; i < files.size(); ++i) {
+        if (!waitCursor) {
+            QApplication::setOverrideCursor(Qt::WaitCursor);
+            waitCursor = true;
+        }
+
+        const QString &name = files.at(i).name;
+        bool readWrite = files.at(i).readWrite;
+        if (!files.at(i).ok) {
+            QMessageBox::warning(this, tr("Qt Linguist"), files.at(i).cd.error());
+            continue;
+        }
 
         bool langGuessed;
         DataModel *dm = new DataModel(m_dataModel);
-        if (!dm->load(name, &langGuessed, this)) {
+        bool loaded = dm->load(name, files[i].tor, &langGuessed, this);
+        files[i].tor = Translator(); // The data model has its own copy now
+        if (!loaded) {
             delete dm;
             continue;
         }
@@ -698,7 +665,8 @@ bool MainWindow::openFiles(const QStringList &names, bool globalReadWrite)
     m_messageView->setUpdatesEnabled(false);
     int totalCount = 0;
     foreach (const OpenedFile &op, opened) {
-        m_phraseDict.append(QHash<QString, QList<Phrase *> >());
+        m_phraseDict.append(PhraseMatcher());
+        m_validator->appendModel();
         m_dataModel->append(op.dataModel, op.readWrite);
         if (op.readWrite)
             updatePhraseDictInternal(m_phraseDict.size() - 1);
@@ -734,6 +702,7 @@ void MainWindow::closeFile()
     int model = m_currentIndex.model();
     if (model >= 0 && maybeSave(model)) {
         m_phraseDict.removeAt(model);
+        m_validator->removeModel(model);
         m_contextView->setUpdatesEnabled(false);
         m_messageView->setUpdatesEnabled(false);
         m_dataModel->close(model);
@@ -745,6 +714,7 @@ bool MainWindow::closeAll()
 {
     if (maybeSaveAll()) {
         m_phraseDict.clear();
+        m_validator->removeAllModels();
         m_contextView->setUpdatesEnabled(false);
         m_messageView->setUpdatesEnabled(false);
         m_dataModel->closeAll();
@@ -998,6 +968,15 @@ void MainWindow::findAgain()
     const QModelIndex &startIndex = m_messageView->currentIndex();
     QModelIndex index = nextMessage(startIndex);
 
+    // Messages which the search indexes rule out need not be looked at
+    QVector<QSet<const MessageItem *> > candidates(m_dataModel->modelCount());
+    QVector<bool> haveCandidates(m_dataModel->modelCount());
+    if (!m_findUseRegExp) {
+        for (int i = 0; i < m_dataModel->modelCount(); ++i)
+            haveCandidates[i] = m_dataModel->model(i)->searchCandidates(
+                        m_findText, m_findWhere, &candidates[i]);
+    }
+
     while (index.isValid()) {
         QModelIndex realIndex = m_sortedMessagesModel->mapToSource(index);
         MultiDataIndex dataIndex = m_messageModel->dataIndex(realIndex, -1);
@@ -1006,6 +985,10 @@ void MainWindow::findAgain()
             if (MessageItem *m = m_dataModel->messageItem(dataIndex, i)) {
                 if (m_findSkipObsolete && m->isObsolete())
                     continue;
+                if (haveCandidates.at(i) && !candidates.at(i).contains(m)) {
+                    hadMessage = true;
+                    continue;
+                }
                 bool found = true;
                 do {
                     if (!hadMessage) {
@@ -1562,15 +1545,17 @@ void MainWindow::updateTranslation(const QStringList &translations)
     if (translations == m->translations())
         return;
 
-    m->setTranslations(translations);
-    if (!m->fileName().isEmpty() && hasFormPreview(m->fileName()))
-        m_formPreviewView->setSourceContext(m_currentIndex.model(), m);
-    updateDanger(m_currentIndex, true);
-
+    // Unfinish first, so the statistics drop the old translations
     if (m->isFinished())
         m_dataModel->setFinished(m_currentIndex, false);
     else
         m_dataModel->setModified(m_currentIndex.model(), true);
+
+    m->setTranslations(translations);
+    m_dataModel->model(m_currentIndex.model())->markSearchDirty(m);
+    if (!m->fileName().isEmpty() && hasFormPreview(m->fileName()))
+        m_formPreviewView->setSourceContext(m_currentIndex.model(), m);
+    updateDanger(m_currentIndex, true);
 }
 
 void MainWindow::updateTranslatorComment(const QString &comment)
@@ -1582,6 +1567,7 @@ void MainWindow::updateTranslatorComment(const QString &comment)
         return;
 
     m->setTranslatorComment(comment);
+    m_dataModel->model(m_currentIndex.model())->markSearchDirty(m);
 
     m_dataModel->setModified(m_currentIndex.model(), true);
 }
@@ -1799,8 +1785,8 @@ void MainWindow::findNext(const QString &text, DataModel::FindLocation where,
 
 void MainWindow::revalidate()
 {
-    for (MultiDataModelIterator it(m_dataModel, -1); it.isValid(); ++it)
-        updateDanger(it, false);
+    m_validator->setChecks(validationChecks());
+    m_validator->validateAll();
 
     if (m_currentIndex.isValid())
         updateDanger(m_currentIndex, true);
@@ -2389,9 +2375,8 @@ void MainWindow::updatePhraseBookActions()
 
 void MainWindow::updatePhraseDictInternal(int model)
 {
-    QHash<QString, QList<Phrase *> > &pd = m_phraseDict[model];
-
-    pd.clear();
+    // Phrase books for the exact locale go first
+    QList<Phrase *> ordered;
     foreach (PhraseBook *pb, m_phraseBooks) {
         bool before;
         if (pb->language() != QLocale::C && m_dataModel->language(model) != QLocale::C) {
@@ -2402,19 +2387,25 @@ void MainWindow::updatePhraseDictInternal(int model)
             before = false;
         }
         foreach (Phrase *p, pb->phrases()) {
-            QString f = friendlyString(p->source());
-            if (f.length() > 0) {
-                f = f.split(QLatin1Char(' ')).first();
-                if (!pd.contains(f)) {
-                    pd.insert(f, QList<Phrase *>());
-                }
-                if (before)
-                    pd[f].prepend(p);
-                else
-                    pd[f].append(p);
-            }
+            if (before)
+                ordered.prepend(p);
+            else
+                ordered.append(p);
         }
     }
+
+    PhraseMatcher &pd = m_phraseDict[model];
+    pd.clear();
+    Validator::PhraseTable phrases;
+    foreach (Phrase *p, ordered) {
+        const QString f = friendlyString(p->source());
+        if (f.isEmpty())
+            continue;
+        pd.add(f, p);
+        phrases[f.split(QLatin1Char(' ')).first()].append(
+                    qMakePair(f, friendlyString(p->target())));
+    }
+    m_validator->setPhrases(model, phrases);
 }
 
 void MainWindow::updatePhraseDict(int model)
@@ -2425,209 +2416,47 @@ void MainWindow::updatePhraseDict(int model)
 
 void MainWindow::updatePhraseDicts()
 {
-    for (int i = 0; i < m_phraseDict.size(); ++i)
-        if (!m_dataModel->isModelWritable(i))
+    for (int i = 0; i < m_phraseDict.size(); ++i) {
+        if (!m_dataModel->isModelWritable(i)) {
             m_phraseDict[i].clear();
-        else
+            m_validator->setPhrases(i, Validator::PhraseTable());
+        } else {
             updatePhraseDictInternal(i);
-    revalidate();
-    m_phraseView->update();
-}
-
-static bool haveMnemonic(const QString &str)
-{
-    for (const ushort *p = (ushort *)str.constData();; ) { // Assume null-termination
-        ushort c = *p++;
-        if (!c)
-            break;
-        if (c == '&') {
-            c = *p++;
-            if (!c)
-                return false;
-            // "Nobody" ever really uses these alt-space, and they are highly annoying
-            // because we get a lot of false positives.
-            if (c != '&' && c != ' ' && QChar(c).isPrint()) {
-                const ushort *pp = p;
-                for (; *p < 256 && isalpha(*p); p++) ;
-                if (pp == p || *p != ';')
-                    return true;
-                // This looks like a HTML &entity;, so ignore it. As a HTML string
-                // won't contain accels anyway, we can stop scanning here.
-                break;
-            }
         }
     }
-    return false;
+    revalidate();
+    m_phraseView->update();
 }
 
 void MainWindow::updateDanger(const MultiDataIndex &index, bool verbose)
 {
-    MultiDataIndex curIdx = index;
     m_errorsView->clear();
 
-    QString source;
-    for (int mi = 0; mi < m_dataModel->modelCount(); ++mi) {
-        if (!m_dataModel->isModelWritable(mi))
-            continue;
-        curIdx.setModel(mi);
-        MessageItem *m = m_dataModel->messageItem(curIdx);
-        if (!m || m->isObsolete())
-            continue;
-
-        bool danger = false;
-        if (m->message().isTranslated()) {
-            if (source.isEmpty()) {
-                source = m->pluralText();
-                if (source.isEmpty())
-                    source = m->text();
-            }
-            QStringList translations = m->translations();
-
-            // Truncated variants are permitted to be "denormalized"
-            for (int i = 0; i < translations.count(); ++i) {
-                int sep = translations.at(i).indexOf(QChar(Translator::BinaryVariantSeparator));
-                if (sep >= 0)
-                    translations[i].truncate(sep);
-            }
-
-            if (m_ui.actionAccelerators->isChecked()) {
-                bool sk = haveMnemonic(source);
-                bool tk = true;
-                for (int i = 0; i < translations.count() && tk; ++i) {
-                    tk &= haveMnemonic(translations[i]);
-                }
-
-                if (!sk && tk) {
-                    if (verbose)
-                        m_errorsView->addError(mi, ErrorsView::SuperfluousAccelerator);
-                    danger = true;
-                } else if (sk && !tk) {
-                    if (verbose)
-                        m_errorsView->addError(mi, ErrorsView::MissingAccelerator);
-                    danger = true;
-                }
-            }
-            if (m_ui.actionSurroundingWhitespace->isChecked()) {
-                bool whitespaceok = true;
-                for (int i = 0; i < translations.count() && whitespaceok; ++i) {
-                    whitespaceok &= (leadingWhitespace(source) == leadingWhitespace(translations[i]));
-                    whitespaceok &= (trailingWhitespace(source) == trailingWhitespace(translations[i]));
-                }
+    QList<Validator::Error> errors;
+    m_validator->setChecks(validationChecks());
+    m_validator->validate(index, verbose ? &errors : 0);
 
-                if (!whitespaceok) {
-                    if (verbose)
-                        m_errorsView->addError(mi, ErrorsView::SurroundingWhitespaceDiffers);
-                    danger = true;
-                }
-            }
-            if (m_ui.actionEndingPunctuation->isChecked()) {
-                bool endingok = true;
-                for (int i = 0; i < translations.count() && endingok; ++i) {
-                    endingok &= (ending(source, m_dataModel->sourceLanguage(mi)) ==
-                                ending(translations[i], m_dataModel->language(mi)));
-                }
-
-                if (!endingok) {
-                    if (verbose)
-                        m_errorsView->addError(mi, ErrorsView::PunctuationDiffers);
-                    danger = true;
-                }
-            }
-            if (m_ui.actionPhraseMatches->isChecked()) {
-                QString fsource = friendlyString(source);
-                QString ftranslation = friendlyString(translations.first());
-                QStringList lookupWords = fsource.split(QLatin1Char(' '));
-
-                bool phraseFound;
-                foreach (const QString &s, lookupWords) {
-                    if (m_phraseDict[mi].contains(s)) {
-                        phraseFound = true;
-                        foreach (const Phrase *p, m_phraseDict[mi].value(s)) {
-                            if (fsource == friendlyString(p->source())) {
-                                if (ftranslation.indexOf(friendlyString(p->target())) >= 0) {
-                                    phraseFound = true;
-                                    break;
-                                } else {
-                                    phraseFound = false;
-                                }
-                            }
-                        }
-                        if (!phraseFound) {
-                            if (verbose)
-                                m_errorsView->addError(mi, ErrorsView::IgnoredPhrasebook, s);
-                            danger = true;
-                        }
-                    }
-                }
-            }
-
-            if (m_ui.actionPlaceMarkerMatches->isChecked()) {
-                // Stores the occurrence count of the place markers in the map placeMarkerIndexes.
-                // i.e. the occurrence count of %1 is stored at placeMarkerIndexes[1],
-                // count of %2 is stored at placeMarkerIndexes[2] etc.
-                // In the first pass, it counts all place markers in the sourcetext.
-                // In the second pass it (de)counts all place markers in the translation.
-                // When finished, all elements should have returned to a count of 0,
-                // if not there is a mismatch
-                // between place markers in the source text and the translation text.
-                QHash<int, int> placeMarkerIndexes;
-                QString translation;
-                int numTranslations = translations.count();
-                for (int pass = 0; pass < numTranslations + 1; ++pass) {
-                    const QChar *uc_begin = source.unicode();
-                    const QChar *uc_end = uc_begin + source.length();
-                    if (pass >= 1) {
-                        translation = translations[pass - 1];
-                        uc_begin = translation.unicode();
-                        uc_end = uc_begin + translation.length();
-                    }
-                    const QChar *c = uc_begin;
-                    while (c < uc_end) {
-                        if (c->unicode() == '%') {
-                            const QChar *escape_start = ++c;
-                            while (c->isDigit())
-                                ++c;
-                            const QChar *escape_end = c;
-                            bool ok = true;
-                            int markerIndex = QString::fromRawData(
-                                    escape_start, escape_end - escape_start).toInt(&ok);
-                            if (ok)
-                                placeMarkerIndexes[markerIndex] += (pass == 0 ? numTranslations : -1);
-                        }
-                        ++c;
-                    }
-                }
-
-                foreach (int i, placeMarkerIndexes) {
-                    if (i != 0) {
-                        if (verbose)
-                            m_errorsView->addError(mi, ErrorsView::PlaceMarkersDiffer);
-                        danger = true;
-                        break;
-                    }
-                }
-
-                // Piggy-backed on the general place markers, we check the plural count marker.
-                if (m->message().isPlural()) {
-                    for (int i = 0; i < numTranslations; ++i)
-                        if (m_dataModel->model(mi)->countRefNeeds().at(i)
-                            && !(translations[i].contains(QLatin1String("%n"))
-                            || translations[i].contains(QLatin1String("%Ln")))) {
-                            if (verbose)
-                                m_errorsView->addError(mi, ErrorsView::NumerusMarkerMissing);
-                            danger = true;
-                            break;
-                        }
-                }
-            }
-        }
-
-        if (danger != m->danger())
-            m_dataModel->setDanger(curIdx, danger);
+    if (verbose) {
+        foreach (const Validator::Error &error, errors)
+            m_errorsView->addError(error.model, error.type, error.arg);
+        statusBar()->showMessage(m_errorsView->firstError());
     }
+}
 
-    if (verbose)
-        statusBar()->showMessage(m_errorsView->firstError());
+Validator::Checks MainWindow::validationChecks() const
+{
+    Validator::Checks checks;
+    if (m_ui.actionAccelerators->isChecked())
+        checks |= Validator::Accelerators;
+    if (m_ui.actionSurroundingWhitespace->isChecked())
+        checks |= Validator::SurroundingWhitespace;
+    if (m_ui.actionEndingPunctuation->isChecked())
+        checks |= Validator::EndingPunctuation;
+    if (m_ui.actionPhraseMatches->isChecked())
+        checks |= Validator::PhraseMatches;
+    if (m_ui.actionPlaceMarkerMatches->isChecked())
+        checks |= Validator::PlaceMarkers;
+    return checks;
 }
 
 void MainWindow::readConfig()
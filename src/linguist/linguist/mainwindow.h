@@ -33,6 +33,7 @@
 #include "ui_mainwindow.h"
 #include "recentfiles.h"
 #include "messagemodel.h"
+#include "validator.h"
 
 #include <QtCore/QHash>
 #include <QtCore/QLocale>
@@ -196,6 +197,7 @@ private:
 
     // FIXME: move to DataModel
     void updateDanger(const MultiDataIndex &index, bool verbose);
+    Validator::Checks validationChecks() const;
 
     bool searchItem(DataModel::FindLocation where, const QString &searchWhat);
 
@@ -212,12 +214,13 @@ private:
     SourceCodeView *m_sourceCodeView;
     FormPreviewView *m_formPreviewView;
     ErrorsView *m_errorsView;
+    Validator *m_validator;
     QLabel *m_progressLabel;
     QLabel *m_modifiedLabel;
     FocusWatcher *m_focusWatcher;
     QString m_phraseBookDir;
     // model : keyword -> list of appropriate phrases in the phrasebooks
-    QList<QHash<QString, QList<Phrase *> > > m_phraseDict;
+    QList<PhraseMatcher> m_phraseDict;
     QList<PhraseBook *> m_phraseBooks;
     QMap<QAction *, PhraseBook *> m_phraseBookMenu[3];
     QPrinter *m_printer;
@@ -30,6 +30,8 @@
 
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDebug>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
 
 #include <QtWidgets/QMessageBox>
 #include <QtGui/QPainter>
@@ -94,14 +96,18 @@ MessageItem *ContextItem::messageItem(int i) const
     return 0;
 }
 
+void ContextItem::appendMessage(const MessageItem &msg)
+{
+    const QPair<QString, QString> key(msg.text(), msg.comment());
+    if (!m_messageIndex.contains(key))
+        m_messageIndex.insert(key, msgItemList.count());
+    msgItemList.append(msg);
+}
+
 MessageItem *ContextItem::findMessage(const QString &sourcetext, const QString &comment) const
 {
-    for (int i = 0; i < messageCount(); ++i) {
-        MessageItem *mi = messageItem(i);
-        if (mi->text() == sourcetext && mi->comment() == comment)
-            return mi;
-    }
-    return 0;
+    int i = m_messageIndex.value(qMakePair(sourcetext, comment), -1);
+    return i >= 0 ? messageItem(i) : 0;
 }
 
 /******************************************************************************
@@ -117,6 +123,9 @@ DataModel::DataModel(QObject *parent)
     m_srcWords(0),
     m_srcChars(0),
     m_srcCharsSpc(0),
+    m_trWords(0),
+    m_trChars(0),
+    m_trCharsSpc(0),
     m_language(QLocale::Language(-1)),
     m_sourceLanguage(QLocale::Language(-1)),
     m_country(QLocale::Country(-1)),
@@ -145,12 +154,8 @@ MessageItem *DataModel::messageItem(const DataIndex &index) const
 
 ContextItem *DataModel::findContext(const QString &context) const
 {
-    for (int c = 0; c < m_contextList.count(); ++c) {
-        ContextItem *ctx = contextItem(c);
-        if (ctx->context() == context)
-            return ctx;
-    }
-    return 0;
+    int c = m_contextIndex.value(context, -1);
+    return c >= 0 ? contextItem(c) : 0;
 }
 
 MessageItem *DataModel::findMessage(const QString &context,
@@ -195,6 +200,11 @@ bool DataModel::load(const QString &fileName, bool *langGuessed, QWidget *parent
         return false;
     }
 
+    return load(fileName, tor, langGuessed, parent);
+}
+
+bool DataModel::load(const QString &fileName, Translator &tor, bool *langGuessed, QWidget *parent)
+{
     if (!tor.messageCount()) {
         QMessageBox::warning(parent, QObject::tr("Qt Linguist"),
                              tr("The translation file '%1' will not be loaded because it is empty.")
@@ -232,27 +242,31 @@ bool DataModel::load(const QString &fileName, bool *langGuessed, QWidget *parent
     m_relativeLocations = (tor.locationsType() == Translator::RelativeLocations);
     m_extra = tor.extras();
     m_contextList.clear();
+    m_contextIndex.clear();
     m_numMessages = 0;
 
-    QHash<QString, int> contexts;
-
     m_srcWords = 0;
     m_srcChars = 0;
     m_srcCharsSpc = 0;
+    m_trWords = 0;
+    m_trChars = 0;
+    m_trCharsSpc = 0;
 
-    foreach (const TranslatorMessage &msg, tor.messages()) {
-        if (!contexts.contains(msg.context())) {
-            contexts.insert(msg.context(), m_contextList.size());
+    foreach (const TranslatorMessage &msg, tor.constMessages()) {
+        if (!m_contextIndex.contains(msg.context())) {
+            m_contextIndex.insert(msg.context(), m_contextList.size());
             m_contextList.append(ContextItem(msg.context()));
         }
 
-        ContextItem *c = contextItem(contexts.value(msg.context()));
+        ContextItem *c = contextItem(m_contextIndex.value(msg.context()));
         if (msg.sourceText() == QLatin1String(ContextComment)) {
             c->appendToComment(msg.comment());
         } else {
             MessageItem tmp(msg);
-            if (msg.type() == TranslatorMessage::Finished)
+            if (msg.type() == TranslatorMessage::Finished) {
                 c->incrementFinishedCount();
+                addToStatistics(&tmp);
+            }
             if (msg.type() == TranslatorMessage::Finished || msg.type() == TranslatorMessage::Unfinished) {
                 doCharCounting(tmp.text(), m_srcWords, m_srcChars, m_srcCharsSpc);
                 doCharCounting(tmp.pluralText(), m_srcWords, m_srcChars, m_srcCharsSpc);
@@ -309,6 +323,7 @@ bool DataModel::load(const QString &fileName, bool *langGuessed, QWidget *parent
     setSourceLanguageAndCountry(l, c);
 
     setModified(false);
+    buildSearchIndex();
 
     return true;
 }
@@ -424,22 +439,61 @@ void DataModel::setSourceLanguageAndCountry(QLocale::Language lang, QLocale::Cou
     setModified(true);
 }
 
+// The totals of the finished translations are kept up to date as messages
+// change, so this is cheap enough to call after every edit.
 void DataModel::updateStatistics()
+{
+    emit statsChanged(m_srcWords, m_srcChars, m_srcCharsSpc, m_trWords, m_trChars, m_trCharsSpc);
+}
+
+void DataModel::addToStatistics(const MessageItem *m)
+{
+    const QStringList translations = m->translations();
+    for (const QString &trnsl : translations)
+        doCharCounting(trnsl, m_trWords, m_trChars, m_trCharsSpc);
+}
+
+void DataModel::removeFromStatistics(const MessageItem *m)
 {
     int trW = 0;
     int trC = 0;
     int trCS = 0;
+    const QStringList translations = m->translations();
+    for (const QString &trnsl : translations)
+        doCharCounting(trnsl, trW, trC, trCS);
+    m_trWords -= trW;
+    m_trChars -= trC;
+    m_trCharsSpc -= trCS;
+}
 
-    for (DataModelIterator it(this); it.isValid(); ++it) {
-        const MessageItem *mi = it.current();
-        if (mi->isFinished()) {
-            const QStringList translations = mi->translations();
-            for (const QString &trnsl : translations)
-                doCharCounting(trnsl, trW, trC, trCS);
-        }
-    }
-
-    emit statsChanged(m_srcWords, m_srcChars, m_srcCharsSpc, trW, trC, trCS);
+void DataModel::buildSearchIndex()
+{
+    QVector<SearchIndex::Entry> entries;
+    entries.reserve(m_numMessages);
+    for (DataModelIterator it(this); it.isValid(); ++it)
+        entries.append(SearchIndex::entry(messageItem(it)));
+    m_searchIndex.reset(new SearchIndex);
+    m_searchDirty.clear();
+
+    // The worker shares the index, so it does not matter whether this
+    // model is still around when it is done
+    QSharedPointer<SearchIndex> index = m_searchIndex;
+    QThreadPool::globalInstance()->start(QRunnable::create([index, entries]() {
+        index->build(entries);
+    }));
+}
+
+// Returns false if the search cannot be narrowed down, in which case all
+// messages have to be searched. Otherwise, only the messages in the result
+// can match; they still need to be checked.
+bool DataModel::searchCandidates(const QString &text, int where,
+                                 QSet<const MessageItem *> *result) const
+{
+    if (!m_searchIndex || !m_searchIndex->isReady()
+        || !m_searchIndex->candidates(text, where, result))
+        return false;
+    result->unite(m_searchDirty);
+    return true;
 }
 
 void DataModel::setModified(bool isModified)
@@ -534,6 +588,7 @@ MultiContextItem::MultiContextItem(int oldCount, ContextItem *ctx, bool writable
         mList.append(m);
         eList.append(0);
         m_multiMessageList.append(MultiMessageItem(m));
+        indexMessage(j);
     }
     for (int i = 0; i < oldCount; ++i) {
         m_messageLists.append(eList);
@@ -591,10 +646,13 @@ void MultiContextItem::appendMessageItems(const QList<MessageItem *> &m)
     for (int i = 0; i < m_messageLists.count() - 1; ++i)
         m_messageLists[i] += nullItems;
     m_messageLists.last() += m;
-    foreach (MessageItem *mi, m)
+    foreach (MessageItem *mi, m) {
         m_multiMessageList.append(MultiMessageItem(mi));
+        indexMessage(m_multiMessageList.count() - 1);
+    }
 }
 
+// This leaves the lookup tables stale; reindexMessages() must follow
 void MultiContextItem::removeMultiMessageItem(int pos)
 {
     for (int i = 0; i < m_messageLists.count(); ++i)
@@ -602,6 +660,24 @@ void MultiContextItem::removeMultiMessageItem(int pos)
     m_multiMessageList.removeAt(pos);
 }
 
+void MultiContextItem::indexMessage(int pos)
+{
+    const MultiMessageItem &m = m_multiMessageList.at(pos);
+    const QPair<QString, QString> key(m.text(), m.comment());
+    if (!m_textIndex.contains(key))
+        m_textIndex.insert(key, pos);
+    if (!m.id().isEmpty() && !m_idIndex.contains(m.id()))
+        m_idIndex.insert(m.id(), pos);
+}
+
+void MultiContextItem::reindexMessages()
+{
+    m_textIndex.clear();
+    m_idIndex.clear();
+    for (int i = 0; i < m_multiMessageList.count(); ++i)
+        indexMessage(i);
+}
+
 int MultiContextItem::firstNonobsoleteMessageIndex(int msgIdx) const
 {
     for (int i = 0; i < m_messageLists.size(); ++i)
@@ -612,22 +688,12 @@ int MultiContextItem::firstNonobsoleteMessageIndex(int msgIdx) const
 
 int MultiContextItem::findMessage(const QString &sourcetext, const QString &comment) const
 {
-    for (int i = 0, cnt = messageCount(); i < cnt; ++i) {
-        MultiMessageItem *m = multiMessageItem(i);
-        if (m->text() == sourcetext && m->comment() == comment)
-            return i;
-    }
-    return -1;
+    return m_textIndex.value(qMakePair(sourcetext, comment), -1);
 }
 
 int MultiContextItem::findMessageById(const QString &id) const
 {
-    for (int i = 0, cnt = messageCount(); i < cnt; ++i) {
-        MultiMessageItem *m = multiMessageItem(i);
-        if (m->id() == id)
-            return i;
-    }
-    return -1;
+    return m_idIndex.value(id, -1);
 }
 
 /******************************************************************************
@@ -755,6 +821,7 @@ void MultiDataModel::append(DataModel *dm, bool readWrite)
                 m_numMessages += appendItems.size();
             }
         } else {
+            m_contextIndex.insert(c->context(), m_multiContextList.size());
             m_multiContextList << MultiContextItem(modelCount() - 1, c, readWrite);
             m_numMessages += c->messageCount();
             ++appendedContexts;
@@ -791,22 +858,33 @@ void MultiDataModel::close(int model)
         delete m_dataModels.takeAt(model);
         m_msgModel->endRemoveColumns();
         emit modelDeleted(model);
+        bool removedContexts = false;
         for (int i = m_multiContextList.size(); --i >= 0;) {
             MultiContextItem &mc = m_multiContextList[i];
             QModelIndex contextIdx = m_msgModel->createIndex(i, 0);
+            bool removedMessages = false;
             for (int j = mc.messageCount(); --j >= 0;)
                 if (mc.multiMessageItem(j)->isEmpty()) {
                     m_msgModel->beginRemoveRows(contextIdx, j, j);
                     mc.removeMultiMessageItem(j);
                     m_msgModel->endRemoveRows();
                     --m_numMessages;
+                    removedMessages = true;
                 }
             if (!mc.messageCount()) {
                 m_msgModel->beginRemoveRows(QModelIndex(), i, i);
                 m_multiContextList.removeAt(i);
                 m_msgModel->endRemoveRows();
+                removedContexts = true;
+            } else if (removedMessages) {
+                mc.reindexMessages();
             }
         }
+        if (removedContexts) {
+            m_contextIndex.clear();
+            for (int i = 0; i < m_multiContextList.size(); ++i)
+                m_contextIndex.insert(m_multiContextList.at(i).context(), i);
+        }
         onModifiedChanged();
     }
 }
@@ -820,6 +898,7 @@ void MultiDataModel::closeAll()
     qDeleteAll(m_dataModels);
     m_dataModels.clear();
     m_multiContextList.clear();
+    m_contextIndex.clear();
     m_msgModel->endResetModel();
     emit allModelsDeleted();
     onModifiedChanged();
@@ -949,22 +1028,13 @@ int MultiDataModel::isFileLoaded(const QString &name) const
 
 int MultiDataModel::findContextIndex(const QString &context) const
 {
-    for (int i = 0; i < m_multiContextList.size(); ++i) {
-        const MultiContextItem &mc = m_multiContextList[i];
-        if (mc.context() == context)
-            return i;
-    }
-    return -1;
+    return m_contextIndex.value(context, -1);
 }
 
 MultiContextItem *MultiDataModel::findContext(const QString &context) const
 {
-    for (int i = 0; i < m_multiContextList.size(); ++i) {
-        const MultiContextItem &mc = m_multiContextList[i];
-        if (mc.context() == context)
-            return const_cast<MultiContextItem *>(&mc);
-    }
-    return 0;
+    int i = findContextIndex(context);
+    return i >= 0 ? multiContextItem(i) : 0;
 }
 
 MessageItem *MultiDataModel::messageItem(const MultiDataIndex &index, int model) const
@@ -984,7 +1054,15 @@ void MultiDataModel::setTranslation(const MultiDataIndex &index, const QString &
     MessageItem *m = messageItem(index);
     if (translation == m->translation())
         return;
-    m->setTranslation(translation);
+    if (m->isFinished()) {
+        DataModel *dm = m_dataModels[index.model()];
+        dm->removeFromStatistics(m);
+        m->setTranslation(translation);
+        dm->addToStatistics(m);
+    } else {
+        m->setTranslation(translation);
+    }
+    m_dataModels[index.model()]->markSearchDirty(m);
     setModified(index.model(), true);
     emit translationChanged(index);
 }
@@ -998,6 +1076,7 @@ void MultiDataModel::setFinished(const MultiDataIndex &index, bool finished)
     TranslatorMessage::Type type = m->type();
     if (type == TranslatorMessage::Unfinished && finished) {
         m->setType(TranslatorMessage::Finished);
+        m_dataModels[index.model()]->addToStatistics(m);
         mm->decrementUnfinishedCount();
         if (!mm->countUnfinished()) {
             incrementFinishedCount();
@@ -1018,6 +1097,7 @@ void MultiDataModel::setFinished(const MultiDataIndex &index, bool finished)
         setModified(index.model(), true);
     } else if (type == TranslatorMessage::Finished && !finished) {
         m->setType(TranslatorMessage::Unfinished);
+        m_dataModels[index.model()]->removeFromStatistics(m);
         mm->incrementUnfinishedCount();
         if (mm->countUnfinished() == 1) {
             decrementFinishedCount();
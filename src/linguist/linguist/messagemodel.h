@@ -29,12 +29,15 @@
 #ifndef MESSAGEMODEL_H
 #define MESSAGEMODEL_H
 
+#include "searchindex.h"
 #include "translator.h"
 
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QList>
 #include <QtCore/QHash>
 #include <QtCore/QLocale>
+#include <QtCore/QSet>
+#include <QtCore/QSharedPointer>
 #include <QtGui/QColor>
 #include <QtGui/QBitmap>
 
@@ -114,7 +117,7 @@ public:
 private:
     friend class DataModel;
     friend class MultiDataModel;
-    void appendMessage(const MessageItem &msg) { msgItemList.append(msg); }
+    void appendMessage(const MessageItem &msg);
     void appendToComment(const QString &x);
     void incrementFinishedCount() { ++m_finishedCount; }
     void decrementFinishedCount() { --m_finishedCount; }
@@ -131,6 +134,7 @@ private:
     int m_unfinishedDangerCount;
     int m_nonobsoleteCount;
     QList<MessageItem> msgItemList;
+    QHash<QPair<QString, QString>, int> m_messageIndex; // source text, comment
 };
 
 
@@ -187,6 +191,8 @@ public:
 
     bool isWellMergeable(const DataModel *other) const;
     bool load(const QString &fileName, bool *langGuessed, QWidget *parent);
+    // Takes the already read catalogue, which may be loaded in any thread
+    bool load(const QString &fileName, Translator &tor, bool *langGuessed, QWidget *parent);
     bool save(QWidget *parent) { return save(m_srcFileName, parent); }
     bool saveAs(const QString &newFileName, QWidget *parent);
     bool release(const QString &fileName, bool verbose,
@@ -211,11 +217,21 @@ public:
     QStringList normalizedTranslations(const MessageItem &m) const;
     void doCharCounting(const QString& text, int& trW, int& trC, int& trCS);
     void updateStatistics();
+    // Account for a finished message whose translations change or which
+    // becomes (un)finished; the counts must be taken of the same translations
+    void addToStatistics(const MessageItem *m);
+    void removeFromStatistics(const MessageItem *m);
 
     int getSrcWords() const { return m_srcWords; }
     int getSrcChars() const { return m_srcChars; }
     int getSrcCharsSpc() const { return m_srcCharsSpc; }
 
+    // The search index is built in the background after loading; messages
+    // edited since their texts were taken must be marked dirty
+    void markSearchDirty(const MessageItem *m) { m_searchDirty.insert(m); }
+    bool searchCandidates(const QString &text, int where,
+                          QSet<const MessageItem *> *result) const;
+
 signals:
     void statsChanged(int words, int characters, int cs, int words2, int characters2, int cs2);
     void progressChanged(int finishedCount, int oldFinishedCount);
@@ -225,9 +241,11 @@ signals:
 private:
     friend class DataModelIterator;
     QList<ContextItem> m_contextList;
+    QHash<QString, int> m_contextIndex;
 
     bool save(const QString &fileName, QWidget *parent);
     void updateLocale();
+    void buildSearchIndex();
 
     bool m_writable;
     bool m_modified;
@@ -238,6 +256,12 @@ private:
     int m_srcWords;
     int m_srcChars;
     int m_srcCharsSpc;
+    int m_trWords;
+    int m_trChars;
+    int m_trCharsSpc;
+
+    QSharedPointer<SearchIndex> m_searchIndex;
+    QSet<const MessageItem *> m_searchDirty;
 
     QString m_srcFileName;
     QLocale::Language m_language;
@@ -323,6 +347,8 @@ private:
     void putMessageItem(int pos, MessageItem *m);
     void appendMessageItems(const QList<MessageItem *> &m);
     void removeMultiMessageItem(int pos);
+    void indexMessage(int pos);
+    void reindexMessages();
     void incrementFinishedCount() { ++m_finishedCount; }
     void decrementFinishedCount() { --m_finishedCount; }
     void incrementEditableCount() { ++m_editableCount; }
@@ -337,6 +363,9 @@ private:
     // The next two could be in the MultiMessageItems, but are here for efficiency
     QList<QList<MessageItem *> > m_messageLists;
     QList<QList<MessageItem *> *> m_writableMessageLists;
+    // For aligning the messages of further models; the first message wins
+    QHash<QPair<QString, QString>, int> m_textIndex; // source text, comment
+    QHash<QString, int> m_idIndex;
     int m_finishedCount; // read-write
     int m_editableCount; // read-write
     int m_nonobsoleteCount; // all (note: this counts messages, not multi-messages)
@@ -476,6 +505,7 @@ private:
     bool m_modified;
 
     QList<MultiContextItem> m_multiContextList;
+    QHash<QString, int> m_contextIndex;
     QList<DataModel *> m_dataModels;
 
     MessageModel *m_msgModel;
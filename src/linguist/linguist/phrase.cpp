@@ -35,10 +35,13 @@
 #include <QFileInfo>
 #include <QMessageBox>
 #include <QRegExp>
+#include <QSet>
 #include <QTextCodec>
 #include <QTextStream>
 #include <QXmlStreamReader>
 
+#include <algorithm>
+
 QT_BEGIN_NAMESPACE
 
 static QString protect(const QString & str)
@@ -332,4 +335,109 @@ QString PhraseBook::friendlyPhraseBookName() const
     return QString();
 }
 
+PhraseMatcher::PhraseMatcher()
+    : m_linksValid(true),
+      m_count(0)
+{
+    m_nodes.append(Node());
+}
+
+void PhraseMatcher::clear()
+{
+    m_nodes.clear();
+    m_nodes.append(Node());
+    m_linksValid = true;
+    m_count = 0;
+}
+
+void PhraseMatcher::add(const QString &source, Phrase *phrase)
+{
+    if (source.isEmpty())
+        return;
+    int node = 0;
+    foreach (const QString &word, source.split(QLatin1Char(' '))) {
+        int next = m_nodes.at(node).next.value(word, -1);
+        if (next < 0) {
+            next = m_nodes.size();
+            Node n;
+            n.depth = m_nodes.at(node).depth + 1;
+            m_nodes.append(n);
+            m_nodes[node].next.insert(word, next);
+        }
+        node = next;
+    }
+    m_nodes[node].phrases.append(qMakePair(m_count++, phrase));
+    m_linksValid = false;
+}
+
+void PhraseMatcher::buildLinks() const
+{
+    // Breadth first, so the fail target of each node is done before it
+    QVector<int> queue;
+    queue.append(0);
+    for (int q = 0; q < queue.size(); ++q) {
+        const int node = queue.at(q);
+        for (auto it = m_nodes.at(node).next.constBegin(), end = m_nodes.at(node).next.constEnd();
+             it != end; ++it) {
+            const int child = it.value();
+            int fail = 0;
+            if (node) {
+                int f = m_nodes.at(node).fail;
+                while (f && !m_nodes.at(f).next.contains(it.key()))
+                    f = m_nodes.at(f).fail;
+                fail = m_nodes.at(f).next.value(it.key(), 0);
+            }
+            Node &n = m_nodes[child];
+            n.fail = fail;
+            n.output = n.phrases.isEmpty() ? m_nodes.at(fail).output : child;
+            queue.append(child);
+        }
+    }
+    m_linksValid = true;
+}
+
+// Returns the phrases ordered by where they start in the text, each once
+QList<Phrase *> PhraseMatcher::match(const QString &text) const
+{
+    QList<Phrase *> phrases;
+    if (isEmpty() || text.isEmpty())
+        return phrases;
+    if (!m_linksValid)
+        buildLinks();
+
+    struct Hit {
+        int start;
+        int order;
+        Phrase *phrase;
+        bool operator<(const Hit &other) const
+            { return start < other.start || (start == other.start && order < other.order); }
+    };
+    QVector<Hit> hits;
+    const QStringList words = text.split(QLatin1Char(' '));
+    int node = 0;
+    for (int i = 0; i < words.size(); ++i) {
+        const QString &word = words.at(i);
+        while (node && !m_nodes.at(node).next.contains(word))
+            node = m_nodes.at(node).fail;
+        node = m_nodes.at(node).next.value(word, 0);
+        for (int o = m_nodes.at(node).output; o >= 0; o = m_nodes.at(m_nodes.at(o).fail).output) {
+            const Node &n = m_nodes.at(o);
+            for (const QPair<int, Phrase *> &p : n.phrases) {
+                Hit hit = { i - n.depth + 1, p.first, p.second };
+                hits.append(hit);
+            }
+        }
+    }
+
+    std::sort(hits.begin(), hits.end());
+    QSet<Phrase *> seen;
+    for (const Hit &hit : qAsConst(hits)) {
+        if (!seen.contains(hit.phrase)) {
+            seen.insert(hit.phrase);
+            phrases.append(hit.phrase);
+        }
+    }
+    return phrases;
+}
+
 QT_END_NAMESPACE
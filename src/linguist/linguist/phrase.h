@@ -29,9 +29,11 @@
 #ifndef PHRASE_H
 #define PHRASE_H
 
+#include <QHash>
 #include <QObject>
 #include <QString>
 #include <QList>
+#include <QVector>
 #include <QtCore/QLocale>
 
 #include "simtexth.h"
@@ -124,6 +126,38 @@ private:
     friend class Phrase;
 };
 
+// Finds all phrases occurring in a text in one pass over its words, using
+// an Aho-Corasick automaton over the words of the phrases. Both phrases and
+// texts are expected to be passed through MainWindow::friendlyString(), so
+// words are separated by single spaces.
+class PhraseMatcher
+{
+public:
+    PhraseMatcher();
+
+    void clear();
+    bool isEmpty() const { return m_nodes.size() == 1; }
+    // Phrases matching at the same position come out in the order of adding
+    void add(const QString &source, Phrase *phrase);
+    QList<Phrase *> match(const QString &text) const;
+
+private:
+    struct Node {
+        Node() : fail(0), output(-1), depth(0) {}
+        QHash<QString, int> next;
+        QVector<QPair<int, Phrase *> > phrases; // order of adding, phrase
+        int fail;
+        int output; // nearest node on the fail chain with phrases, or -1
+        int depth;
+    };
+
+    void buildLinks() const;
+
+    mutable QVector<Node> m_nodes;
+    mutable bool m_linksValid;
+    int m_count;
+};
+
 QT_END_NAMESPACE
 
 #endif
@@ -49,7 +49,7 @@ static QString phraseViewHeaderKey()
     return settingPath("PhraseViewHeader");
 }
 
-PhraseView::PhraseView(MultiDataModel *model, QList<QHash<QString, QList<Phrase *> > > *phraseDict, QWidget *parent)
+PhraseView::PhraseView(MultiDataModel *model, QList<PhraseMatcher> *phraseDict, QWidget *parent)
     : QTreeView(parent),
       m_dataModel(model),
       m_phraseDict(phraseDict),
@@ -75,6 +75,9 @@ PhraseView::PhraseView(MultiDataModel *model, QList<QHash<QString, QList<Phrase
     header()->restoreState(QSettings().value(phraseViewHeaderKey()).toByteArray());
 
     connect(this, SIGNAL(activated(QModelIndex)), this, SLOT(selectPhrase(QModelIndex)));
+    connect(m_dataModel, SIGNAL(modelAppended()), this, SLOT(invalidateSimilarTextIndex()));
+    connect(m_dataModel, SIGNAL(modelDeleted(int)), this, SLOT(invalidateSimilarTextIndex()));
+    connect(m_dataModel, SIGNAL(allModelsDeleted()), this, SLOT(invalidateSimilarTextIndex()));
 }
 
 PhraseView::~PhraseView()
@@ -187,18 +190,34 @@ void PhraseView::resetNumGuesses()
     setSourceText(m_modelIndex, m_sourceText);
 }
 
-static CandidateList similarTextHeuristicCandidates(MultiDataModel *model, int mi,
-    const char *text, int maxCandidates)
+void PhraseView::invalidateSimilarTextIndex()
+{
+    m_similarTextModel = -1;
+    m_similarTextIndex.clear();
+    m_similarTextItems.clear();
+}
+
+CandidateList PhraseView::similarTextHeuristicCandidates(int mi, const char *text, int maxCandidates)
 {
     QList<int> scores;
     CandidateList candidates;
 
-    StringSimilarityMatcher stringmatcher(QString::fromLatin1(text));
+    // Source texts do not change, so only the set of messages can invalidate the index.
+    if (m_similarTextModel != mi) {
+        invalidateSimilarTextIndex();
+        m_similarTextModel = mi;
+        for (MultiDataModelIterator it(m_dataModel, mi); it.isValid(); ++it) {
+            if (MessageItem *m = it.current()) {
+                m_similarTextItems << it;
+                m_similarTextIndex.addText(m->text());
+            }
+        }
+    }
 
-    for (MultiDataModelIterator it(model, mi); it.isValid(); ++it) {
-        MessageItem *m = it.current();
-        if (!m)
-            continue;
+    // Whether a message is translated can change any time, so check it only now.
+    foreach (const SimilarTextIndex::Match &match,
+             m_similarTextIndex.findSimilar(QString::fromLatin1(text))) {
+        MessageItem *m = m_dataModel->messageItem(m_similarTextItems.at(match.entry));
 
         TranslatorMessage mtm = m->message();
         if (mtm.type() == TranslatorMessage::Unfinished
@@ -207,7 +226,7 @@ static CandidateList similarTextHeuristicCandidates(MultiDataModel *model, int m
 
         QString s = m->text();
 
-        int score = stringmatcher.getSimilarityScore(s);
+        int score = match.score;
 
         if (candidates.count() == maxCandidates && score > scores[maxCandidates - 1])
             candidates.removeLast();
@@ -249,7 +268,7 @@ void PhraseView::setSourceText(int model, const QString &sourceText)
         m_phraseModel->addPhrase(p);
 
     if (!sourceText.isEmpty() && m_doGuesses) {
-        CandidateList cl = similarTextHeuristicCandidates(m_dataModel, model,
+        CandidateList cl = similarTextHeuristicCandidates(model,
             sourceText.toLatin1(), m_maxCandidates);
         int n = 0;
         foreach (const Candidate &candidate, cl) {
@@ -270,19 +289,7 @@ void PhraseView::setSourceText(int model, const QString &sourceText)
 
 QList<Phrase *> PhraseView::getPhrases(int model, const QString &source)
 {
-    QList<Phrase *> phrases;
-    QString f = MainWindow::friendlyString(source);
-    QStringList lookupWords = f.split(QLatin1Char(' '));
-
-    foreach (const QString &s, lookupWords) {
-        if (m_phraseDict->at(model).contains(s)) {
-            foreach (Phrase *p, m_phraseDict->at(model).value(s)) {
-                if (f.contains(MainWindow::friendlyString(p->source())))
-                    phrases.append(p);
-            }
-        }
-    }
-    return phrases;
+    return m_phraseDict->at(model).match(MainWindow::friendlyString(source));
 }
 
 void PhraseView::deleteGuesses()
@@ -32,13 +32,14 @@
 #include <QList>
 #include <QShortcut>
 #include <QTreeView>
+#include <QVector>
+#include "messagemodel.h"
 #include "phrase.h"
 
 QT_BEGIN_NAMESPACE
 
 static const int DefaultMaxCandidates = 5;
 
-class MultiDataModel;
 class PhraseModel;
 
 class GuessShortcut : public QShortcut
@@ -69,7 +70,7 @@ class PhraseView : public QTreeView
     Q_OBJECT
 
 public:
-    PhraseView(MultiDataModel *model, QList<QHash<QString, QList<Phrase *> > > *phraseDict, QWidget *parent = 0);
+    PhraseView(MultiDataModel *model, QList<PhraseMatcher> *phraseDict, QWidget *parent = 0);
     ~PhraseView();
     void setSourceText(int model, const QString &sourceText);
 
@@ -100,19 +101,26 @@ private slots:
     void moreGuesses();
     void fewerGuesses();
     void resetNumGuesses();
+    void invalidateSimilarTextIndex();
 
 private:
     QList<Phrase *> getPhrases(int model, const QString &sourceText);
+    CandidateList similarTextHeuristicCandidates(int model, const char *text, int maxCandidates);
     void deleteGuesses();
 
     MultiDataModel *m_dataModel;
-    QList<QHash<QString, QList<Phrase *> > > *m_phraseDict;
+    QList<PhraseMatcher> *m_phraseDict;
     QList<Phrase *> m_guesses;
     PhraseModel *m_phraseModel;
     QString m_sourceText;
     int m_modelIndex;
     bool m_doGuesses;
     int m_maxCandidates = DefaultMaxCandidates;
+
+    // The source texts of m_similarTextModel, to look for guesses.
+    SimilarTextIndex m_similarTextIndex;
+    QVector<MultiDataIndex> m_similarTextItems;
+    int m_similarTextModel = -1;
 };
 
 QT_END_NAMESPACE
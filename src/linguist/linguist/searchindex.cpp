@@ -0,0 +1,130 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "searchindex.h"
+
+#include "messagemodel.h"
+
+#include <algorithm>
+#include <iterator>
+
+QT_BEGIN_NAMESPACE
+
+static quint64 trigram(const QChar *p)
+{
+    return (quint64(p[0].unicode()) << 32) | (quint64(p[1].unicode()) << 16) | p[2].unicode();
+}
+
+QString SearchIndex::normalized(const QString &text)
+{
+    QString str = text;
+    str.remove(QLatin1Char('&'));
+    return str.toCaseFolded();
+}
+
+SearchIndex::Entry SearchIndex::entry(const MessageItem *item)
+{
+    Entry entry;
+    entry.item = item;
+    entry.texts[SourceText] = item->text() + QLatin1Char('\n') + item->pluralText();
+    entry.texts[Comments] = item->comment() + QLatin1Char('\n') + item->extraComment()
+                            + QLatin1Char('\n') + item->translatorComment();
+    entry.texts[Translations] = item->translations().join(QLatin1Char('\n'));
+    return entry;
+}
+
+void SearchIndex::build(const QVector<Entry> &entries)
+{
+    m_items.clear();
+    m_items.reserve(entries.size());
+    for (int i = 0; i < entries.size(); ++i) {
+        const Entry &entry = entries.at(i);
+        m_items.append(entry.item);
+        for (int loc = 0; loc < LocationCount; ++loc) {
+            const QString text = normalized(entry.texts[loc]);
+            const QChar *p = text.constData();
+            for (int j = 0; j + 3 <= text.length(); ++j) {
+                QVector<int> &posting = m_postings[loc][trigram(p + j)];
+                // Entries are added in order, so each list stays sorted
+                if (posting.isEmpty() || posting.last() != i)
+                    posting.append(i);
+            }
+        }
+    }
+    m_ready.storeRelease(1);
+}
+
+bool SearchIndex::candidates(const QString &text, int where,
+                             QSet<const MessageItem *> *result) const
+{
+    const QString query = normalized(text);
+    if (query.length() < 3)
+        return false;
+
+    static const int locationFlags[LocationCount] = {
+        DataModel::SourceText, DataModel::Comments, DataModel::Translations
+    };
+
+    result->clear();
+    for (int loc = 0; loc < LocationCount; ++loc) {
+        if (!(where & locationFlags[loc]))
+            continue;
+
+        // Intersect the posting lists, the shortest first
+        QVector<const QVector<int> *> lists;
+        bool missing = false;
+        const QChar *p = query.constData();
+        for (int j = 0; j + 3 <= query.length(); ++j) {
+            Postings::ConstIterator it = m_postings[loc].constFind(trigram(p + j));
+            if (it == m_postings[loc].constEnd()) {
+                missing = true;
+                break;
+            }
+            lists.append(&*it);
+        }
+        if (missing)
+            continue;
+        std::sort(lists.begin(), lists.end(),
+                  [](const QVector<int> *l1, const QVector<int> *l2) {
+                      return l1->size() < l2->size();
+                  });
+        QVector<int> hits = *lists.first();
+        for (int k = 1; k < lists.size() && !hits.isEmpty(); ++k) {
+            QVector<int> both;
+            std::set_intersection(hits.constBegin(), hits.constEnd(),
+                                  lists.at(k)->constBegin(), lists.at(k)->constEnd(),
+                                  std::back_inserter(both));
+            hits.swap(both);
+        }
+        foreach (int id, hits)
+            result->insert(m_items.at(id));
+    }
+    return true;
+}
+
+QT_END_NAMESPACE
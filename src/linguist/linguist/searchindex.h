@@ -0,0 +1,80 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QAtomicInt>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class MessageItem;
+
+// A trigram index over the searchable texts of one catalogue. It answers
+// which messages may contain a string, so that find only has to look at
+// those. The texts are case folded and stripped of accelerator markers,
+// which keeps the candidates a superset of the actual matches for every
+// combination of find options except regular expressions.
+class SearchIndex
+{
+public:
+    enum Location { SourceText, Comments, Translations, LocationCount };
+
+    struct Entry {
+        const MessageItem *item;
+        QString texts[LocationCount];
+    };
+
+    SearchIndex() : m_ready(0) {}
+
+    // Takes a snapshot of the texts; the index is built from it in any thread
+    static Entry entry(const MessageItem *item);
+    void build(const QVector<Entry> &entries);
+    bool isReady() const { return m_ready.loadAcquire(); }
+
+    // Returns false if the index cannot narrow down the search for this text
+    bool candidates(const QString &text, int where /* DataModel::FindLocation */,
+                    QSet<const MessageItem *> *result) const;
+
+    static QString normalized(const QString &text);
+
+private:
+    typedef QHash<quint64, QVector<int> > Postings;
+
+    QVector<const MessageItem *> m_items;
+    Postings m_postings[LocationCount];
+    QAtomicInt m_ready;
+};
+
+QT_END_NAMESPACE
+
+#endif // SEARCHINDEX_H
@@ -0,0 +1,490 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "validator.h"
+
+#include "mainwindow.h"
+#include "messagemodel.h"
+
+#include <QRunnable>
+
+#include <ctype.h>
+
+QT_BEGIN_NAMESPACE
+
+// Messages are handed to the worker threads in chunks of this size
+static const int ChunkSize = 256;
+// The cache is dropped rather than grown beyond this many entries
+static const int MaxCacheSize = 500000;
+
+enum Ending {
+    End_None,
+    End_FullStop,
+    End_Interrobang,
+    End_Colon,
+    End_Ellipsis
+};
+
+static QString leadingWhitespace(const QString &str)
+{
+    int i = 0;
+    for (; i < str.size(); i++) {
+        if (!str[i].isSpace()) {
+            break;
+        }
+    }
+    return str.left(i);
+}
+
+static QString trailingWhitespace(const QString &str)
+{
+    int i = str.size();
+    while (--i >= 0) {
+        if (!str[i].isSpace()) {
+            break;
+        }
+    }
+    return str.mid(i + 1);
+}
+
+static Ending ending(QString str, QLocale::Language lang)
+{
+    str = str.simplified();
+    if (str.isEmpty())
+        return End_None;
+
+    switch (str.at(str.length() - 1).unicode()) {
+    case 0x002e: // full stop
+        if (str.endsWith(QLatin1String("...")))
+            return End_Ellipsis;
+        else
+            return End_FullStop;
+    case 0x0589: // armenian full stop
+    case 0x06d4: // arabic full stop
+    case 0x3002: // ideographic full stop
+        return End_FullStop;
+    case 0x0021: // exclamation mark
+    case 0x003f: // question mark
+    case 0x00a1: // inverted exclamation mark
+    case 0x00bf: // inverted question mark
+    case 0x01c3: // latin letter retroflex click
+    case 0x037e: // greek question mark
+    case 0x061f: // arabic question mark
+    case 0x203c: // double exclamation mark
+    case 0x203d: // interrobang
+    case 0x2048: // question exclamation mark
+    case 0x2049: // exclamation question mark
+    case 0x2762: // heavy exclamation mark ornament
+    case 0xff01: // full width exclamation mark
+    case 0xff1f: // full width question mark
+        return End_Interrobang;
+    case 0x003b: // greek 'compatibility' questionmark
+        return lang == QLocale::Greek ? End_Interrobang : End_None;
+    case 0x003a: // colon
+    case 0xff1a: // full width colon
+        return End_Colon;
+    case 0x2026: // horizontal ellipsis
+        return End_Ellipsis;
+    default:
+        return End_None;
+    }
+}
+
+static bool haveMnemonic(const QString &str)
+{
+    for (const ushort *p = (ushort *)str.constData();; ) { // Assume null-termination
+        ushort c = *p++;
+        if (!c)
+            break;
+        if (c == '&') {
+            c = *p++;
+            if (!c)
+                return false;
+            // "Nobody" ever really uses these alt-space, and they are highly annoying
+            // because we get a lot of false positives.
+            if (c != '&' && c != ' ' && QChar(c).isPrint()) {
+                const ushort *pp = p;
+                for (; *p < 256 && isalpha(*p); p++) ;
+                if (pp == p || *p != ';')
+                    return true;
+                // This looks like a HTML &entity;, so ignore it. As a HTML string
+                // won't contain accels anyway, we can stop scanning here.
+                break;
+            }
+        }
+    }
+    return false;
+}
+
+static bool checkMessage(Validator::Checks checks, int model, const Validator::ModelData &md,
+                         const Validator::Message &msg, QList<Validator::Error> *errors)
+{
+    bool danger = false;
+    const QString &source = msg.source;
+    const QStringList &translations = msg.translations;
+
+    auto addError = [&](ErrorsView::ErrorType type, const QString &arg) {
+        if (errors) {
+            Validator::Error error = { model, type, arg };
+            errors->append(error);
+        }
+        danger = true;
+    };
+
+    if (checks & Validator::Accelerators) {
+        bool sk = haveMnemonic(source);
+        bool tk = true;
+        for (int i = 0; i < translations.count() && tk; ++i) {
+            tk &= haveMnemonic(translations[i]);
+        }
+
+        if (!sk && tk)
+            addError(ErrorsView::SuperfluousAccelerator, QString());
+        else if (sk && !tk)
+            addError(ErrorsView::MissingAccelerator, QString());
+    }
+    if (checks & Validator::SurroundingWhitespace) {
+        bool whitespaceok = true;
+        for (int i = 0; i < translations.count() && whitespaceok; ++i) {
+            whitespaceok &= (leadingWhitespace(source) == leadingWhitespace(translations[i]));
+            whitespaceok &= (trailingWhitespace(source) == trailingWhitespace(translations[i]));
+        }
+
+        if (!whitespaceok)
+            addError(ErrorsView::SurroundingWhitespaceDiffers, QString());
+    }
+    if (checks & Validator::EndingPunctuation) {
+        bool endingok = true;
+        for (int i = 0; i < translations.count() && endingok; ++i) {
+            endingok &= (ending(source, md.sourceLanguage) ==
+                        ending(translations[i], md.language));
+        }
+
+        if (!endingok)
+            addError(ErrorsView::PunctuationDiffers, QString());
+    }
+    if (checks & Validator::PhraseMatches) {
+        QString fsource = MainWindow::friendlyString(source);
+        QString ftranslation = MainWindow::friendlyString(translations.first());
+        QStringList lookupWords = fsource.split(QLatin1Char(' '));
+
+        bool phraseFound;
+        foreach (const QString &s, lookupWords) {
+            Validator::PhraseTable::ConstIterator it = md.phrases.constFind(s);
+            if (it != md.phrases.constEnd()) {
+                phraseFound = true;
+                for (const QPair<QString, QString> &phrase : *it) {
+                    if (fsource == phrase.first) {
+                        if (ftranslation.indexOf(phrase.second) >= 0) {
+                            phraseFound = true;
+                            break;
+                        } else {
+                            phraseFound = false;
+                        }
+                    }
+                }
+                if (!phraseFound)
+                    addError(ErrorsView::IgnoredPhrasebook, s);
+            }
+        }
+    }
+
+    if (checks & Validator::PlaceMarkers) {
+        // Stores the occurrence count of the place markers in the map placeMarkerIndexes.
+        // i.e. the occurrence count of %1 is stored at placeMarkerIndexes[1],
+        // count of %2 is stored at placeMarkerIndexes[2] etc.
+        // In the first pass, it counts all place markers in the sourcetext.
+        // In the second pass it (de)counts all place markers in the translation.
+        // When finished, all elements should have returned to a count of 0,
+        // if not there is a mismatch
+        // between place markers in the source text and the translation text.
+        QHash<int, int> placeMarkerIndexes;
+        QString translation;
+        int numTranslations = translations.count();
+        for (int pass = 0; pass < numTranslations + 1; ++pass) {
+            const QChar *uc_begin = source.unicode();
+            const QChar *uc_end = uc_begin + source.length();
+            if (pass >= 1) {
+                translation = translations[pass - 1];
+                uc_begin = translation.unicode();
+                uc_end = uc_begin + translation.length();
+            }
+            const QChar *c = uc_begin;
+            while (c < uc_end) {
+                if (c->unicode() == '%') {
+                    const QChar *escape_start = ++c;
+                    while (c->isDigit())
+                        ++c;
+                    const QChar *escape_end = c;
+                    bool ok = true;
+                    int markerIndex = QString::fromRawData(
+                            escape_start, escape_end - escape_start).toInt(&ok);
+                    if (ok)
+                        placeMarkerIndexes[markerIndex] += (pass == 0 ? numTranslations : -1);
+                }
+                ++c;
+            }
+        }
+
+        foreach (int i, placeMarkerIndexes) {
+            if (i != 0) {
+                addError(ErrorsView::PlaceMarkersDiffer, QString());
+                break;
+            }
+        }
+
+        // Piggy-backed on the general place markers, we check the plural count marker.
+        if (msg.isPlural) {
+            for (int i = 0; i < numTranslations; ++i)
+                if (md.countRefNeeds.at(i)
+                    && !(translations[i].contains(QLatin1String("%n"))
+                    || translations[i].contains(QLatin1String("%Ln")))) {
+                    addError(ErrorsView::NumerusMarkerMissing, QString());
+                    break;
+                }
+        }
+    }
+
+    return danger;
+}
+
+// The translations as the checks see them
+static QStringList checkedTranslations(const MessageItem *m)
+{
+    QStringList translations = m->translations();
+
+    // Truncated variants are permitted to be "denormalized"
+    for (int i = 0; i < translations.count(); ++i) {
+        int sep = translations.at(i).indexOf(QChar(Translator::BinaryVariantSeparator));
+        if (sep >= 0)
+            translations[i].truncate(sep);
+    }
+    return translations;
+}
+
+// All models share the source text of the first translated one
+static Validator::Message toMessage(const MessageItem *m, QString *source)
+{
+    if (source->isEmpty()) {
+        *source = m->pluralText();
+        if (source->isEmpty())
+            *source = m->text();
+    }
+    Validator::Message msg;
+    msg.source = *source;
+    msg.translations = checkedTranslations(m);
+    msg.isPlural = m->message().isPlural();
+    return msg;
+}
+
+bool operator==(const Validator::Key &k1, const Validator::Key &k2)
+{
+    return k1.model == k2.model && k1.checks == k2.checks
+        && k1.msg.isPlural == k2.msg.isPlural && k1.msg.source == k2.msg.source
+        && k1.msg.translations == k2.msg.translations;
+}
+
+uint qHash(const Validator::Key &key)
+{
+    uint h = qHash(key.msg.source) ^ uint(key.model << 8) ^ uint(key.checks);
+    foreach (const QString &translation, key.msg.translations)
+        h = 31 * h + qHash(translation);
+    return h;
+}
+
+Validator::Validator(MultiDataModel *dataModel, QObject *parent)
+    : QObject(parent),
+      m_dataModel(dataModel),
+      m_generation(0)
+{
+}
+
+Validator::~Validator()
+{
+    m_pool.clear();
+    m_pool.waitForDone();
+}
+
+void Validator::invalidate()
+{
+    // Results of jobs already running are dropped when they arrive
+    ++m_generation;
+    m_pool.clear();
+}
+
+void Validator::appendModel()
+{
+    invalidate();
+    m_phrases.append(PhraseTable());
+}
+
+void Validator::removeModel(int model)
+{
+    invalidate();
+    m_phrases.removeAt(model);
+    m_cache.clear();
+}
+
+void Validator::removeAllModels()
+{
+    invalidate();
+    m_phrases.clear();
+    m_cache.clear();
+}
+
+void Validator::setPhrases(int model, const PhraseTable &phrases)
+{
+    invalidate();
+    m_phrases[model] = phrases;
+    // Also called when the language changes, which affects the other checks, too
+    m_cache.clear();
+}
+
+QVector<Validator::ModelData> Validator::modelData() const
+{
+    QVector<ModelData> models(m_dataModel->modelCount());
+    for (int mi = 0; mi < models.size(); ++mi) {
+        if (!m_dataModel->isModelWritable(mi))
+            continue;
+        ModelData &md = models[mi];
+        md.sourceLanguage = m_dataModel->sourceLanguage(mi);
+        md.language = m_dataModel->language(mi);
+        md.countRefNeeds = m_dataModel->model(mi)->countRefNeeds();
+        md.phrases = m_phrases.value(mi);
+    }
+    return models;
+}
+
+void Validator::validate(const MultiDataIndex &index, QList<Error> *errors)
+{
+    const QVector<ModelData> models = modelData();
+    MultiDataIndex curIdx = index;
+    QString source;
+    for (int mi = 0; mi < m_dataModel->modelCount(); ++mi) {
+        if (!m_dataModel->isModelWritable(mi))
+            continue;
+        curIdx.setModel(mi);
+        MessageItem *m = m_dataModel->messageItem(curIdx);
+        if (!m || m->isObsolete())
+            continue;
+
+        bool danger = false;
+        if (m->message().isTranslated()) {
+            Key key = { mi, int(m_checks), toMessage(m, &source) };
+            danger = checkMessage(m_checks, mi, models.at(mi), key.msg, errors);
+            if (m_cache.size() >= MaxCacheSize)
+                m_cache.clear();
+            m_cache.insert(key, danger);
+        }
+
+        if (danger != m->danger())
+            m_dataModel->setDanger(curIdx, danger);
+    }
+}
+
+void Validator::validateAll()
+{
+    invalidate();
+
+    const QVector<ModelData> models = modelData();
+    const Checks checks = m_checks;
+    const int generation = m_generation;
+    auto startJobs = [this, &models, checks, generation](const QVector<Job> &jobs) {
+        m_pool.start(QRunnable::create([this, models, checks, generation, jobs]() {
+            QVector<bool> dangers;
+            dangers.reserve(jobs.size());
+            for (const Job &job : jobs)
+                dangers.append(checkMessage(checks, job.model, models.at(job.model), job.msg, 0));
+            QMetaObject::invokeMethod(this, [this, generation, checks, jobs, dangers]() {
+                applyResults(generation, checks, jobs, dangers);
+            }, Qt::QueuedConnection);
+        }));
+    };
+
+    QVector<Job> jobs;
+    for (MultiDataModelIterator it(m_dataModel, -1); it.isValid(); ++it) {
+        MultiDataIndex curIdx = it;
+        QString source;
+        for (int mi = 0; mi < m_dataModel->modelCount(); ++mi) {
+            if (!m_dataModel->isModelWritable(mi))
+                continue;
+            curIdx.setModel(mi);
+            MessageItem *m = m_dataModel->messageItem(curIdx);
+            if (!m || m->isObsolete())
+                continue;
+
+            bool danger = false;
+            if (m->message().isTranslated()) {
+                Key key = { mi, int(checks), toMessage(m, &source) };
+                QHash<Key, bool>::ConstIterator cit = m_cache.constFind(key);
+                if (cit == m_cache.constEnd()) {
+                    Job job = { mi, curIdx.context(), curIdx.message(), key.msg };
+                    jobs.append(job);
+                    continue;
+                }
+                danger = *cit;
+            }
+
+            if (danger != m->danger())
+                m_dataModel->setDanger(curIdx, danger);
+        }
+        if (jobs.size() >= ChunkSize) {
+            startJobs(jobs);
+            jobs.clear();
+        }
+    }
+    if (!jobs.isEmpty())
+        startJobs(jobs);
+}
+
+void Validator::applyResults(int generation, Checks checks, const QVector<Job> &jobs,
+                             const QVector<bool> &dangers)
+{
+    if (generation != m_generation)
+        return;
+
+    if (m_cache.size() + jobs.size() > MaxCacheSize)
+        m_cache.clear();
+    for (int i = 0; i < jobs.size(); ++i) {
+        const Job &job = jobs.at(i);
+        const Key key = { job.model, int(checks), job.msg };
+        m_cache.insert(key, dangers.at(i));
+
+        MultiDataIndex index(job.model, job.context, job.message);
+        MessageItem *m = m_dataModel->messageItem(index);
+        // Messages edited in the meantime have been validated already
+        if (!m || m->isObsolete() || !m->message().isTranslated()
+            || checkedTranslations(m) != job.msg.translations) {
+            continue;
+        }
+        if (dangers.at(i) != m->danger())
+            m_dataModel->setDanger(index, dangers.at(i));
+    }
+}
+
+QT_END_NAMESPACE
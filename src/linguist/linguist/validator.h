@@ -0,0 +1,135 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef VALIDATOR_H
+#define VALIDATOR_H
+
+#include "errorsview.h"
+
+#include <QHash>
+#include <QList>
+#include <QLocale>
+#include <QObject>
+#include <QPair>
+#include <QStringList>
+#include <QThreadPool>
+#include <QVector>
+
+QT_BEGIN_NAMESPACE
+
+class MultiDataIndex;
+class MultiDataModel;
+
+// Checks translations for likely mistakes and flags the messages as dangerous.
+// Sweeps over all messages run in worker threads and report back in chunks.
+class Validator : public QObject
+{
+    Q_OBJECT
+public:
+    enum Check {
+        Accelerators = 0x1,
+        SurroundingWhitespace = 0x2,
+        EndingPunctuation = 0x4,
+        PhraseMatches = 0x8,
+        PlaceMarkers = 0x10
+    };
+    Q_DECLARE_FLAGS(Checks, Check)
+
+    struct Error {
+        int model;
+        ErrorsView::ErrorType type;
+        QString arg;
+    };
+
+    // Phrase book entries as the phrase check needs them: the friendly
+    // source and target, filed under the first word of the source
+    typedef QHash<QString, QVector<QPair<QString, QString> > > PhraseTable;
+
+    Validator(MultiDataModel *dataModel, QObject *parent = 0);
+    ~Validator();
+
+    void setChecks(Checks checks) { m_checks = checks; }
+    Checks checks() const { return m_checks; }
+
+    // Keep these in step with the models of the data model
+    void appendModel();
+    void removeModel(int model);
+    void removeAllModels();
+    void setPhrases(int model, const PhraseTable &phrases);
+
+    // Checks the message in all writable models right away
+    void validate(const MultiDataIndex &index, QList<Error> *errors = 0);
+    // Checks all messages in the background
+    void validateAll();
+
+    struct Message {
+        QString source;
+        QStringList translations;
+        bool isPlural;
+    };
+    struct ModelData {
+        QLocale::Language sourceLanguage;
+        QLocale::Language language;
+        QList<bool> countRefNeeds;
+        PhraseTable phrases;
+    };
+
+private:
+    struct Job {
+        int model;
+        int context;
+        int message;
+        Message msg;
+    };
+
+    struct Key {
+        int model;
+        int checks;
+        Message msg;
+    };
+    friend bool operator==(const Key &k1, const Key &k2);
+    friend uint qHash(const Key &key);
+
+    QVector<ModelData> modelData() const;
+    void applyResults(int generation, Checks checks, const QVector<Job> &jobs,
+                      const QVector<bool> &dangers);
+    void invalidate();
+
+    MultiDataModel *m_dataModel; // not owned
+    Checks m_checks;
+    QList<PhraseTable> m_phrases;
+    QHash<Key, bool> m_cache;
+    QThreadPool m_pool;
+    int m_generation;
+};
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(Validator::Checks)
+
+QT_END_NAMESPACE
+
+#endif // VALIDATOR_H
@@ -5,12 +5,15 @@ DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII
 
 include(../shared/proparser.pri)
 
-DEFINES += PROEVALUATOR_DEBUG
+DEFINES += PROEVALUATOR_DEBUG PROEVALUATOR_THREAD_SAFE PROPARSER_THREAD_SAFE
 
 HEADERS += \
+    ../shared/projectdescriptionreader.h \
+    ../shared/projectevaluator.h \
     ../shared/qrcreader.h
 
 SOURCES += \
+    ../shared/projectevaluator.cpp \
     ../shared/qrcreader.cpp \
     main.cpp
 
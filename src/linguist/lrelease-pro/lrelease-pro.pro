@@ -2,6 +2,8 @@ option(host_build)
 QT = core
 DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
 
+INCLUDEPATH += ../shared
+
 HEADERS += \
     ../shared/runqttool.h
 
@@ -9,8 +11,6 @@ SOURCES += \
     ../shared/runqttool.cpp \
     main.cpp
 
-INCLUDEPATH += ../shared
-
 qmake.name = QMAKE
 qmake.value = $$shell_path($$QMAKE_QMAKE)
 QT_TOOL_ENV += qmake
@@ -66,15 +66,22 @@ static void printUsage()
     printOut(LR::tr(
         "Usage:\n"
         "    lrelease-pro [options] [project-file]...\n"
-        "lrelease-pro is part of Qt's Linguist tool chain. It extracts project\n"
-        "information from qmake projects and passes it to lrelease.\n"
+        "lrelease-pro is part of Qt's Linguist tool chain. It passes qmake projects\n"
+        "to lrelease, which evaluates them and releases their TS files in one go.\n"
         "All command line options that are not consumed by lrelease-pro are\n"
         "passed to lrelease.\n\n"
         "Options:\n"
         "    -help  Display this information and exit\n"
-        "    -keep  Keep the temporary project dump around\n"
         "    -silent\n"
         "           Do not explain what is being done\n"
+        "    -threads <n>\n"
+        "           Evaluate up to n sub-projects concurrently and release up to n\n"
+        "           TS files at once. 0 means one per CPU core. The default is 1\n"
+        "    -cache-dir <directory>\n"
+        "           Keep the parsed qmake files in the given directory, so later\n"
+        "           runs need not parse them again\n"
+        "    -cache-system\n"
+        "           Run each $$system() command in the qmake files only once\n"
         "    -version\n"
         "           Display the version of lrelease-pro and exit\n"
     ));
@@ -97,18 +104,24 @@ int main(int argc, char **argv)
 #endif // Q_OS_WIN32
 #endif // QT_BOOTSTRAPPED
 
-    bool keepProjectDescription = false;
     QStringList inputFiles;
-    QStringList lprodumpOptions;
     QStringList lreleaseOptions;
 
     for (int i = 1; i < argc; ++i) {
         if (!strcmp(argv[i], "-keep")) {
-            keepProjectDescription = true;
-        } else if (!strcmp(argv[i], "-silent")) {
-            const QString arg = QString::fromLocal8Bit(argv[i]);
-            lprodumpOptions << arg;
-            lreleaseOptions << arg;
+            // There is no project dump to keep anymore.
+        } else if (!strcmp(argv[i], "-threads")) {
+            if (++i == argc) {
+                printErr(LR::tr("The -threads option should be followed by a number.\n"));
+                return 1;
+            }
+            lreleaseOptions << QStringLiteral("-threads") << QString::fromLocal8Bit(argv[i]);
+        } else if (!strcmp(argv[i], "-cache-dir")) {
+            if (++i == argc) {
+                printErr(LR::tr("The -cache-dir option should be followed by a directory name.\n"));
+                return 1;
+            }
+            lreleaseOptions << QStringLiteral("-cache-dir") << QString::fromLocal8Bit(argv[i]);
         } else if (!strcmp(argv[i], "-version")) {
             printOut(LR::tr("lrelease-pro version %1\n").arg(QLatin1String(QT_VERSION_STR)));
             return 0;
@@ -139,12 +152,6 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    lprodumpOptions << proFiles;
-    std::unique_ptr<QTemporaryFile> projectDescription = createProjectDescription(lprodumpOptions);
-    if (keepProjectDescription)
-        projectDescription->setAutoRemove(false);
-    lreleaseOptions << QStringLiteral("-project") << projectDescription->fileName();
-
-    runQtTool(QStringLiteral("lrelease"), lreleaseOptions);
+    runQtTool(QStringLiteral("lrelease"), lreleaseOptions + proFiles);
     return 0;
 }
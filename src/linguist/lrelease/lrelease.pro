@@ -2,13 +2,19 @@ option(host_build)
 QT = core-private
 DEFINES += QT_NO_CAST_FROM_ASCII QT_NO_CAST_TO_ASCII
 
+include(../shared/proparser.pri)
+
+DEFINES += PROEVALUATOR_THREAD_SAFE PROPARSER_THREAD_SAFE
+
 HEADERS += \
     ../shared/projectdescriptionreader.h \
-    ../shared/runqttool.h
+    ../shared/projectevaluator.h \
+    ../shared/qrcreader.h
 
 SOURCES += \
     ../shared/projectdescriptionreader.cpp \
-    ../shared/runqttool.cpp \
+    ../shared/projectevaluator.cpp \
+    ../shared/qrcreader.cpp \
     main.cpp
 
 include(../shared/formats.pri)
@@ -30,20 +30,28 @@
 
 #include <profileutils.h>
 #include <projectdescriptionreader.h>
-#include <runqttool.h>
+#include <projectevaluator.h>
 
 #ifndef QT_BOOTSTRAPPED
 #include <QtCore/QCoreApplication>
 #include <QtCore/QTranslator>
 #endif
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
 #include <QtCore/QDebug>
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
 #include <QtCore/QRegExp>
+#include <QtCore/QRunnable>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
 #include <QtCore/QLibraryInfo>
 
 QT_USE_NAMESPACE
@@ -61,14 +69,19 @@ class LR {
 };
 #endif
 
+// TS files may be released on several threads at once.
+static QMutex printMutex;
+
 static void printOut(const QString & out)
 {
+    QMutexLocker locker(&printMutex);
     QTextStream stream(stdout);
     stream << out;
 }
 
 static void printErr(const QString & out)
 {
+    QMutexLocker locker(&printMutex);
     QTextStream stream(stderr);
     stream << out;
 }
@@ -89,6 +102,9 @@ static void printUsage()
         "    -help  Display this information and exit\n"
         "    -idbased\n"
         "           Use IDs instead of source strings for message keying\n"
+        "    -incremental\n"
+        "           Skip QM files that are newer than their TS files and were\n"
+        "           generated with the same options\n"
         "    -compress\n"
         "           Compress the QM files\n"
         "    -nounfinished\n"
@@ -104,6 +120,15 @@ static void printUsage()
         "           Such a file may be generated from a .pro file using the lprodump tool.\n"
         "    -silent\n"
         "           Do not explain what is being done\n"
+        "    -threads <count>\n"
+        "           Release the TS files using the given number of threads, and\n"
+        "           evaluate the sub-projects of .pro files concurrently.\n"
+        "           0 means one thread per CPU core. Default: 1\n"
+        "    -cache-dir <directory>\n"
+        "           Keep the parsed .pro files in the given directory, so later\n"
+        "           runs need not parse them again\n"
+        "    -cache-system\n"
+        "           Run each $$system() command in the .pro files only once\n"
         "    -version\n"
         "           Display the version of lrelease and exit\n"
     ));
@@ -157,13 +182,47 @@ static bool releaseTranslator(Translator &tor, const QString &qmFileName,
     return ok;
 }
 
-static bool releaseTsFile(const QString& tsFileName,
+static QByteArray releaseStamp(const QStringList &tsFileNames,
+    const ConversionData &cd, bool removeIdentical)
+{
+    QByteArray options;
+    QDataStream stream(&options, QIODevice::WriteOnly);
+    stream << QString::fromLatin1(QT_VERSION_STR) << qint32(cd.m_saveMode) << cd.m_idBased
+           << cd.m_ignoreUnfinished << cd.m_unTrPrefix << removeIdentical;
+    foreach (const QString &tsFileName, tsFileNames)
+        stream << QFileInfo(tsFileName).absoluteFilePath();
+    return QCryptographicHash::hash(options, QCryptographicHash::Sha1);
+}
+
+static bool isUpToDate(const QString &qmFileName, const QStringList &tsFileNames,
+    const QByteArray &stamp)
+{
+    const QFileInfo qmInfo(qmFileName);
+    if (!qmInfo.isFile())
+        return false;
+    const QDateTime qmTime = qmInfo.lastModified();
+    foreach (const QString &tsFileName, tsFileNames) {
+        if (!(QFileInfo(tsFileName).lastModified() < qmTime))
+            return false;
+    }
+    QFile file(qmFileName);
+    return file.open(QIODevice::ReadOnly) && readQMReleaseStamp(file) == stamp;
+}
+
+static bool skipUpToDate(const QString &qmFileName, const QStringList &tsFileNames,
     ConversionData &cd, bool removeIdentical)
 {
-    Translator tor;
-    if (!loadTsFile(tor, tsFileName, cd.isVerbose()))
+    cd.m_releaseStamp = releaseStamp(tsFileNames, cd, removeIdentical);
+    if (!isUpToDate(qmFileName, tsFileNames, cd.m_releaseStamp))
         return false;
+    if (cd.isVerbose())
+        printOut(LR::tr("'%1' is up to date.\n").arg(qmFileName));
+    return true;
+}
 
+static bool releaseTsFile(const QString& tsFileName,
+    ConversionData &cd, bool removeIdentical, bool incremental)
+{
     QString qmFileName = tsFileName;
     foreach (const Translator::FileFormat &fmt, Translator::registeredFileFormats()) {
         if (qmFileName.endsWith(QLatin1Char('.') + fmt.extension)) {
@@ -173,9 +232,44 @@ static bool releaseTsFile(const QString& tsFileName,
     }
     qmFileName += QLatin1String(".qm");
 
+    if (incremental && skipUpToDate(qmFileName, QStringList(tsFileName), cd, removeIdentical))
+        return true;
+
+    Translator tor;
+    if (!loadTsFile(tor, tsFileName, cd.isVerbose()))
+        return false;
+
     return releaseTranslator(tor, qmFileName, cd, removeIdentical);
 }
 
+static bool releaseTsFiles(const QStringList &tsFileNames, const ConversionData &cd,
+    bool removeIdentical, bool incremental, int threadCount)
+{
+    if (threadCount <= 1 || tsFileNames.size() <= 1) {
+        ConversionData fileCd = cd;
+        foreach (const QString &tsFileName, tsFileNames) {
+            if (!releaseTsFile(tsFileName, fileCd, removeIdentical, incremental))
+                return false;
+        }
+        return true;
+    }
+
+    // The TS files are independent of each other. Unlike in the sequential
+    // case, a failure does not stop the files that are released already.
+    QThreadPool pool;
+    pool.setMaxThreadCount(threadCount);
+    QAtomicInt failed;
+    foreach (const QString &tsFileName, tsFileNames) {
+        pool.start(QRunnable::create([&, tsFileName] {
+            ConversionData fileCd = cd;
+            if (!releaseTsFile(tsFileName, fileCd, removeIdentical, incremental))
+                failed.storeRelaxed(1);
+        }));
+    }
+    pool.waitForDone();
+    return !failed.loadRelaxed();
+}
+
 static QStringList translationsFromProjects(const Projects &projects, bool topLevel);
 
 static QStringList translationsFromProject(const Project &project, bool topLevel)
@@ -219,10 +313,13 @@ int main(int argc, char **argv)
     ConversionData cd;
     cd.m_verbose = true; // the default is true starting with Qt 4.2
     bool removeIdentical = false;
+    bool incremental = false;
+    int threadCount = 1;
     Translator tor;
     QStringList inputFiles;
     QString outputFile;
     QString projectDescriptionFile;
+    QStringList projectOptions; // For evaluating .pro files
 
     for (int i = 1; i < argc; ++i) {
         if (!strcmp(argv[i], "-compress")) {
@@ -231,6 +328,31 @@ int main(int argc, char **argv)
         } else if (!strcmp(argv[i], "-idbased")) {
             cd.m_idBased = true;
             continue;
+        } else if (!strcmp(argv[i], "-incremental")) {
+            incremental = true;
+            continue;
+        } else if (!strcmp(argv[i], "-threads")) {
+            if (i == argc - 1) {
+                printErr(LR::tr("The option -threads requires a parameter.\n"));
+                return 1;
+            }
+            bool ok;
+            threadCount = QString::fromLocal8Bit(argv[++i]).toInt(&ok);
+            if (!ok || threadCount < 0) {
+                printErr(LR::tr("Invalid parameter passed to -threads.\n"));
+                return 1;
+            }
+            if (threadCount == 0)
+                threadCount = QThread::idealThreadCount();
+            projectOptions << QStringLiteral("-threads") << QString::number(threadCount);
+        } else if (!strcmp(argv[i], "-cache-dir")) {
+            if (i == argc - 1) {
+                printErr(LR::tr("The option -cache-dir requires a parameter.\n"));
+                return 1;
+            }
+            projectOptions << QStringLiteral("-cache-dir") << QString::fromLocal8Bit(argv[++i]);
+        } else if (!strcmp(argv[i], "-cache-system")) {
+            projectOptions << QStringLiteral("-cache-system");
         } else if (!strcmp(argv[i], "-nocompress")) {
             cd.m_saveMode = SaveEverything;
             continue;
@@ -258,6 +380,7 @@ int main(int argc, char **argv)
             projectDescriptionFile = QString::fromLocal8Bit(argv[++i]);
         } else if (!strcmp(argv[i], "-silent")) {
             cd.m_verbose = false;
+            projectOptions << QStringLiteral("-silent");
             continue;
         } else if (!strcmp(argv[i], "-verbose")) {
             cd.m_verbose = true;
@@ -288,12 +411,26 @@ int main(int argc, char **argv)
     }
 
     QString errorString;
-    if (!extractProFiles(&inputFiles).isEmpty()) {
-        runQtTool(QStringLiteral("lrelease-pro"), app.arguments().mid(1));
-        return 0;
-    }
-
-    if (!projectDescriptionFile.isEmpty()) {
+    const QStringList proFiles = extractProFiles(&inputFiles);
+    if (!proFiles.isEmpty()) {
+        if (!inputFiles.isEmpty() || !projectDescriptionFile.isEmpty()) {
+            printErr(LR::tr("lrelease error: Do not specify TS files or -project"
+                            " together with .pro files.\n"));
+            return 1;
+        }
+        // The projects are evaluated in this process; only their TRANSLATIONS are needed.
+        ProjectEvaluationOptions evaluationOptions;
+        if (!parseProjectArguments(projectOptions + proFiles, &evaluationOptions,
+                                   &errorString)) {
+            printErr(errorString);
+            return 1;
+        }
+        bool fail = false;
+        const Projects projects = evaluateProjects(evaluationOptions, &fail);
+        if (fail)
+            return 1;
+        inputFiles = translationsFromProjects(projects);
+    } else if (!projectDescriptionFile.isEmpty()) {
         if (!inputFiles.isEmpty()) {
             printErr(LR::tr("lrelease error: Do not specify TS files if -project is given.\n"));
             return 1;
@@ -306,18 +443,16 @@ int main(int argc, char **argv)
         inputFiles = translationsFromProjects(projectDescription);
     }
 
+    if (outputFile.isEmpty())
+        return releaseTsFiles(inputFiles, cd, removeIdentical, incremental, threadCount) ? 0 : 1;
+
+    if (incremental && skipUpToDate(outputFile, inputFiles, cd, removeIdentical))
+        return 0;
+
     foreach (const QString &inputFile, inputFiles) {
-        if (outputFile.isEmpty()) {
-            if (!releaseTsFile(inputFile, cd, removeIdentical))
-                return 1;
-        } else {
-            if (!loadTsFile(tor, inputFile, cd.isVerbose()))
-                return 1;
-        }
+        if (!loadTsFile(tor, inputFile, cd.isVerbose()))
+            return 1;
     }
 
-    if (!outputFile.isEmpty())
-        return releaseTranslator(tor, outputFile, cd, removeIdentical) ? 0 : 1;
-
-    return 0;
+    return releaseTranslator(tor, outputFile, cd, removeIdentical) ? 0 : 1;
 }
@@ -37,7 +37,6 @@
 #include <QtCore/qlibraryinfo.h>
 #include <QtCore/qstring.h>
 #include <QtCore/qstringlist.h>
-#include <QtCore/qtemporaryfile.h>
 #include <QtCore/qtranslator.h>
 
 #include <iostream>
@@ -61,8 +60,8 @@ static void printUsage()
     printOut(LU::tr(
         "Usage:\n"
         "    lupdate-pro [options] [project-file]... [-ts ts-files...]\n"
-        "lupdate-pro is part of Qt's Linguist tool chain. It extracts project\n"
-        "information from qmake projects and passes it to lupdate.\n"
+        "lupdate-pro is part of Qt's Linguist tool chain. It passes qmake projects\n"
+        "to lupdate, which evaluates them and extracts their messages in one go.\n"
         "All command line options that are not consumed by lupdate-pro are\n"
         "passed to lupdate.\n\n"
         "Options:\n"
@@ -76,6 +75,14 @@ static void printUsage()
         "           Virtual output directory for processing subsequent .pro files.\n"
         "    -pro-debug\n"
         "           Trace processing .pro files. Specify twice for more verbosity.\n"
+        "    -threads <n>\n"
+        "           Evaluate up to n sub-projects concurrently and parse the sources\n"
+        "           using n threads. 0 means one per CPU core. The default is 1.\n"
+        "    -cache-dir <directory>\n"
+        "           Keep the parsed qmake files and the extracted messages in the\n"
+        "           given directory.\n"
+        "    -cache-system\n"
+        "           Run each $$system() command in the qmake files only once.\n"
         "    -version\n"
         "           Display the version of lupdate-pro and exit.\n"
     ));
@@ -100,9 +107,7 @@ int main(int argc, char **argv)
 
     QStringList args = app.arguments();
     QStringList lupdateOptions;
-    QStringList lprodumpOptions;
     bool hasProFiles = false;
-    bool keepProjectDescription = false;
 
     for (int i = 1; i < args.size(); ++i) {
         QString arg = args.at(i);
@@ -112,12 +117,7 @@ int main(int argc, char **argv)
             printUsage();
             return 0;
         } else if (arg == QLatin1String("-keep")) {
-            keepProjectDescription = true;
-        } else if (arg == QLatin1String("-silent")) {
-            lupdateOptions << arg;
-            lprodumpOptions << arg;
-        } else if (arg == QLatin1String("-pro-debug")) {
-            lprodumpOptions << arg;
+            // There is no project dump to keep anymore.
         } else if (arg == QLatin1String("-version")) {
             printOut(LU::tr("lupdate-pro version %1\n").arg(QLatin1String(QT_VERSION_STR)));
             return 0;
@@ -127,19 +127,11 @@ int main(int argc, char **argv)
                 printErr(LU::tr("The -pro option should be followed by a filename of .pro file.\n"));
                 return 1;
             }
-            lprodumpOptions << arg << args[i];
-            hasProFiles = true;
-        } else if (arg == QLatin1String("-pro-out")) {
-            ++i;
-            if (i == argc) {
-                printErr(LU::tr("The -pro-out option should be followed by a directory name.\n"));
-                return 1;
-            }
-            lprodumpOptions << arg << args[i];
-        } else if (isProOrPriFile(arg)) {
-            lprodumpOptions << arg;
+            lupdateOptions << arg << args[i];
             hasProFiles = true;
         } else {
+            if (isProOrPriFile(arg))
+                hasProFiles = true;
             lupdateOptions << arg;
         }
     } // for args
@@ -149,11 +141,6 @@ int main(int argc, char **argv)
         return 1;
     }
 
-    std::unique_ptr<QTemporaryFile> projectDescription = createProjectDescription(lprodumpOptions);
-    if (keepProjectDescription)
-        projectDescription->setAutoRemove(false);
-    lupdateOptions << QStringLiteral("-project") << projectDescription->fileName();
-
     runQtTool(QStringLiteral("lupdate"), lupdateOptions);
     return 0;
 }
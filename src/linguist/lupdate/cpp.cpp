@@ -27,12 +27,20 @@
 ****************************************************************************/
 
 #include "cpp.h"
+#include "extractioncache.h"
 
 #include <translator.h>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QBitArray>
+#include <QtCore/QFile>
 #include <QtCore/QStack>
 #include <QtCore/QTextCodec>
 #include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <limits>
 
 QT_BEGIN_NAMESPACE
 
@@ -67,13 +75,13 @@ uint qHash(const HashStringList &list)
     return list.m_hash;
 }
 
-static int nextFileId;
+static QAtomicInt nextFileId;
 
 class VisitRecorder {
 public:
     VisitRecorder()
     {
-        m_ba.resize(nextFileId);
+        m_ba.resize(nextFileId.loadAcquire());
     }
     bool tryVisit(int fileId)
     {
@@ -86,16 +94,140 @@ private:
     QBitArray m_ba;
 };
 
+/*
+  Once a header's ParseResults are published through CppFiles, other parser
+  threads walk its namespaces. The few members which are still updated lazily
+  after that are guarded by these mutexes.
+*/
+
+static QRecursiveMutex &aliasMutex()
+{
+    static QRecursiveMutex mutex;
+    return mutex;
+}
+
+static QMutex &namespaceMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
+// Makes sure that hash values of the shared keys are not computed concurrently later on.
+static void primeHashes(const Namespace *ns)
+{
+    for (auto it = ns->children.cbegin(), end = ns->children.cend(); it != end; ++it) {
+        qHash(it.key());
+        primeHashes(it.value());
+    }
+    for (auto it = ns->aliases.cbegin(), end = ns->aliases.cend(); it != end; ++it) {
+        qHash(it.key());
+        for (const HashString &segment : it.value())
+            qHash(segment);
+    }
+    for (const HashStringList &use : ns->usings)
+        qHash(use);
+}
+
+// Returns true only for the first complaint about \a ns.
+static bool setComplained(Namespace *ns)
+{
+    QMutexLocker locker(&namespaceMutex());
+    if (ns->complained)
+        return false;
+    ns->complained = true;
+    return true;
+}
+
+// Returns the cached tr() context of \a ns, after setting it to \a qualification if unset.
+static QString cacheTrQualification(Namespace *ns, const QString &qualification)
+{
+    QMutexLocker locker(&namespaceMutex());
+    if (ns->trQualification.isEmpty())
+        ns->trQualification = qualification;
+    return ns->trQualification;
+}
+
+static QString trQualification(const Namespace *ns)
+{
+    QMutexLocker locker(&namespaceMutex());
+    return ns->trQualification;
+}
+
+/*
+  Resolving an include probes every include path in turn. Instead of stat()ing
+  each candidate, every directory is listed once and the candidates are looked
+  up in memory. Directories which do not exist are remembered as being empty.
+*/
+
+#if defined(Q_OS_WIN) || defined(Q_OS_DARWIN)
+static QString fileNameKey(const QString &name) { return name.toCaseFolded(); }
+#else
+static QString fileNameKey(const QString &name) { return name; }
+#endif
+
+bool CppFiles::isExistingFile(const QString &filePath)
+{
+    // The candidates come from QDir::absoluteFilePath(), so they always contain a slash.
+    const int slash = filePath.lastIndexOf(QLatin1Char('/'));
+    const QString dirPath = filePath.left(slash + 1);
+    const QString name = fileNameKey(filePath.mid(slash + 1));
+
+    {
+        QMutexLocker locker(&mutex());
+        DirectoryListingHash::ConstIterator it = directoryListings().constFind(dirPath);
+        if (it != directoryListings().constEnd())
+            return it->contains(name);
+    }
+
+    QSet<QString> files;
+    // Like QFileInfo::isFile(), this includes symlinks to files, but not broken ones.
+    foreach (const QString &entry, QDir(dirPath).entryList(QDir::Files | QDir::Hidden))
+        files.insert(fileNameKey(entry));
+    const bool found = files.contains(name);
+
+    QMutexLocker locker(&mutex());
+    directoryListings().insert(dirPath, files);
+    return found;
+}
+
+/*
+  Collects one diagnostic and writes it out in one go, so messages from
+  concurrent parser threads do not get interleaved.
+*/
+class ParserMessage {
+public:
+    ParserMessage() {}
+    ParserMessage(ParserMessage &&other) : m_text(std::move(other.m_text)) {}
+    ~ParserMessage()
+    {
+        if (m_text.isEmpty())
+            return;
+        static QMutex mutex;
+        QMutexLocker locker(&mutex);
+        std::cerr << m_text.constData();
+    }
+
+    ParserMessage &operator<<(const char *str) { m_text += str; return *this; }
+    ParserMessage &operator<<(char ch) { m_text += ch; return *this; }
+    ParserMessage &operator<<(int num) { m_text += QByteArray::number(num); return *this; }
+
+private:
+    Q_DISABLE_COPY(ParserMessage)
+
+    QByteArray m_text;
+};
+
 class CppParser {
 
 public:
     CppParser(ParseResults *results = 0);
     void setInput(const QString &in);
-    void setInput(QTextStream &ts, const QString &fileName);
+    void setInput(QFile &file, QTextCodec *codec);
     void setTranslator(Translator *_tor) { tor = _tor; }
     void parse(ConversionData &cd, const QStringList &includeStack, QSet<QString> &inclusions);
     void parseInternal(ConversionData &cd, const QStringList &includeStack, QSet<QString> &inclusions);
-    const ParseResults *recordResults(bool isHeader);
+    const ParseResults *recordResults(bool isHeader, QSet<QString> *dependencies = 0,
+                                      QSet<QString> *blacklisted = 0);
     void deleteResults() { delete results; }
 
     struct SavedState {
@@ -134,8 +266,11 @@ private:
         Tok_Other
     };
 
-    std::ostream &yyMsg(int line = 0);
+    ParserMessage yyMsg(int line = 0);
 
+    inline ushort readRawChar();
+    inline ushort peekRawChar() const;
+    ushort readUtf8Sequence();
     int getChar();
     TokenType lookAheadToSemicolonOrLeftBrace();
     TokenType getToken();
@@ -214,6 +349,11 @@ private:
     QTextCodec *yySourceCodec;
     QString yyInStr;
     const ushort *yyInPtr;
+    // alternatively, the UTF-8 encoded input, usually mapped straight from the file
+    QByteArray yyInBytes;
+    const uchar *yyInBytePtr;
+    const uchar *yyInByteEnd;
+    ushort yyPendingSurrogate;
 
     // Parser state
     TokenType yyTok;
@@ -262,12 +402,17 @@ CppParser::CppParser(ParseResults *_results)
     yyAtNewline = true;
     yyMinBraceDepth = 0;
     inDefine = false;
+    yyInBytePtr = 0;
+    yyInByteEnd = 0;
+    yyPendingSurrogate = 0;
 }
 
 
-std::ostream &CppParser::yyMsg(int line)
+ParserMessage CppParser::yyMsg(int line)
 {
-    return std::cerr << qPrintable(yyFileName) << ':' << (line ? line : yyLineNo) << ": ";
+    ParserMessage msg;
+    msg << qPrintable(yyFileName) << ':' << (line ? line : yyLineNo) << ": ";
+    return msg;
 }
 
 void CppParser::setInput(const QString &in)
@@ -277,11 +422,36 @@ void CppParser::setInput(const QString &in)
     yySourceCodec = 0;
 }
 
-void CppParser::setInput(QTextStream &ts, const QString &fileName)
+/*
+  UTF-8 input (that is, nearly all input) is neither copied nor converted
+  up front, but decoded by getChar() as it goes.
+*/
+void CppParser::setInput(QFile &file, QTextCodec *codec)
 {
-    yyInStr = ts.readAll();
-    yyFileName = fileName;
-    yySourceCodec = ts.codec();
+    yyFileName = file.fileName();
+    yySourceCodec = codec;
+
+    // Like QTextStream::setAutoDetectUnicode(), obey byte order marks.
+    if (codec->mibEnum() != 106
+        || QTextCodec::codecForUtfText(file.peek(4), codec)->mibEnum() != 106) {
+        QTextStream ts(&file);
+        ts.setCodec(codec);
+        ts.setAutoDetectUnicode(true);
+        yyInStr = ts.readAll();
+        return;
+    }
+
+    const qint64 size = file.size();
+    const uchar *data = size > 0 && size <= std::numeric_limits<int>::max()
+            ? file.map(0, size) : 0;
+    if (data)
+        yyInBytes = QByteArray::fromRawData(reinterpret_cast<const char *>(data), int(size));
+    else
+        yyInBytes = file.readAll();
+    yyInBytePtr = reinterpret_cast<const uchar *>(yyInBytes.constData());
+    yyInByteEnd = yyInBytePtr + yyInBytes.size();
+    if (yyInBytes.startsWith("\xef\xbb\xbf"))
+        yyInBytePtr += 3;
 }
 
 /*
@@ -306,34 +476,110 @@ void CppParser::setInput(QTextStream &ts, const QString &fileName)
   The 0 doesn't produce any token.
 */
 
+// Decodes one multi-byte sequence. Malformed bytes are replaced one by one.
+ushort CppParser::readUtf8Sequence()
+{
+    const uchar *p = yyInBytePtr;
+    const uchar b = *p;
+    int len;
+    uint uc;
+    uint min;
+    if (b >= 0xc2 && b <= 0xdf) {
+        len = 2;
+        uc = b & 0x1f;
+        min = 0x80;
+    } else if (b >= 0xe0 && b <= 0xef) {
+        len = 3;
+        uc = b & 0x0f;
+        min = 0x800;
+    } else if (b >= 0xf0 && b <= 0xf4) {
+        len = 4;
+        uc = b & 0x07;
+        min = 0x10000;
+    } else {
+        goto invalid;
+    }
+    if (yyInByteEnd - p < len)
+        goto invalid;
+    for (int i = 1; i < len; ++i) {
+        if ((p[i] & 0xc0) != 0x80)
+            goto invalid;
+        uc = (uc << 6) | (p[i] & 0x3f);
+    }
+    if (uc < min || QChar::isSurrogate(uc) || uc > QChar::LastValidCodePoint)
+        goto invalid;
+
+    yyInBytePtr += len;
+    if (QChar::requiresSurrogates(uc)) {
+        yyPendingSurrogate = QChar::lowSurrogate(uc);
+        return QChar::highSurrogate(uc);
+    }
+    return ushort(uc);
+
+  invalid:
+    ++yyInBytePtr;
+    return QChar::ReplacementCharacter;
+}
+
+// Returns the next UTF-16 code unit of the input, or 0 at its end.
+inline ushort CppParser::readRawChar()
+{
+    if (!yyInBytePtr) {
+        ushort c = *yyInPtr;
+        if (c)
+            ++yyInPtr;
+        return c;
+    }
+    if (yyPendingSurrogate) {
+        ushort c = yyPendingSurrogate;
+        yyPendingSurrogate = 0;
+        return c;
+    }
+    if (yyInBytePtr == yyInByteEnd)
+        return 0;
+    uchar b = *yyInBytePtr;
+    if (b < 0x80) {
+        if (b)
+            ++yyInBytePtr;
+        return b;
+    }
+    return readUtf8Sequence();
+}
+
+// Only used to look for ASCII characters, so the first byte of a sequence will do.
+inline ushort CppParser::peekRawChar() const
+{
+    if (!yyInBytePtr)
+        return *yyInPtr;
+    if (yyPendingSurrogate)
+        return yyPendingSurrogate;
+    return yyInBytePtr == yyInByteEnd ? 0 : *yyInBytePtr;
+}
+
 int CppParser::getChar()
 {
-    const ushort *uc = yyInPtr;
     forever {
-        ushort c = *uc;
-        if (!c) {
-            yyInPtr = uc;
+        ushort c = readRawChar();
+        if (!c)
             return EOF;
-        }
-        ++uc;
         if (c == '\\') {
-            ushort cc = *uc;
+            ushort cc = peekRawChar();
             if (cc == '\n') {
                 ++yyCurLineNo;
-                ++uc;
+                readRawChar();
                 continue;
             }
             if (cc == '\r') {
                 ++yyCurLineNo;
-                ++uc;
-                if (*uc == '\n')
-                    ++uc;
+                readRawChar();
+                if (peekRawChar() == '\n')
+                    readRawChar();
                 continue;
             }
         }
         if (c == '\r') {
-            if (*uc == '\n')
-                ++uc;
+            if (peekRawChar() == '\n')
+                readRawChar();
             c = '\n';
             ++yyCurLineNo;
             yyAtNewline = true;
@@ -343,13 +589,27 @@ int CppParser::getChar()
         } else if (c != ' ' && c != '\t' && c != '#') {
             yyAtNewline = false;
         }
-        yyInPtr = uc;
         return int(c);
     }
 }
 
 CppParser::TokenType CppParser::lookAheadToSemicolonOrLeftBrace()
 {
+    if (yyInBytePtr) {
+        if (!peekRawChar())
+            return Tok_Eof;
+        // Skip the next character like below. Only ASCII is looked for, so
+        // starting in the middle of a multi-byte sequence does no harm.
+        for (const uchar *uc = yyPendingSurrogate ? yyInBytePtr : yyInBytePtr + 1;
+             uc != yyInByteEnd && *uc; ++uc) {
+            if (*uc == ';')
+                return Tok_Semicolon;
+            if (*uc == '{')
+                return Tok_LeftBrace;
+        }
+        return Tok_Eof;
+    }
+
     if (*yyInPtr == 0)
         return Tok_Eof;
     const ushort *uc = yyInPtr + 1;
@@ -1025,6 +1285,7 @@ bool CppParser::qualifyOneCallbackOwn(const Namespace *ns, void *context) const
         *data->resolved << data->segment;
         return true;
     }
+    QMutexLocker locker(&aliasMutex());
     QHash<HashString, NamespaceList>::ConstIterator nsai = ns->aliases.constFind(data->segment);
     if (nsai != ns->aliases.constEnd()) {
         const NamespaceList &nsl = *nsai;
@@ -1036,6 +1297,8 @@ bool CppParser::qualifyOneCallbackOwn(const Namespace *ns, void *context) const
                 const_cast<Namespace *>(ns)->aliases.remove(data->segment);
                 return false;
             }
+            for (const HashString &segment : qAsConst(nslOut))
+                qHash(segment);
             nslIn = nslOut;
         }
         *data->resolved = nsl;
@@ -1176,6 +1439,13 @@ IncludeCycleHash &CppFiles::includeCycles()
     return cycles;
 }
 
+DirectoryListingHash &CppFiles::directoryListings()
+{
+    static DirectoryListingHash listings;
+
+    return listings;
+}
+
 TranslatorHash &CppFiles::translatedFiles()
 {
     static TranslatorHash tors;
@@ -1190,8 +1460,37 @@ QSet<QString> &CppFiles::blacklistedFiles()
     return blacklisted;
 }
 
+ParsingFileHash &CppFiles::parsingFiles()
+{
+    static ParsingFileHash parsing;
+
+    return parsing;
+}
+
+WaitingThreadHash &CppFiles::waitingThreads()
+{
+    static WaitingThreadHash waiting;
+
+    return waiting;
+}
+
+QMutex &CppFiles::mutex()
+{
+    static QMutex mutex;
+
+    return mutex;
+}
+
+QWaitCondition &CppFiles::parseFinished()
+{
+    static QWaitCondition finished;
+
+    return finished;
+}
+
 QSet<const ParseResults *> CppFiles::getResults(const QString &cleanFile)
 {
+    QMutexLocker locker(&mutex());
     IncludeCycle * const cycle = includeCycles().value(cleanFile);
 
     if (cycle)
@@ -1200,8 +1499,63 @@ QSet<const ParseResults *> CppFiles::getResults(const QString &cleanFile)
         return QSet<const ParseResults *>();
 }
 
+QSet<const ParseResults *> CppFiles::claimResults(const QString &cleanFile, bool *claimed,
+                                                  QString *cycleFile)
+{
+    const Qt::HANDLE self = QThread::currentThreadId();
+    QMutexLocker locker(&mutex());
+    forever {
+        if (IncludeCycle * const cycle = includeCycles().value(cleanFile)) {
+            if (!cycle->results.isEmpty()) {
+                *claimed = false;
+                return cycle->results;
+            }
+        }
+
+        const Qt::HANDLE owner = parsingFiles().value(cleanFile);
+        if (!owner) {
+            parsingFiles().insert(cleanFile, self);
+            *claimed = true;
+            return QSet<const ParseResults *>();
+        }
+        // A header including itself through a top-level file is parsed once more,
+        // just like it is done without threads.
+        if (owner == self) {
+            *claimed = true;
+            return QSet<const ParseResults *>();
+        }
+
+        for (Qt::HANDLE thread = owner; ; ) {
+            WaitingThreadHash::ConstIterator it = waitingThreads().constFind(thread);
+            if (it == waitingThreads().constEnd())
+                break;
+            thread = parsingFiles().value(*it);
+            if (thread == self) {
+                *claimed = false;
+                if (cycleFile)
+                    *cycleFile = *it;
+                return QSet<const ParseResults *>();
+            }
+            if (!thread)
+                break;
+        }
+
+        waitingThreads().insert(self, cleanFile);
+        parseFinished().wait(&mutex());
+        waitingThreads().remove(self);
+    }
+}
+
+void CppFiles::releaseClaim(const QString &cleanFile)
+{
+    QMutexLocker locker(&mutex());
+    if (parsingFiles().remove(cleanFile))
+        parseFinished().wakeAll();
+}
+
 void CppFiles::setResults(const QString &cleanFile, const ParseResults *results)
 {
+    QMutexLocker locker(&mutex());
     IncludeCycle *cycle = includeCycles().value(cleanFile);
 
     if (!cycle) {
@@ -1211,30 +1565,38 @@ void CppFiles::setResults(const QString &cleanFile, const ParseResults *results)
 
     cycle->fileNames.insert(cleanFile);
     cycle->results.insert(results);
+
+    if (parsingFiles().remove(cleanFile))
+        parseFinished().wakeAll();
 }
 
 const Translator *CppFiles::getTranslator(const QString &cleanFile)
 {
+    QMutexLocker locker(&mutex());
     return translatedFiles().value(cleanFile);
 }
 
 void CppFiles::setTranslator(const QString &cleanFile, const Translator *tor)
 {
+    QMutexLocker locker(&mutex());
     translatedFiles().insert(cleanFile, tor);
 }
 
 bool CppFiles::isBlacklisted(const QString &cleanFile)
 {
+    QMutexLocker locker(&mutex());
     return blacklistedFiles().contains(cleanFile);
 }
 
 void CppFiles::setBlacklisted(const QString &cleanFile)
 {
+    QMutexLocker locker(&mutex());
     blacklistedFiles().insert(cleanFile);
 }
 
 void CppFiles::addIncludeCycle(const QSet<QString> &fileNames)
 {
+    QMutexLocker locker(&mutex());
     IncludeCycle * const cycle = new IncludeCycle;
     cycle->fileNames = fileNames;
 
@@ -1255,6 +1617,60 @@ void CppFiles::addIncludeCycle(const QSet<QString> &fileNames)
         includeCycles().insert(fileName, cycle);
 }
 
+void CppFiles::forget(const QSet<QString> &changedFiles)
+{
+    QMutexLocker locker(&mutex());
+    QSet<IncludeCycle *> staleCycles;
+    for (auto it = includeCycles().cbegin(), end = includeCycles().cend(); it != end; ++it) {
+        IncludeCycle * const cycle = it.value();
+        if (staleCycles.contains(cycle))
+            continue;
+        bool stale = cycle->fileNames.intersects(changedFiles);
+        foreach (const ParseResults *pr, cycle->results) {
+            if (stale)
+                break;
+            stale = pr->dependencies.intersects(changedFiles);
+        }
+        if (stale)
+            staleCycles.insert(cycle);
+    }
+
+    // Forwarding headers share the results of the header they forward to.
+    QSet<const ParseResults *> staleResults;
+    QSet<const ParseResults *> liveResults;
+    for (auto it = includeCycles().begin(); it != includeCycles().end(); ) {
+        if (staleCycles.contains(it.value())) {
+            staleResults.unite(it.value()->results);
+            it = includeCycles().erase(it);
+        } else {
+            liveResults.unite(it.value()->results);
+            ++it;
+        }
+    }
+    qDeleteAll(staleCycles);
+    foreach (const ParseResults *pr, staleResults)
+        if (!liveResults.contains(pr))
+            delete pr;
+
+    // Files without results are parsed again anyway, or come from the extraction cache.
+    for (auto it = translatedFiles().begin(); it != translatedFiles().end(); ) {
+        if (!includeCycles().contains(it.key())) {
+            delete it.value();
+            it = translatedFiles().erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    blacklistedFiles().clear();
+    foreach (const ParseResults *pr, liveResults)
+        blacklistedFiles().unite(pr->blacklisted);
+
+    // Created and deleted files are not among the changed ones, so no
+    // listing can be trusted to still be up to date.
+    directoryListings().clear();
+}
+
 static bool isHeader(const QString &name)
 {
     QString fileExt = QFileInfo(name).suffix();
@@ -1272,6 +1688,9 @@ void CppParser::processInclude(const QString &file, ConversionData &cd, const QS
             return;
     }
 
+    if (extractionCache.isEnabled())
+        results->dependencies.insert(cleanFile);
+
     const int index = includeStack.indexOf(cleanFile);
     if (index != -1) {
         CppFiles::addIncludeCycle(QSet<QString>(includeStack.cbegin() + index, includeStack.cend()));
@@ -1288,11 +1707,30 @@ void CppParser::processInclude(const QString &file, ConversionData &cd, const QS
         && !CppFiles::isBlacklisted(cleanFile)
         && isHeader(cleanFile)) {
 
-        QSet<const ParseResults *> res = CppFiles::getResults(cleanFile);
+        bool claimed;
+        QString cycleFile;
+        QSet<const ParseResults *> res = CppFiles::claimResults(cleanFile, &claimed, &cycleFile);
         if (!res.isEmpty()) {
             results->includes.unite(res);
             return;
         }
+        // Another thread is parsing this header and waiting for us, so this
+        // is an include cycle spanning threads. Break it here, but join the
+        // files into one cycle like above, so that the results of both end
+        // up with everyone including them later on. The files parsed in
+        // between by the other threads are not known here, though.
+        if (!claimed) {
+            QSet<QString> fileNames;
+            const int cycleIndex = includeStack.indexOf(cycleFile);
+            if (cycleIndex != -1)
+                fileNames = QSet<QString>(includeStack.cbegin() + cycleIndex, includeStack.cend());
+            fileNames << cycleFile << cleanFile;
+            CppFiles::addIncludeCycle(fileNames);
+            yyMsg() << qPrintable(LU::tr("Include cycle between %1 and %2 spans parser threads;"
+                                         " the declarations of %1 are not visible here.\n")
+                                  .arg(cleanFile, cycleFile));
+            return;
+        }
 
         isIndirect = true;
     }
@@ -1300,13 +1738,11 @@ void CppParser::processInclude(const QString &file, ConversionData &cd, const QS
     QFile f(cleanFile);
     if (!f.open(QIODevice::ReadOnly)) {
         yyMsg() << qPrintable(LU::tr("Cannot open %1: %2\n").arg(cleanFile, f.errorString()));
+        if (isIndirect)
+            CppFiles::releaseClaim(cleanFile);
         return;
     }
 
-    QTextStream ts(&f);
-    ts.setCodec(yySourceCodec);
-    ts.setAutoDetectUnicode(true);
-
     inclusions.insert(cleanFile);
     if (isIndirect) {
         CppParser parser;
@@ -1315,7 +1751,7 @@ void CppParser::processInclude(const QString &file, ConversionData &cd, const QS
                 parser.setTranslator(new Translator);
                 break;
             }
-        parser.setInput(ts, cleanFile);
+        parser.setInput(f, yySourceCodec);
         QStringList stack = includeStack;
         stack << cleanFile;
         parser.parse(cd, stack, inclusions);
@@ -1325,13 +1761,15 @@ void CppParser::processInclude(const QString &file, ConversionData &cd, const QS
         parser.namespaces = namespaces;
         parser.functionContext = functionContext;
         parser.functionContextUnresolved = functionContextUnresolved;
-        parser.setInput(ts, cleanFile);
+        parser.setInput(f, yySourceCodec);
         parser.setTranslator(tor);
         QStringList stack = includeStack;
         stack << cleanFile;
         parser.parseInternal(cd, stack, inclusions);
         // Avoid that messages obtained by direct scanning are used
         CppFiles::setBlacklisted(cleanFile);
+        if (extractionCache.isEnabled())
+            results->blacklisted.insert(cleanFile);
     }
     inclusions.remove(cleanFile);
 
@@ -1499,26 +1937,23 @@ void CppParser::handleTr(QString &prefix, bool plural)
                     if (idx == 1) {
                         context = stringifyNamespace(functionContext);
                         fctx = findNamespace(functionContext)->classDef;
-                        if (!fctx->complained) {
+                        if (setComplained(fctx)) {
                             yyMsg() << qPrintable(LU::tr("Class '%1' lacks Q_OBJECT macro\n")
                                                  .arg(context));
-                            fctx->complained = true;
                         }
                         goto gotctx;
                     }
                     --idx;
                 }
-                if (fctx->trQualification.isEmpty()) {
-                    context.clear();
+                context = trQualification(fctx);
+                if (context.isEmpty()) {
                     for (int i = 1;;) {
                         context += functionContext.at(i).value();
                         if (++i == idx)
                             break;
                         context += QLatin1String("::");
                     }
-                    fctx->trQualification = context;
-                } else {
-                    context = fctx->trQualification;
+                    context = cacheTrQualification(fctx, context);
                 }
             } else {
                 context = joinNamespaces(stringifyNamespace(functionContext), functionContextUnresolved);
@@ -1537,16 +1972,11 @@ void CppParser::handleTr(QString &prefix, bool plural)
             NamespaceList unresolved;
             if (fullyQualify(functionContext, prefix, false, &nsl, &unresolved)) {
                 Namespace *fctx = findNamespace(nsl)->classDef;
-                if (fctx->trQualification.isEmpty()) {
-                    context = stringifyNamespace(nsl);
-                    fctx->trQualification = context;
-                } else {
-                    context = fctx->trQualification;
-                }
-                if (!fctx->hasTrFunctions && !fctx->complained) {
+                context = trQualification(fctx);
+                if (context.isEmpty())
+                    context = cacheTrQualification(fctx, stringifyNamespace(nsl));
+                if (!fctx->hasTrFunctions && setComplained(fctx))
                     yyMsg() << qPrintable(LU::tr("Class '%1' lacks Q_OBJECT macro\n").arg(context));
-                    fctx->complained = true;
-                }
             } else {
                 context = joinNamespaces(stringifyNamespace(nsl), stringifyNamespace(0, unresolved));
             }
@@ -1681,8 +2111,14 @@ void CppParser::parseInternal(ConversionData &cd, const QStringList &includeStac
     prospectiveContext.clear();
     pendingContext.clear();
 
-    yyWord.reserve(yyInStr.size()); // Rather insane. That's because we do no length checking.
-    yyInPtr = (const ushort *)yyInStr.unicode();
+    // Rather insane. That's because we do no length checking.
+    // UTF-8 never takes fewer bytes than UTF-16 takes code units.
+    if (yyInBytePtr) {
+        yyWord.reserve(yyInByteEnd - yyInBytePtr);
+    } else {
+        yyWord.reserve(yyInStr.size());
+        yyInPtr = (const ushort *)yyInStr.unicode();
+    }
     yyCh = getChar();
     yyTok = getToken();
     while (yyTok != Tok_Eof) {
@@ -1699,7 +2135,7 @@ void CppParser::parseInternal(ConversionData &cd, const QStringList &includeStac
         case Tok_QuotedInclude: {
             text = QDir(QFileInfo(yyFileName).absolutePath()).absoluteFilePath(yyWord);
             text.detach();
-            if (QFileInfo(text).isFile()) {
+            if (CppFiles::isExistingFile(text)) {
                 processInclude(text, cd, includeStack, inclusions);
                 yyTok = getToken();
                 break;
@@ -1716,7 +2152,7 @@ void CppParser::parseInternal(ConversionData &cd, const QStringList &includeStac
             foreach (const QString &incPath, cd.m_includePath) {
                 text = QDir(incPath).absoluteFilePath(yyWord);
                 text.detach();
-                if (QFileInfo(text).isFile()) {
+                if (CppFiles::isExistingFile(text)) {
                     processInclude(text, cd, includeStack, inclusions);
                     goto incOk;
                 }
@@ -2195,8 +2631,21 @@ void CppParser::processComment()
     }
 }
 
-const ParseResults *CppParser::recordResults(bool isHeader)
+const ParseResults *CppParser::recordResults(bool isHeader, QSet<QString> *dependencies,
+                                             QSet<QString> *blacklisted)
 {
+    if (extractionCache.isEnabled()) {
+        // Forwarding headers are slashed below, so the results must name their own file.
+        results->dependencies.insert(yyFileName);
+        foreach (const ParseResults *inc, results->includes) {
+            results->dependencies.unite(inc->dependencies);
+            results->blacklisted.unite(inc->blacklisted);
+        }
+        if (dependencies)
+            *dependencies = results->dependencies;
+        if (blacklisted)
+            *blacklisted = results->blacklisted;
+    }
     if (tor) {
         if (tor->messageCount()) {
             CppFiles::setTranslator(yyFileName, tor);
@@ -2215,7 +2664,8 @@ const ParseResults *CppParser::recordResults(bool isHeader)
             pr = *results->includes.begin();
             delete results;
         } else {
-            results->fileId = nextFileId++;
+            results->fileId = nextFileId.fetchAndAddRelaxed(1);
+            primeHashes(&results->rootNamespace);
             pr = results;
         }
         CppFiles::setResults(yyFileName, pr);
@@ -2226,40 +2676,113 @@ const ParseResults *CppParser::recordResults(bool isHeader)
     }
 }
 
-void loadCPP(Translator &translator, const QStringList &filenames, ConversionData &cd)
+// Returns an error message, if any.
+static QString parseCppFile(const QString &filename, QTextCodec *codec, ConversionData &cd,
+                            const QByteArray &cacheKey)
 {
-    QTextCodec *codec = QTextCodec::codecForName(cd.m_sourceIsUtf16 ? "UTF-16" : "UTF-8");
-
-    foreach (const QString &filename, filenames) {
-        if (!CppFiles::getResults(filename).isEmpty() || CppFiles::isBlacklisted(filename))
-            continue;
+    if (CppFiles::isBlacklisted(filename))
+        return QString();
+    const bool header = isHeader(filename);
+    if (header) {
+        // Headers may be parsed by other threads as a side effect of including them.
+        bool claimed;
+        if (!CppFiles::claimResults(filename, &claimed).isEmpty() || !claimed)
+            return QString();
+    } else if (!CppFiles::getResults(filename).isEmpty()) {
+        return QString();
+    }
 
-        QFile file(filename);
-        if (!file.open(QIODevice::ReadOnly)) {
-            cd.appendError(LU::tr("Cannot open %1: %2").arg(filename, file.errorString()));
-            continue;
+    if (extractionCache.isEnabled()) {
+        Translator *tor = new Translator;
+        QStringList blacklisted;
+        if (extractionCache.lookup(filename, cacheKey, tor, &blacklisted)) {
+            for (const QString &blacklistedFile : qAsConst(blacklisted))
+                CppFiles::setBlacklisted(blacklistedFile);
+            if (tor->messageCount())
+                CppFiles::setTranslator(filename, tor);
+            else
+                delete tor;
+            // Whoever needs the namespaces declared in this header will parse it.
+            if (header)
+                CppFiles::releaseClaim(filename);
+            return QString();
         }
+        delete tor;
+    }
 
-        CppParser parser;
-        QTextStream ts(&file);
-        ts.setCodec(codec);
-        ts.setAutoDetectUnicode(true);
-        parser.setInput(ts, filename);
-        Translator *tor = new Translator;
-        parser.setTranslator(tor);
-        QSet<QString> inclusions;
-        parser.parse(cd, QStringList(), inclusions);
-        parser.recordResults(isHeader(filename));
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (header)
+            CppFiles::releaseClaim(filename);
+        return LU::tr("Cannot open %1: %2").arg(filename, file.errorString());
+    }
+
+    CppParser parser;
+    parser.setInput(file, codec);
+    Translator *tor = new Translator;
+    parser.setTranslator(tor);
+    QSet<QString> inclusions;
+    parser.parse(cd, QStringList(), inclusions);
+    if (extractionCache.isEnabled()) {
+        // Copy the messages now, as recording the results may delete the translator.
+        Translator extracted = *tor;
+        QSet<QString> dependencies;
+        QSet<QString> blacklisted;
+        parser.recordResults(header, &dependencies, &blacklisted);
+        extractionCache.store(filename, cacheKey, dependencies, blacklisted, extracted);
+    } else {
+        parser.recordResults(header);
+    }
+    return QString();
+}
+
+void forgetCPP(const QSet<QString> &changedFiles)
+{
+    CppFiles::forget(changedFiles);
+}
+
+void loadCPP(Translator &translator, const QStringList &filenames, ConversionData &cd)
+{
+    QTextCodec *codec = QTextCodec::codecForName(cd.m_sourceIsUtf16 ? "UTF-16" : "UTF-8");
+    const QByteArray cacheKey = extractionCache.isEnabled()
+            ? ExtractionCache::optionsKey(cd) : QByteArray();
+
+#if QT_CONFIG(thread)
+    const int threadCount = qMin(cd.m_threadCount, filenames.count());
+    if (threadCount > 1) {
+        QVector<QString> errors(filenames.count());
+        QString *errorData = errors.data();
+        QThreadPool pool;
+        pool.setMaxThreadCount(threadCount);
+        for (int i = 0; i < filenames.count(); ++i) {
+            pool.start(QRunnable::create([&filenames, &cd, &cacheKey, errorData, codec, i] {
+                errorData[i] = parseCppFile(filenames.at(i), codec, cd, cacheKey);
+            }));
+        }
+        pool.waitForDone();
+        for (const QString &error : qAsConst(errors)) {
+            if (!error.isEmpty())
+                cd.appendError(error);
+        }
+    } else
+#endif
+    {
+        foreach (const QString &filename, filenames) {
+            const QString error = parseCppFile(filename, codec, cd, cacheKey);
+            if (!error.isEmpty())
+                cd.appendError(error);
+        }
     }
 
+    // Merge in the original order, so the result does not depend on thread scheduling.
+    QList<const Translator *> tors;
     foreach (const QString &filename, filenames) {
         if (!CppFiles::isBlacklisted(filename)) {
-            if (const Translator *tor = CppFiles::getTranslator(filename)) {
-                foreach (const TranslatorMessage &msg, tor->messages())
-                    translator.extend(msg, cd);
-            }
+            if (const Translator *tor = CppFiles::getTranslator(filename))
+                tors.append(tor);
         }
     }
+    translator.extend(tors, cd);
 }
 
 QT_END_NAMESPACE
@@ -31,7 +31,9 @@
 
 #include "lupdate.h"
 
+#include <QtCore/QMutex>
 #include <QtCore/QSet>
+#include <QtCore/QWaitCondition>
 
 #include <iostream>
 
@@ -97,6 +99,11 @@ struct ParseResults {
     int fileId;
     Namespace rootNamespace;
     QSet<const ParseResults *> includes;
+    // Only maintained for the extraction cache: the files these results were
+    // derived from, and the files which were blacklisted on the way, each
+    // including those of the included results.
+    QSet<QString> dependencies;
+    QSet<QString> blacklisted;
 };
 
 struct IncludeCycle {
@@ -106,22 +113,49 @@ struct IncludeCycle {
 
 typedef QHash<QString, IncludeCycle *> IncludeCycleHash;
 typedef QHash<QString, const Translator *> TranslatorHash;
+// Directory path (with trailing slash) -> names of the files in it
+typedef QHash<QString, QSet<QString> > DirectoryListingHash;
 
+typedef QHash<QString, Qt::HANDLE> ParsingFileHash;
+typedef QHash<Qt::HANDLE, QString> WaitingThreadHash;
+
+// All members may be used from several parser threads at once.
 class CppFiles {
 
 public:
     static QSet<const ParseResults *> getResults(const QString &cleanFile);
+    // Like getResults(), but if the file has not been parsed yet, the calling
+    // thread becomes responsible for parsing it and *claimed is set. If another
+    // thread is already parsing the file, this waits for it to finish, unless
+    // that thread is (indirectly) waiting for the calling thread - the include
+    // cycle is then broken by returning nothing with *claimed unset, and
+    // *cycleFile names the file of the calling thread which closes the cycle.
+    static QSet<const ParseResults *> claimResults(const QString &cleanFile, bool *claimed,
+                                                   QString *cycleFile = nullptr);
+    // Gives up a claim without setting results, e.g. when the file cannot be read.
+    static void releaseClaim(const QString &cleanFile);
     static void setResults(const QString &cleanFile, const ParseResults *results);
     static const Translator *getTranslator(const QString &cleanFile);
     static void setTranslator(const QString &cleanFile, const Translator *results);
     static bool isBlacklisted(const QString &cleanFile);
     static void setBlacklisted(const QString &cleanFile);
     static void addIncludeCycle(const QSet<QString> &fileNames);
+    // Checks for an include candidate through cached directory listings.
+    static bool isExistingFile(const QString &filePath);
+    // Drops everything derived from the given files, so they and the files
+    // including them are parsed again. Relies on the extraction cache
+    // having recorded the dependencies.
+    static void forget(const QSet<QString> &changedFiles);
 
 private:
     static IncludeCycleHash &includeCycles();
+    static DirectoryListingHash &directoryListings();
     static TranslatorHash &translatedFiles();
     static QSet<QString> &blacklistedFiles();
+    static ParsingFileHash &parsingFiles();
+    static WaitingThreadHash &waitingThreads();
+    static QMutex &mutex();
+    static QWaitCondition &parseFinished();
 };
 
 QT_END_NAMESPACE
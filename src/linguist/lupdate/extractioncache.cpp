@@ -0,0 +1,288 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "extractioncache.h"
+
+#include "lupdate.h"
+
+#include <translator.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
+
+QT_BEGIN_NAMESPACE
+
+// Bump the version whenever the parsers change what they extract.
+static const quint32 CacheMagic = 0x4c554543; // "LUEC"
+static const quint32 CacheVersion = 1;
+
+static void writeMessage(QDataStream &out, const TranslatorMessage &msg)
+{
+    out << msg.id() << msg.context() << msg.sourceText() << msg.oldSourceText()
+        << msg.comment() << msg.oldComment() << msg.userData()
+        << msg.extraComment() << msg.translatorComment()
+        << msg.translations() << msg.extras()
+        << qint8(msg.type()) << msg.isPlural();
+    const TranslatorMessage::References refs = msg.allReferences();
+    out << quint32(refs.count());
+    for (const TranslatorMessage::Reference &ref : refs)
+        out << ref.fileName() << qint32(ref.lineNumber());
+}
+
+static TranslatorMessage readMessage(QDataStream &in)
+{
+    QString id, context, sourceText, oldSourceText, comment, oldComment, userData;
+    QString extraComment, translatorComment;
+    QStringList translations;
+    TranslatorMessage::ExtraData extras;
+    qint8 type;
+    bool plural;
+    quint32 refCount;
+    in >> id >> context >> sourceText >> oldSourceText
+       >> comment >> oldComment >> userData
+       >> extraComment >> translatorComment
+       >> translations >> extras
+       >> type >> plural >> refCount;
+
+    TranslatorMessage msg(context, sourceText, comment, userData, QString(), -1,
+                          translations, TranslatorMessage::Type(type), plural);
+    msg.setId(id);
+    msg.setOldSourceText(oldSourceText);
+    msg.setOldComment(oldComment);
+    msg.setExtraComment(extraComment);
+    msg.setTranslatorComment(translatorComment);
+    msg.setExtras(extras);
+    for (quint32 i = 0; i < refCount && in.status() == QDataStream::Ok; ++i) {
+        QString fileName;
+        qint32 lineNumber;
+        in >> fileName >> lineNumber;
+        msg.addReference(fileName, lineNumber);
+    }
+    return msg;
+}
+
+bool ExtractionCache::setDirectory(const QString &directory, QString *errorString)
+{
+    QDir dir(directory);
+    if (!dir.mkpath(QLatin1String("."))) {
+        *errorString = LU::tr("Cannot create cache directory %1").arg(directory);
+        return false;
+    }
+    m_directory = dir.absolutePath();
+    return true;
+}
+
+QByteArray ExtractionCache::optionsKey(const ConversionData &cd)
+{
+    QStringList options;
+    options << QLatin1String(QT_VERSION_STR)
+            << QString::number(cd.m_sourceIsUtf16)
+            << QString::number(cd.m_noUiLines)
+            << trFunctionAliasManager.availableFunctionsWithAliases()
+            << cd.m_includePath
+            << cd.m_excludes;
+
+    // Hash iteration order varies between runs.
+    QStringList projectRoots = cd.m_projectRoots.values();
+    projectRoots.sort();
+    options << projectRoots;
+    QStringList cSources;
+    cSources.reserve(cd.m_allCSources.size());
+    for (auto it = cd.m_allCSources.cbegin(), end = cd.m_allCSources.cend(); it != end; ++it)
+        cSources << it.key() + QLatin1Char('=') + it.value();
+    cSources.sort();
+    options << cSources;
+
+    return QCryptographicHash::hash(options.join(QChar::Null).toUtf8(), QCryptographicHash::Sha1);
+}
+
+QByteArray ExtractionCache::contentHash(const QString &fileName)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        QHash<QString, QByteArray>::ConstIterator it = m_contentHashes.constFind(fileName);
+        if (it != m_contentHashes.constEnd())
+            return *it;
+    }
+
+    QByteArray hash;
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly)) {
+        QCryptographicHash hasher(QCryptographicHash::Sha1);
+        if (hasher.addData(&file))
+            hash = hasher.result();
+    }
+
+    QMutexLocker locker(&m_mutex);
+    m_contentHashes.insert(fileName, hash);
+    return hash;
+}
+
+QStringList ExtractionCache::trackedFiles()
+{
+    QMutexLocker locker(&m_mutex);
+    return m_contentHashes.keys();
+}
+
+void ExtractionCache::forget(const QSet<QString> &fileNames)
+{
+    QMutexLocker locker(&m_mutex);
+    for (const QString &fileName : fileNames)
+        m_contentHashes.remove(fileName);
+}
+
+QString ExtractionCache::entryFileName(const QString &fileName, const QByteArray &optionsKey) const
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    hasher.addData(fileName.toUtf8());
+    hasher.addData(optionsKey);
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(hasher.result().toHex());
+}
+
+bool ExtractionCache::lookup(const QString &fileName, const QByteArray &optionsKey,
+                             Translator *tor, QStringList *blacklisted)
+{
+    const QString entryName = entryFileName(fileName, optionsKey);
+    if (m_directory.isEmpty()) {
+        QByteArray entry;
+        {
+            QMutexLocker locker(&m_mutex);
+            entry = m_entries.value(entryName);
+        }
+        if (entry.isEmpty())
+            return false;
+        QBuffer buffer(&entry);
+        buffer.open(QIODevice::ReadOnly);
+        return readEntry(buffer, fileName, optionsKey, tor, blacklisted);
+    }
+
+    QFile file(entryName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    return readEntry(file, fileName, optionsKey, tor, blacklisted);
+}
+
+bool ExtractionCache::readEntry(QIODevice &device, const QString &fileName,
+                                const QByteArray &optionsKey,
+                                Translator *tor, QStringList *blacklisted)
+{
+    QDataStream in(&device);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 magic, version;
+    QString storedFileName;
+    QByteArray storedOptionsKey;
+    in >> magic >> version;
+    if (in.status() != QDataStream::Ok || magic != CacheMagic || version != CacheVersion)
+        return false;
+    in >> storedFileName >> storedOptionsKey;
+    if (storedFileName != fileName || storedOptionsKey != optionsKey)
+        return false;
+
+    quint32 dependencyCount;
+    in >> dependencyCount;
+    for (quint32 i = 0; i < dependencyCount; ++i) {
+        QString dependency;
+        QByteArray hash;
+        in >> dependency >> hash;
+        if (in.status() != QDataStream::Ok || contentHash(dependency) != hash)
+            return false;
+    }
+
+    QStringList blacklistedFiles;
+    Translator::ExtraData extras;
+    quint32 messageCount;
+    in >> blacklistedFiles >> extras >> messageCount;
+    QList<TranslatorMessage> messages;
+    for (quint32 i = 0; i < messageCount && in.status() == QDataStream::Ok; ++i)
+        messages << readMessage(in);
+    if (in.status() != QDataStream::Ok)
+        return false;
+
+    for (const TranslatorMessage &msg : qAsConst(messages))
+        tor->append(msg);
+    if (!extras.isEmpty())
+        tor->setExtras(extras);
+    if (blacklisted)
+        *blacklisted = blacklistedFiles;
+    return true;
+}
+
+void ExtractionCache::store(const QString &fileName, const QByteArray &optionsKey,
+                            const QSet<QString> &dependencies, const QSet<QString> &blacklisted,
+                            const Translator &tor)
+{
+    QStringList files = dependencies.values();
+    if (!dependencies.contains(fileName))
+        files << fileName;
+    files.sort();
+    QList<QByteArray> hashes;
+    for (const QString &dependency : qAsConst(files)) {
+        const QByteArray hash = contentHash(dependency);
+        if (hash.isEmpty())
+            return; // Vanished meanwhile. Not worth caching.
+        hashes << hash;
+    }
+
+    // The cache is merely an optimization, so failing to write it is not an error.
+    const QString entryName = entryFileName(fileName, optionsKey);
+    QByteArray entry;
+    QBuffer buffer(&entry);
+    QSaveFile file(entryName);
+    QIODevice *device = &file;
+    if (m_directory.isEmpty())
+        device = &buffer;
+    if (!device->open(QIODevice::WriteOnly))
+        return;
+
+    QDataStream out(device);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << CacheMagic << CacheVersion << fileName << optionsKey;
+    out << quint32(files.count());
+    for (int i = 0; i < files.count(); ++i)
+        out << files.at(i) << hashes.at(i);
+    QStringList blacklistedFiles = blacklisted.values();
+    blacklistedFiles.sort();
+    out << blacklistedFiles << tor.extras() << quint32(tor.messageCount());
+    for (int i = 0; i < tor.messageCount(); ++i)
+        writeMessage(out, tor.constMessage(i));
+    if (device == &buffer) {
+        buffer.close();
+        QMutexLocker locker(&m_mutex);
+        m_entries.insert(entryName, entry);
+    } else {
+        file.commit();
+    }
+}
+
+QT_END_NAMESPACE
+
+QT_PREPEND_NAMESPACE(ExtractionCache) extractionCache;
@@ -0,0 +1,98 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef EXTRACTIONCACHE_H
+#define EXTRACTIONCACHE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+QT_BEGIN_NAMESPACE
+
+class ConversionData;
+class QIODevice;
+class Translator;
+
+/*
+  Stores the messages extracted from each source file in a directory, so
+  later lupdate runs can skip files which did not change.
+
+  An entry is valid as long as the contents of the file itself and of all
+  files it depended on (for C++, all the resolved includes) are unchanged,
+  and the options which influence extraction are the same. Warnings are
+  only reported when a file is actually parsed.
+
+  In watch mode, the entries are kept in memory instead, and the content
+  hashes of changed files are forgotten before each run.
+*/
+class ExtractionCache
+{
+public:
+    bool isEnabled() const { return m_inMemory || !m_directory.isEmpty(); }
+    bool setDirectory(const QString &directory, QString *errorString);
+    // Keeps the entries in memory, unless a directory was set.
+    void setInMemory() { m_inMemory = true; }
+
+    // All files whose contents were looked at so far.
+    QStringList trackedFiles();
+    // Makes the next lookup() re-read the given files.
+    void forget(const QSet<QString> &fileNames);
+
+    // Identifies the options influencing extraction. Pass it to lookup() and store().
+    static QByteArray optionsKey(const ConversionData &cd);
+
+    // Fills tor with the cached messages of fileName. For C++ files, blacklisted
+    // receives the files which parsing fileName caused to be blacklisted.
+    bool lookup(const QString &fileName, const QByteArray &optionsKey,
+                Translator *tor, QStringList *blacklisted = 0);
+    void store(const QString &fileName, const QByteArray &optionsKey,
+               const QSet<QString> &dependencies, const QSet<QString> &blacklisted,
+               const Translator &tor);
+
+private:
+    QByteArray contentHash(const QString &fileName);
+    QString entryFileName(const QString &fileName, const QByteArray &optionsKey) const;
+    bool readEntry(QIODevice &device, const QString &fileName, const QByteArray &optionsKey,
+                   Translator *tor, QStringList *blacklisted);
+
+    QString m_directory;
+    bool m_inMemory = false;
+    QMutex m_mutex;
+    QHash<QString, QByteArray> m_contentHashes;
+    QHash<QString, QByteArray> m_entries;
+};
+
+QT_END_NAMESPACE
+
+extern QT_PREPEND_NAMESPACE(ExtractionCache) extractionCache;
+
+#endif // EXTRACTIONCACHE_H
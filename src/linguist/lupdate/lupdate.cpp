@@ -0,0 +1,173 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "lupdate.h"
+
+#include <QtCore/QByteArray>
+
+#include <ctype.h>
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+// Can't have an array of QStaticStringData<N> for different N, so
+// use QString, which requires constructor calls. Doesn't matter
+// much, since this is in an app, not a lib:
+static const QString defaultTrFunctionNames[] = {
+// MSVC can't handle the lambda in this array if QStringLiteral expands
+// to a lambda. In that case, use a QString instead.
+#if defined(Q_CC_MSVC) && defined(Q_COMPILER_LAMBDA)
+#define STRINGLITERAL(F) QLatin1String(#F),
+#else
+#define STRINGLITERAL(F) QStringLiteral(#F),
+#endif
+    LUPDATE_FOR_EACH_TR_FUNCTION(STRINGLITERAL)
+#undef STRINGLITERAL
+};
+Q_STATIC_ASSERT((TrFunctionAliasManager::NumTrFunctions == sizeof defaultTrFunctionNames / sizeof *defaultTrFunctionNames));
+
+int TrFunctionAliasManager::trFunctionByDefaultName(const QString &trFunctionName)
+{
+    for (int i = 0; i < TrFunctionAliasManager::NumTrFunctions; ++i)
+        if (trFunctionName == defaultTrFunctionNames[i])
+            return i;
+    return -1;
+}
+
+TrFunctionAliasManager::TrFunctionAliasManager()
+    : m_trFunctionAliases()
+{
+    for (int i = 0; i < NumTrFunctions; ++i)
+        m_trFunctionAliases[i].push_back(defaultTrFunctionNames[i]);
+    updateTrFunctionHash();
+}
+
+TrFunctionAliasManager::~TrFunctionAliasManager() {}
+
+int TrFunctionAliasManager::trFunctionByName(const QString &trFunctionName) const
+{
+    // this function needs to be fast, and it is called from several parser threads at once
+    const QHash<QString, TrFunction>::const_iterator it
+        = m_nameToTrFunctionMap.find(trFunctionName);
+    return it == m_nameToTrFunctionMap.end() ? -1 : *it;
+}
+
+void TrFunctionAliasManager::modifyAlias(int trFunction, const QString &alias, Operation op)
+{
+    QList<QString> &list = m_trFunctionAliases[trFunction];
+    if (op == SetAlias)
+        list.clear();
+    list.push_back(alias);
+    updateTrFunctionHash();
+}
+
+void TrFunctionAliasManager::updateTrFunctionHash()
+{
+    QHash<QString, TrFunction> nameToTrFunctionMap;
+    for (int i = 0; i < NumTrFunctions; ++i)
+        foreach (const QString &alias, m_trFunctionAliases[i])
+            nameToTrFunctionMap[alias] = TrFunction(i);
+    // commit:
+    m_nameToTrFunctionMap.swap(nameToTrFunctionMap);
+}
+
+QStringList TrFunctionAliasManager::availableFunctions()
+{
+    QStringList result;
+    result.reserve(TrFunctionAliasManager::NumTrFunctions);
+    for (int i = 0; i < TrFunctionAliasManager::NumTrFunctions; ++i)
+        result.push_back(defaultTrFunctionNames[i]);
+    return result;
+}
+
+QStringList TrFunctionAliasManager::availableFunctionsWithAliases() const
+{
+    QStringList result;
+    result.reserve(NumTrFunctions);
+    for (int i = 0; i < NumTrFunctions; ++i)
+        result.push_back(defaultTrFunctionNames[i] +
+                         QLatin1String(" (=") +
+                         m_trFunctionAliases[i].join(QLatin1Char('=')) +
+                         QLatin1Char(')'));
+    return result;
+}
+
+QString ParserTool::transcode(const QString &str)
+{
+    static const char tab[] = "abfnrtv";
+    static const char backTab[] = "\a\b\f\n\r\t\v";
+    // This function has to convert back to bytes, as C's \0* sequences work at that level.
+    const QByteArray in = str.toUtf8();
+    QByteArray out;
+
+    out.reserve(in.length());
+    for (int i = 0; i < in.length();) {
+        uchar c = in[i++];
+        if (c == '\\') {
+            if (i >= in.length())
+                break;
+            c = in[i++];
+
+            if (c == '\n')
+                continue;
+
+            if (c == 'x' || c == 'u' || c == 'U') {
+                const bool unicode = (c != 'x');
+                QByteArray hex;
+                while (i < in.length() && isxdigit((c = in[i]))) {
+                    hex += c;
+                    i++;
+                }
+                if (unicode)
+                    out += QString(QChar(hex.toUInt(nullptr, 16))).toUtf8();
+                else
+                    out += hex.toUInt(nullptr, 16);
+            } else if (c >= '0' && c < '8') {
+                QByteArray oct;
+                int n = 0;
+                oct += c;
+                while (n < 2 && i < in.length() && (c = in[i]) >= '0' && c < '8') {
+                    i++;
+                    n++;
+                    oct += c;
+                }
+                out += oct.toUInt(0, 8);
+            } else {
+                const char *p = strchr(tab, c);
+                out += !p ? c : backTab[p - tab];
+            }
+        } else {
+            out += c;
+        }
+    }
+    return QString::fromUtf8(out.constData(), out.length());
+}
+
+QT_END_NAMESPACE
+
+QT_PREPEND_NAMESPACE(TrFunctionAliasManager) trFunctionAliasManager;
@@ -33,6 +33,7 @@
 
 #include <QtCore/QList>
 #include <QtCore/QHash>
+#include <QtCore/QSet>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
@@ -68,6 +69,8 @@ Translator merge(
     UpdateOptions options, QString &err);
 
 void loadCPP(Translator &translator, const QStringList &filenames, ConversionData &cd);
+// Makes the next loadCPP() parse the given files and the files including them again.
+void forgetCPP(const QSet<QString> &changedFiles);
 bool loadJava(Translator &translator, const QString &filename, ConversionData &cd);
 bool loadUI(Translator &translator, const QString &filename, ConversionData &cd);
 
@@ -131,12 +134,15 @@ public:
 
     QStringList availableFunctionsWithAliases() const;
 
+    static int trFunctionByDefaultName(const QString &trFunctionName);
+    static QStringList availableFunctions();
+
 private:
-    void ensureTrFunctionHashUpdated() const;
+    void updateTrFunctionHash();
 
 private:
     QStringList m_trFunctionAliases[NumTrFunctions];
-    mutable QHash<QString,TrFunction> m_nameToTrFunctionMap;
+    QHash<QString,TrFunction> m_nameToTrFunctionMap;
 };
 
 class LU {
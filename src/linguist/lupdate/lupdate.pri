@@ -0,0 +1,27 @@
+# The extractors and the merging of lupdate, shared with the benchmarks
+
+INCLUDEPATH *= $$PWD $$PWD/../shared
+
+qtHaveModule(qmldevtools-private) {
+    QT += qmldevtools-private
+} else {
+    DEFINES += QT_NO_QML
+}
+
+SOURCES += \
+    $$PWD/lupdate.cpp \
+    $$PWD/merge.cpp \
+    $$PWD/../shared/simtexth.cpp \
+    \
+    $$PWD/cpp.cpp \
+    $$PWD/extractioncache.cpp \
+    $$PWD/java.cpp \
+    $$PWD/ui.cpp
+
+qtHaveModule(qmldevtools-private): SOURCES += $$PWD/qdeclarative.cpp
+
+HEADERS += \
+    $$PWD/lupdate.h \
+    $$PWD/cpp.h \
+    $$PWD/extractioncache.h \
+    $$PWD/../shared/simtexth.h
@@ -1,37 +1,24 @@
 option(host_build)
 QT = core-private
 
-qtHaveModule(qmldevtools-private) {
-    QT += qmldevtools-private
-} else {
-    DEFINES += QT_NO_QML
-}
-
 DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII
 
 include(../shared/formats.pri)
+include(../shared/proparser.pri)
+include(lupdate.pri)
+
+DEFINES += PROEVALUATOR_THREAD_SAFE PROPARSER_THREAD_SAFE
 
 SOURCES += \
     main.cpp \
-    merge.cpp \
     ../shared/projectdescriptionreader.cpp \
-    ../shared/runqttool.cpp \
-    ../shared/qrcreader.cpp \
-    ../shared/simtexth.cpp \
-    \
-    cpp.cpp \
-    java.cpp \
-    ui.cpp
-
-qtHaveModule(qmldevtools-private): SOURCES += qdeclarative.cpp
+    ../shared/projectevaluator.cpp \
+    ../shared/qrcreader.cpp
 
 HEADERS += \
-    lupdate.h \
-    cpp.h \
     ../shared/projectdescriptionreader.h \
-    ../shared/qrcreader.h \
-    ../shared/runqttool.h \
-    ../shared/simtexth.h
+    ../shared/projectevaluator.h \
+    ../shared/qrcreader.h
 
 mingw {
     RC_FILE = lupdate.rc
@@ -28,165 +28,45 @@
 ****************************************************************************/
 
 #include "lupdate.h"
+#include "extractioncache.h"
 
 #include <profileutils.h>
 #include <projectdescriptionreader.h>
+#include <projectevaluator.h>
 #include <qrcreader.h>
-#include <runqttool.h>
 #include <translator.h>
 
+#include <QtCore/QBuffer>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QDirIterator>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
+#if QT_CONFIG(filesystemwatcher)
+#include <QtCore/QFileSystemWatcher>
+#endif
 #include <QtCore/QLibraryInfo>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QTimer>
 #include <QtCore/QTranslator>
+#include <QtCore/QVector>
 
 #include <iostream>
 
-// Can't have an array of QStaticStringData<N> for different N, so
-// use QString, which requires constructor calls. Doesn't matter
-// much, since this is in an app, not a lib:
-static const QString defaultTrFunctionNames[] = {
-// MSVC can't handle the lambda in this array if QStringLiteral expands
-// to a lambda. In that case, use a QString instead.
-#if defined(Q_CC_MSVC) && defined(Q_COMPILER_LAMBDA)
-#define STRINGLITERAL(F) QLatin1String(#F),
-#else
-#define STRINGLITERAL(F) QStringLiteral(#F),
-#endif
-    LUPDATE_FOR_EACH_TR_FUNCTION(STRINGLITERAL)
-#undef STRINGLITERAL
-};
-Q_STATIC_ASSERT((TrFunctionAliasManager::NumTrFunctions == sizeof defaultTrFunctionNames / sizeof *defaultTrFunctionNames));
-
-static int trFunctionByDefaultName(const QString &trFunctionName)
-{
-    for (int i = 0; i < TrFunctionAliasManager::NumTrFunctions; ++i)
-        if (trFunctionName == defaultTrFunctionNames[i])
-            return i;
-    return -1;
-}
-
-TrFunctionAliasManager::TrFunctionAliasManager()
-    : m_trFunctionAliases()
-{
-    for (int i = 0; i < NumTrFunctions; ++i)
-        m_trFunctionAliases[i].push_back(defaultTrFunctionNames[i]);
-}
-
-TrFunctionAliasManager::~TrFunctionAliasManager() {}
-
-int TrFunctionAliasManager::trFunctionByName(const QString &trFunctionName) const
-{
-    ensureTrFunctionHashUpdated();
-    // this function needs to be fast
-    const QHash<QString, TrFunction>::const_iterator it
-        = m_nameToTrFunctionMap.find(trFunctionName);
-    return it == m_nameToTrFunctionMap.end() ? -1 : *it;
-}
-
-void TrFunctionAliasManager::modifyAlias(int trFunction, const QString &alias, Operation op)
-{
-    QList<QString> &list = m_trFunctionAliases[trFunction];
-    if (op == SetAlias)
-        list.clear();
-    list.push_back(alias);
-    m_nameToTrFunctionMap.clear();
-}
-
-void TrFunctionAliasManager::ensureTrFunctionHashUpdated() const
-{
-    if (!m_nameToTrFunctionMap.empty())
-        return;
-
-    QHash<QString, TrFunction> nameToTrFunctionMap;
-    for (int i = 0; i < NumTrFunctions; ++i)
-        foreach (const QString &alias, m_trFunctionAliases[i])
-            nameToTrFunctionMap[alias] = TrFunction(i);
-    // commit:
-    m_nameToTrFunctionMap.swap(nameToTrFunctionMap);
-}
-
-static QStringList availableFunctions()
-{
-    QStringList result;
-    result.reserve(TrFunctionAliasManager::NumTrFunctions);
-    for (int i = 0; i < TrFunctionAliasManager::NumTrFunctions; ++i)
-        result.push_back(defaultTrFunctionNames[i]);
-    return result;
-}
-
-QStringList TrFunctionAliasManager::availableFunctionsWithAliases() const
-{
-    QStringList result;
-    result.reserve(NumTrFunctions);
-    for (int i = 0; i < NumTrFunctions; ++i)
-        result.push_back(defaultTrFunctionNames[i] +
-                         QLatin1String(" (=") +
-                         m_trFunctionAliases[i].join(QLatin1Char('=')) +
-                         QLatin1Char(')'));
-    return result;
-}
-
-TrFunctionAliasManager trFunctionAliasManager;
-
-QString ParserTool::transcode(const QString &str)
-{
-    static const char tab[] = "abfnrtv";
-    static const char backTab[] = "\a\b\f\n\r\t\v";
-    // This function has to convert back to bytes, as C's \0* sequences work at that level.
-    const QByteArray in = str.toUtf8();
-    QByteArray out;
-
-    out.reserve(in.length());
-    for (int i = 0; i < in.length();) {
-        uchar c = in[i++];
-        if (c == '\\') {
-            if (i >= in.length())
-                break;
-            c = in[i++];
-
-            if (c == '\n')
-                continue;
-
-            if (c == 'x' || c == 'u' || c == 'U') {
-                const bool unicode = (c != 'x');
-                QByteArray hex;
-                while (i < in.length() && isxdigit((c = in[i]))) {
-                    hex += c;
-                    i++;
-                }
-                if (unicode)
-                    out += QString(QChar(hex.toUInt(nullptr, 16))).toUtf8();
-                else
-                    out += hex.toUInt(nullptr, 16);
-            } else if (c >= '0' && c < '8') {
-                QByteArray oct;
-                int n = 0;
-                oct += c;
-                while (n < 2 && i < in.length() && (c = in[i]) >= '0' && c < '8') {
-                    i++;
-                    n++;
-                    oct += c;
-                }
-                out += oct.toUInt(0, 8);
-            } else {
-                const char *p = strchr(tab, c);
-                out += !p ? c : backTab[p - tab];
-            }
-        } else {
-            out += c;
-        }
-    }
-    return QString::fromUtf8(out.constData(), out.length());
-}
-
 static QString m_defaultExtensions;
 
+// In watch mode, the TS files as lupdate last read them.
+struct TsFileState {
+    QByteArray content;
+    Translator tor;
+};
+static bool m_watchMode = false;
+static QHash<QString, TsFileState> m_tsFileStates;
+
 static void printOut(const QString & out)
 {
     std::cout << qPrintable(out);
@@ -260,6 +140,8 @@ static void printUsage()
         "           Virtual output directory for processing subsequent .pro files.\n"
         "    -pro-debug\n"
         "           Trace processing .pro files. Specify twice for more verbosity.\n"
+        "    -cache-system\n"
+        "           Run each $$system() command in the .pro files only once.\n"
         "    -source-language <language>[_<region>]\n"
         "           Specify the language of the source strings for new files.\n"
         "           Defaults to POSIX if not specified.\n"
@@ -271,6 +153,20 @@ static void printUsage()
         "           With  =, recognize <alias> as the only spelling of <function>.\n"
         "           Available <function>s (with their currently defined aliases) are:\n"
         "             %2\n"
+        "    -cache-dir <directory>\n"
+        "           Keep the messages extracted from each source file in the given\n"
+        "           directory, and only parse files which changed since the last run.\n"
+        "           C++ files are considered changed if any file they include changed.\n"
+        "           The parsed .pro files are kept there as well.\n"
+        "    -watch\n"
+        "           Keep running after updating the TS files, and update them again\n"
+        "           whenever a source file or a file it includes changes. Only the\n"
+        "           changed files and the files including them are parsed again,\n"
+        "           and only TS files whose contents change are written.\n"
+        "    -threads <count>\n"
+        "           Parse C++, QML, JavaScript and UI sources using the given\n"
+        "           number of threads, and evaluate the sub-projects of .pro files\n"
+        "           concurrently. 0 means one thread per CPU core. Default: 1.\n"
         "    -ts <ts-file>...\n"
         "           Specify the output file(s). This will override the TRANSLATIONS.\n"
         "    -version\n"
@@ -295,11 +191,11 @@ static bool handleTrFunctionAliases(const QString &arg)
         const int trFunctionEnd = plusEqual ? equalSign-1 : equalSign;
         const QString trFunctionName = pair.left(trFunctionEnd).trimmed();
         const QString alias = pair.mid(equalSign+1).trimmed();
-        const int trFunction = trFunctionByDefaultName(trFunctionName);
+        const int trFunction = TrFunctionAliasManager::trFunctionByDefaultName(trFunctionName);
         if (trFunction < 0) {
             printErr(LU::tr("Unknown tr-function '%1' in -tr-function-alias option.\n"
                             "Available tr-functions are: %2")
-                     .arg(trFunctionName, availableFunctions().join(QLatin1Char(','))));
+                     .arg(trFunctionName, TrFunctionAliasManager::availableFunctions().join(QLatin1Char(','))));
             return false;
         }
         if (alias.isEmpty()) {
@@ -313,6 +209,61 @@ static bool handleTrFunctionAliases(const QString &arg)
     return true;
 }
 
+static bool loadTsFile(Translator *tor, const QString &fileName, ConversionData &cd)
+{
+    if (!m_watchMode)
+        return tor->load(fileName, cd, QLatin1String("auto"));
+
+    QByteArray content;
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly))
+        content = file.readAll();
+    QHash<QString, TsFileState>::ConstIterator it = m_tsFileStates.constFind(fileName);
+    if (it != m_tsFileStates.constEnd() && it->content == content) {
+        *tor = it->tor;
+        return true;
+    }
+    if (!tor->load(fileName, cd, QLatin1String("auto")))
+        return false;
+    TsFileState &state = m_tsFileStates[fileName];
+    state.content = content;
+    state.tor = *tor;
+    return true;
+}
+
+// In watch mode, files are only written if their contents change, so tools
+// watching them are not triggered needlessly.
+static bool saveTsFile(const Translator &tor, const QString &fileName, ConversionData &cd)
+{
+    if (m_watchMode) {
+        foreach (const Translator::FileFormat &fmt, Translator::registeredFileFormats()) {
+            if (!fmt.saver
+                || !fileName.endsWith(QLatin1Char('.') + fmt.extension, Qt::CaseInsensitive)) {
+                continue;
+            }
+            QByteArray content;
+            QBuffer buffer(&content);
+            buffer.open(QIODevice::WriteOnly);
+            cd.m_targetDir = QFileInfo(fileName).absoluteDir();
+            if (!fmt.saver(tor, buffer, cd))
+                return false;
+            buffer.close();
+
+            QFile file(fileName);
+            if (file.open(QIODevice::ReadOnly) && file.readAll() == content)
+                return true;
+            file.close();
+            if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+                cd.appendError(LU::tr("Cannot write %1: %2").arg(fileName, file.errorString()));
+                return false;
+            }
+            m_tsFileStates.remove(fileName);
+            return true;
+        }
+    }
+    return tor.save(fileName, cd, QLatin1String("auto"));
+}
+
 static void updateTsFiles(const Translator &fetchedTor, const QStringList &tsFileNames,
     const QStringList &alienFiles,
     const QString &sourceLanguage, const QString &targetLanguage,
@@ -346,7 +297,7 @@ static void updateTsFiles(const Translator &fetchedTor, const QStringList &tsFil
         Translator tor;
         cd.m_sortContexts = !(options & NoSort);
         if (QFile(fileName).exists()) {
-            if (!tor.load(fileName, cd, QLatin1String("auto"))) {
+            if (!loadTsFile(&tor, fileName, cd)) {
                 printErr(cd.error());
                 *fail = true;
                 continue;
@@ -415,7 +366,7 @@ static void updateTsFiles(const Translator &fetchedTor, const QStringList &tsFil
             printErr(cd.error());
             cd.clearErrors();
         }
-        if (!out.save(fileName, cd, QLatin1String("auto"))) {
+        if (!saveTsFile(out, fileName, cd)) {
             printErr(cd.error());
             *fail = true;
         }
@@ -466,7 +417,7 @@ static bool processTs(Translator &fetchedTor, const QString &file, ConversionDat
         if (file.endsWith(QLatin1Char('.') + fmt.extension, Qt::CaseInsensitive)) {
             Translator tor;
             if (tor.load(file, cd, fmt.extension)) {
-                foreach (TranslatorMessage msg, tor.messages()) {
+                foreach (TranslatorMessage msg, tor.constMessages()) {
                     msg.setType(TranslatorMessage::Unfinished);
                     msg.setTranslations(QStringList());
                     msg.setTranslatorComment(QString());
@@ -479,35 +430,120 @@ static bool processTs(Translator &fetchedTor, const QString &file, ConversionDat
     return false;
 }
 
+typedef bool (*SourceLoader)(Translator &translator, const QString &filename, ConversionData &cd);
+
+static void loadSource(SourceLoader loader, Translator &fetchedTor, const QString &file,
+                       ConversionData &cd, const QByteArray &cacheKey)
+{
+    if (!extractionCache.isEnabled()) {
+        loader(fetchedTor, file, cd);
+        return;
+    }
+
+    Translator tor;
+    if (!extractionCache.lookup(file, cacheKey, &tor)
+        && loader(tor, file, cd)) {
+        extractionCache.store(file, cacheKey, QSet<QString>(), QSet<QString>(), tor);
+    }
+    foreach (const TranslatorMessage &msg, tor.constMessages())
+        fetchedTor.extend(msg, cd);
+    if (!tor.extras().isEmpty())
+        fetchedTor.setExtras(tor.extras());
+}
+
+// The extraction of one non-C++ source file, into its own translator
+struct Extraction {
+    Extraction() : loader(0), concurrent(false) {}
+    QString fileName;
+    SourceLoader loader;
+    bool concurrent;
+    Translator tor;
+    ConversionData cd;
+};
+
 static void processSources(Translator &fetchedTor,
                            const QStringList &sourceFiles, ConversionData &cd)
 {
 #ifdef QT_NO_QML
     bool requireQmlSupport = false;
 #endif
+    const QByteArray cacheKey = extractionCache.isEnabled()
+            ? ExtractionCache::optionsKey(cd) : QByteArray();
     QStringList sourceFilesCpp;
+    QVector<Extraction> extractions;
     for (QStringList::const_iterator it = sourceFiles.begin(); it != sourceFiles.end(); ++it) {
-        if (it->endsWith(QLatin1String(".java"), Qt::CaseInsensitive))
-            loadJava(fetchedTor, *it, cd);
-        else if (it->endsWith(QLatin1String(".ui"), Qt::CaseInsensitive)
-                 || it->endsWith(QLatin1String(".jui"), Qt::CaseInsensitive))
-            loadUI(fetchedTor, *it, cd);
+        Extraction ex;
+        ex.fileName = *it;
+        ex.cd = cd;
+        ex.cd.clearErrors();
+        if (it->endsWith(QLatin1String(".java"), Qt::CaseInsensitive)) {
+            ex.loader = loadJava; // The Java parser keeps global state
+        } else if (it->endsWith(QLatin1String(".ui"), Qt::CaseInsensitive)
+                   || it->endsWith(QLatin1String(".jui"), Qt::CaseInsensitive)) {
+            ex.loader = loadUI;
+            ex.concurrent = true;
 #ifndef QT_NO_QML
-        else if (it->endsWith(QLatin1String(".js"), Qt::CaseInsensitive)
-                 || it->endsWith(QLatin1String(".qs"), Qt::CaseInsensitive))
-            loadQScript(fetchedTor, *it, cd);
-        else if (it->endsWith(QLatin1String(".qml"), Qt::CaseInsensitive))
-            loadQml(fetchedTor, *it, cd);
+        } else if (it->endsWith(QLatin1String(".js"), Qt::CaseInsensitive)
+                   || it->endsWith(QLatin1String(".qs"), Qt::CaseInsensitive)) {
+            ex.loader = loadQScript;
+            ex.concurrent = true;
+        } else if (it->endsWith(QLatin1String(".qml"), Qt::CaseInsensitive)) {
+            ex.loader = loadQml;
+            ex.concurrent = true;
 #else
-        else if (it->endsWith(QLatin1String(".qml"), Qt::CaseInsensitive)
-                 || it->endsWith(QLatin1String(".js"), Qt::CaseInsensitive)
-                 || it->endsWith(QLatin1String(".qs"), Qt::CaseInsensitive))
+        } else if (it->endsWith(QLatin1String(".qml"), Qt::CaseInsensitive)
+                   || it->endsWith(QLatin1String(".js"), Qt::CaseInsensitive)
+                   || it->endsWith(QLatin1String(".qs"), Qt::CaseInsensitive)) {
             requireQmlSupport = true;
+            continue;
 #endif // QT_NO_QML
-        else if (!processTs(fetchedTor, *it, cd))
+        } else if (!processTs(ex.tor, *it, ex.cd)) {
             sourceFilesCpp << *it;
+            continue;
+        }
+        extractions.append(ex);
     }
 
+    // Every file has its own translator and conversion data, so the files can
+    // be extracted concurrently. They are merged in the original order, so the
+    // result does not depend on thread scheduling.
+    Extraction *exData = extractions.data();
+#if QT_CONFIG(thread)
+    QThreadPool pool;
+    if (cd.m_threadCount > 1) {
+        pool.setMaxThreadCount(cd.m_threadCount);
+        for (int i = 0; i < extractions.size(); ++i) {
+            if (exData[i].loader && exData[i].concurrent) {
+                pool.start(QRunnable::create([exData, &cacheKey, i] {
+                    loadSource(exData[i].loader, exData[i].tor, exData[i].fileName,
+                               exData[i].cd, cacheKey);
+                }));
+            }
+        }
+    }
+#endif
+    for (int i = 0; i < extractions.size(); ++i) {
+        Extraction &ex = exData[i];
+        if (ex.loader && !(ex.concurrent && cd.m_threadCount > 1))
+            loadSource(ex.loader, ex.tor, ex.fileName, ex.cd, cacheKey);
+    }
+#if QT_CONFIG(thread)
+    pool.waitForDone();
+#endif
+
+    QList<const Translator *> tors;
+    for (int i = 0; i < extractions.size(); ++i)
+        tors.append(&exData[i].tor);
+    fetchedTor.extend(tors, cd);
+    for (int i = 0; i < extractions.size(); ++i) {
+        const Extraction &ex = exData[i];
+        if (!ex.tor.extras().isEmpty())
+            fetchedTor.setExtras(ex.tor.extras());
+        foreach (const QString &error, ex.cd.errors())
+            cd.appendError(error);
+    }
+    extractions.clear();
+
 #ifdef QT_NO_QML
     if (requireQmlSupport)
         printErr(LU::tr("lupdate warning: Some files have been ignored due to missing qml/javascript support\n"));
@@ -539,9 +575,11 @@ class ProjectProcessor
 {
 public:
     ProjectProcessor(const QString &sourceLanguage,
-                     const QString &targetLanguage)
+                     const QString &targetLanguage,
+                     int threadCount)
         : m_sourceLanguage(sourceLanguage),
-          m_targetLanguage(targetLanguage)
+          m_targetLanguage(targetLanguage),
+          m_threadCount(threadCount)
     {
     }
 
@@ -579,6 +617,7 @@ private:
         cd.m_includePath = prj.includePaths;
         cd.m_excludes = prj.excluded;
         cd.m_sourceIsUtf16 = options & SourceIsUtf16;
+        cd.m_threadCount = m_threadCount;
 
         QStringList tsFiles;
         if (hasTranslations(prj)) {
@@ -625,6 +664,7 @@ private:
 
     QString m_sourceLanguage;
     QString m_targetLanguage;
+    int m_threadCount;
 };
 
 int main(int argc, char **argv)
@@ -649,8 +689,8 @@ int main(int argc, char **argv)
     QStringList args = app.arguments();
     QStringList tsFileNames;
     QStringList proFiles;
+    QStringList projectOptions; // For evaluating proFiles, in their original order
     QString projectDescriptionFile;
-    QString outDir = QDir::currentPath();
     QMultiHash<QString, QString> allCSources;
     QSet<QString> projectRoots;
     QStringList sourceFiles;
@@ -663,8 +703,8 @@ int main(int argc, char **argv)
     UpdateOptions options =
         Verbose | // verbose is on by default starting with Qt 4.2
         HeuristicSameText | HeuristicSimilarText | HeuristicNumber;
-    int proDebug = 0;
     int numFiles = 0;
+    int threadCount = 1;
     bool metTsFlag = false;
     bool metXTsFlag = false;
     bool recursiveScan = true;
@@ -691,9 +731,11 @@ int main(int argc, char **argv)
             continue;
         } else if (arg == QLatin1String("-silent")) {
             options &= ~Verbose;
+            projectOptions << arg;
             continue;
-        } else if (arg == QLatin1String("-pro-debug")) {
-            proDebug++;
+        } else if (arg == QLatin1String("-pro-debug")
+                   || arg == QLatin1String("-cache-system")) {
+            projectOptions << arg;
             continue;
         } else if (arg == QLatin1String("-project")) {
             ++i;
@@ -742,6 +784,44 @@ int main(int argc, char **argv)
                 return 1;
             }
             continue;
+        } else if (arg == QLatin1String("-threads")) {
+            ++i;
+            if (i == argc) {
+                printErr(LU::tr("The option -threads requires a parameter.\n"));
+                return 1;
+            }
+            bool ok;
+            threadCount = args[i].toInt(&ok);
+            if (!ok || threadCount < 0) {
+                printErr(LU::tr("Invalid parameter passed to -threads.\n"));
+                return 1;
+            }
+            if (threadCount == 0)
+                threadCount = QThread::idealThreadCount();
+            projectOptions << arg << args[i];
+            continue;
+        } else if (arg == QLatin1String("-watch")
+                   || arg == QLatin1String("--watch")) {
+#if QT_CONFIG(filesystemwatcher)
+            m_watchMode = true;
+            continue;
+#else
+            printErr(LU::tr("The option -watch is not supported on this platform.\n"));
+            return 1;
+#endif
+        } else if (arg == QLatin1String("-cache-dir")) {
+            ++i;
+            if (i == argc) {
+                printErr(LU::tr("The option -cache-dir requires a parameter.\n"));
+                return 1;
+            }
+            QString errorString;
+            if (!extractionCache.setDirectory(args[i], &errorString)) {
+                printErr(LU::tr("lupdate error: %1\n").arg(errorString));
+                return 1;
+            }
+            projectOptions << arg << args[i];
+            continue;
         } else if (arg == QLatin1String("-locations")) {
             ++i;
             if (i == argc) {
@@ -811,6 +891,7 @@ int main(int argc, char **argv)
             }
             QString file = QDir::cleanPath(QFileInfo(args[i]).absoluteFilePath());
             proFiles += file;
+            projectOptions << arg << file;
             numFiles++;
             continue;
         } else if (arg == QLatin1String("-pro-out")) {
@@ -819,7 +900,7 @@ int main(int argc, char **argv)
                 printErr(LU::tr("The -pro-out option should be followed by a directory name.\n"));
                 return 1;
             }
-            outDir = QDir::cleanPath(QFileInfo(args[i]).absoluteFilePath());
+            projectOptions << arg << args[i];
             continue;
         } else if (arg.startsWith(QLatin1String("-I"))) {
             if (arg.length() == 2) {
@@ -897,6 +978,7 @@ int main(int argc, char **argv)
                 if (isProOrPriFile(file)) {
                     QString cleanFile = QDir::cleanPath(fi.absoluteFilePath());
                     proFiles << cleanFile;
+                    projectOptions << cleanFile;
                 } else if (fi.isDir()) {
                     if (options & Verbose)
                         printOut(LU::tr("Scanning directory '%1'...\n").arg(file));
@@ -962,13 +1044,23 @@ int main(int argc, char **argv)
                         " makes sense with exactly one TS file.\n"));
 
     QString errorString;
-    if (!proFiles.isEmpty()) {
-        runQtTool(QStringLiteral("lupdate-pro"), app.arguments().mid(1));
-        return 0;
-    }
-
     Projects projectDescription;
-    if (!projectDescriptionFile.isEmpty()) {
+    if (!proFiles.isEmpty()) {
+        if (!projectDescriptionFile.isEmpty()) {
+            printErr(LU::tr("lupdate error: Do not specify .pro files if -project is given.\n"));
+            return 1;
+        }
+        // The projects are evaluated in this process and go straight to the extraction.
+        ProjectEvaluationOptions evaluationOptions;
+        if (!parseProjectArguments(projectOptions, &evaluationOptions, &errorString)) {
+            printErr(errorString);
+            return 1;
+        }
+        bool fail = false;
+        projectDescription = evaluateProjects(evaluationOptions, &fail);
+        if (fail)
+            return 1;
+    } else if (!projectDescriptionFile.isEmpty()) {
         projectDescription = readProjectDescription(projectDescriptionFile, &errorString);
         if (!errorString.isEmpty()) {
             printErr(LU::tr("lupdate error: %1\n").arg(errorString));
@@ -982,44 +1074,103 @@ int main(int argc, char **argv)
         }
     }
 
-    bool fail = false;
-    if (projectDescription.empty()) {
-        if (tsFileNames.isEmpty())
-            printErr(LU::tr("lupdate warning:"
-                            " no TS files specified. Only diagnostics will be produced.\n"));
+    if (!projectDescription.empty()
+        && (!sourceFiles.isEmpty() || !resourceFiles.isEmpty() || !includePath.isEmpty())) {
+        printErr(LU::tr("lupdate error:"
+                        " Both project and source files / include paths specified.\n"));
+        return 1;
+    }
+
+    // Watching needs the dependencies recorded by the extraction cache.
+    if (m_watchMode)
+        extractionCache.setInMemory();
+
+    auto updateTranslations = [&]() {
+        bool fail = false;
+        if (projectDescription.empty()) {
+            if (tsFileNames.isEmpty())
+                printErr(LU::tr("lupdate warning:"
+                                " no TS files specified. Only diagnostics will be produced.\n"));
 
-        Translator fetchedTor;
-        ConversionData cd;
-        cd.m_noUiLines = options & NoUiLines;
-        cd.m_sourceIsUtf16 = options & SourceIsUtf16;
-        cd.m_projectRoots = projectRoots;
-        cd.m_includePath = includePath;
-        cd.m_allCSources = allCSources;
-        for (const QString &resource : qAsConst(resourceFiles))
-            sourceFiles << getResources(resource);
-        processSources(fetchedTor, sourceFiles, cd);
-        updateTsFiles(fetchedTor, tsFileNames, alienFiles,
-                      sourceLanguage, targetLanguage, options, &fail);
-    } else {
-        if (!sourceFiles.isEmpty() || !resourceFiles.isEmpty() || !includePath.isEmpty()) {
-            printErr(LU::tr("lupdate error:"
-                            " Both project and source files / include paths specified.\n"));
-            return 1;
-        }
-        QString errorString;
-        ProjectProcessor projectProcessor(sourceLanguage, targetLanguage);
-        if (!tsFileNames.isEmpty()) {
             Translator fetchedTor;
-            projectProcessor.processProjects(true, options, projectDescription, true, &fetchedTor,
-                                             &fail);
-            if (!fail) {
-                updateTsFiles(fetchedTor, tsFileNames, alienFiles,
-                              sourceLanguage, targetLanguage, options, &fail);
-            }
+            ConversionData cd;
+            cd.m_noUiLines = options & NoUiLines;
+            cd.m_sourceIsUtf16 = options & SourceIsUtf16;
+            cd.m_projectRoots = projectRoots;
+            cd.m_includePath = includePath;
+            cd.m_allCSources = allCSources;
+            cd.m_threadCount = threadCount;
+            QStringList allSourceFiles = sourceFiles;
+            for (const QString &resource : qAsConst(resourceFiles))
+                allSourceFiles << getResources(resource);
+            processSources(fetchedTor, allSourceFiles, cd);
+            updateTsFiles(fetchedTor, tsFileNames, alienFiles,
+                          sourceLanguage, targetLanguage, options, &fail);
         } else {
-            projectProcessor.processProjects(true, options, projectDescription, false, nullptr,
-                                             &fail);
+            ProjectProcessor projectProcessor(sourceLanguage, targetLanguage, threadCount);
+            if (!tsFileNames.isEmpty()) {
+                Translator fetchedTor;
+                projectProcessor.processProjects(true, options, projectDescription, true,
+                                                 &fetchedTor, &fail);
+                if (!fail) {
+                    updateTsFiles(fetchedTor, tsFileNames, alienFiles,
+                                  sourceLanguage, targetLanguage, options, &fail);
+                }
+            } else {
+                projectProcessor.processProjects(true, options, projectDescription, false,
+                                                 nullptr, &fail);
+            }
         }
-    }
+        return fail;
+    };
+
+    bool fail = updateTranslations();
+    if (!m_watchMode)
+        return fail ? 1 : 0;
+
+#if QT_CONFIG(filesystemwatcher)
+    QFileSystemWatcher watcher;
+    // Editors often save by replacing the file, which ends its watch, so the
+    // files are added back after each update.
+    auto watchFiles = [&]() {
+        const QStringList watched = watcher.files();
+        QSet<QString> files(watched.cbegin(), watched.cend());
+        QStringList newFiles;
+        const QStringList candidates = extractionCache.trackedFiles() + sourceFiles
+                + resourceFiles;
+        for (const QString &file : candidates) {
+            if (!files.contains(file) && QFile::exists(file)) {
+                files.insert(file);
+                newFiles << file;
+            }
+        }
+        if (!newFiles.isEmpty())
+            watcher.addPaths(newFiles);
+        if (options & Verbose)
+            printOut(LU::tr("Watching %n file(s) for changes...\n", 0, files.count()));
+    };
+
+    // Changes usually come in bursts, e.g. when switching branches.
+    QSet<QString> changedFiles;
+    QTimer updateTimer;
+    updateTimer.setSingleShot(true);
+    updateTimer.setInterval(300);
+    QObject::connect(&watcher, &QFileSystemWatcher::fileChanged, [&](const QString &fileName) {
+        changedFiles.insert(fileName);
+        updateTimer.start();
+    });
+    QObject::connect(&updateTimer, &QTimer::timeout, [&]() {
+        if (options & Verbose)
+            printOut(LU::tr("%n file(s) changed.\n", 0, changedFiles.count()));
+        forgetCPP(changedFiles);
+        extractionCache.forget(changedFiles);
+        changedFiles.clear();
+        updateTranslations();
+        watchFiles();
+    });
+    watchFiles();
+    return app.exec();
+#else
     return fail ? 1 : 0;
+#endif
 }
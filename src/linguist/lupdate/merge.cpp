@@ -325,7 +325,7 @@ Translator merge(
       The types of all the messages from the vernacular translator
       are updated according to the virgin translator.
     */
-    foreach (TranslatorMessage m, tor.messages()) {
+    foreach (TranslatorMessage m, tor.constMessages()) {
         TranslatorMessage::Type newType = TranslatorMessage::Finished;
 
         if (m.sourceText().isEmpty() && m.id().isEmpty()) {
@@ -444,9 +444,11 @@ Translator merge(
 
     /*
       Messages found only in the virgin translator are added to the
-      vernacular translator.
+      vernacular translator. Only tor and virginTor are consulted while
+      doing so, so the sorted insertions into outTor can be deferred.
     */
-    foreach (const TranslatorMessage &mv, virginTor.messages()) {
+    outTor.beginSortedAppends();
+    foreach (const TranslatorMessage &mv, virginTor.constMessages()) {
         if (mv.sourceText().isEmpty() && mv.id().isEmpty()) {
             if (tor.find(mv.context()) >= 0)
                 continue;
@@ -473,12 +475,13 @@ Translator merge(
         if (!mv.sourceText().isEmpty() || !mv.id().isEmpty())
             ++neww;
     }
+    outTor.endSortedAppends();
 
     /*
       "Alien" translators can be used to augment the vernacular translator.
     */
     foreach (const Translator &alf, aliens) {
-        foreach (TranslatorMessage mv, alf.messages()) {
+        foreach (TranslatorMessage mv, alf.constMessages()) {
             if (mv.sourceText().isEmpty() || !mv.isTranslated())
                 continue;
             int mvi = outTor.find(mv);
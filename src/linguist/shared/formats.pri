@@ -7,6 +7,7 @@ SOURCES += \
     $$PWD/xmlparser.cpp
 
 HEADERS += \
+    $$PWD/qmview.h \
     $$PWD/translator.h \
     $$PWD/translatormessage.h \
     $$PWD/xmlparser.h
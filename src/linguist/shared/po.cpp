@@ -211,13 +211,57 @@ static bool isTranslationLine(const QByteArray &line)
     return line.startsWith("#~ msgstr") || line.startsWith("msgstr");
 }
 
-static QByteArray slurpEscapedString(const QList<QByteArray> &lines, int &l,
+// The lines of a PO file, read on demand. Lookahead never reaches beyond the
+// current entry, so the lines of the entries already converted can be dropped.
+class PoLines
+{
+public:
+    PoLines(QIODevice &dev) : m_dev(dev), m_first(0), m_done(false) {}
+
+    bool has(int l)
+    {
+        while (l - m_first >= m_lines.size()) {
+            if (m_dev.atEnd()) {
+                if (m_done)
+                    return false;
+                // Terminates the last entry
+                m_lines.append(QByteArray());
+                m_done = true;
+            } else {
+                m_lines.append(m_dev.readLine().trimmed());
+            }
+        }
+        return true;
+    }
+    const QByteArray &at(int l) const { return m_lines.at(l - m_first); }
+    // Only the lines which have not been dropped yet
+    QList<QByteArray> mid(int l, int n) const
+    {
+        int from = qMax(l, m_first);
+        if (from >= l + n)
+            return QList<QByteArray>();
+        return m_lines.mid(from - m_first, l + n - from);
+    }
+    void discardBefore(int l)
+    {
+        for (; m_first < l && !m_lines.isEmpty(); ++m_first)
+            m_lines.removeFirst();
+    }
+
+private:
+    QIODevice &m_dev;
+    QList<QByteArray> m_lines;
+    int m_first;
+    bool m_done;
+};
+
+static QByteArray slurpEscapedString(PoLines &lines, int &l,
         int offset, const QByteArray &prefix, ConversionData &cd)
 {
     QByteArray msg;
     int stoff;
 
-    for (; l < lines.size(); ++l) {
+    for (; lines.has(l); ++l) {
         const QByteArray &line = lines.at(l);
         if (line.isEmpty() || !line.startsWith(prefix))
             break;
@@ -319,7 +363,7 @@ premature_eol:
     return QByteArray();
 }
 
-static void slurpComment(QByteArray &msg, const QList<QByteArray> &lines, int & l)
+static void slurpComment(QByteArray &msg, PoLines &lines, int & l)
 {
     int firstLine = l;
     QByteArray prefix = lines.at(l);
@@ -329,7 +373,7 @@ static void slurpComment(QByteArray &msg, const QList<QByteArray> &lines, int &
             break;
         }
     }
-    for (; l < lines.size(); ++l) {
+    for (; lines.has(l); ++l) {
         const QByteArray &line = lines.at(l);
         if (line.startsWith(prefix)) {
             if (l > firstLine)
@@ -419,15 +463,12 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
     // ...
 
     // we need line based lookahead below.
-    QList<QByteArray> lines;
-    while (!dev.atEnd())
-        lines.append(dev.readLine().trimmed());
-    lines.append(QByteArray());
+    PoLines lines(dev);
 
     int l = 0, lastCmtLine = -1;
     bool qtContexts = false;
     PoItem item;
-    for (; l != lines.size(); ++l) {
+    for (; lines.has(l); ++l) {
         QByteArray line = lines.at(l);
         if (line.isEmpty())
            continue;
@@ -438,7 +479,7 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
                 int idx = line.indexOf(' ', prefix.length());
                 QByteArray str = slurpEscapedString(lines, l, idx, prefix, cd);
                 item.msgStr.append(str);
-                if (l + 1 >= lines.size() || !isTranslationLine(lines.at(l + 1)))
+                if (!lines.has(l + 1) || !isTranslationLine(lines.at(l + 1)))
                     break;
                 ++l;
                 line = lines.at(l);
@@ -598,6 +639,7 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
             //qDebug() << flags << msg.m_extra;
             translator.append(msg);
             item = PoItem();
+            lines.discardBefore(l + 1);
         } else if (line.startsWith('#')) {
             switch (line.size() < 2 ? 0 : line.at(1)) {
                 case ':':
@@ -649,7 +691,7 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
                             splitContext(&item.oldTscomment, &item.context);
                     } else {
                         cd.appendError(QString(QLatin1String("PO-format parse error in line %1: '%2'"))
-                            .arg(l + 1).arg(codec->toUnicode(lines[l])));
+                            .arg(l + 1).arg(codec->toUnicode(lines.at(l))));
                         error = true;
                     }
                     break;
@@ -679,13 +721,13 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
                             splitContext(&item.oldTscomment, &item.context);
                     } else {
                         cd.appendError(QString(QLatin1String("PO-format parse error in line %1: '%2'"))
-                            .arg(l + 1).arg(codec->toUnicode(lines[l])));
+                            .arg(l + 1).arg(codec->toUnicode(lines.at(l))));
                         error = true;
                     }
                     break;
                 default:
                     cd.appendError(QString(QLatin1String("PO-format parse error in line %1: '%2'"))
-                        .arg(l + 1).arg(codec->toUnicode(lines[l])));
+                        .arg(l + 1).arg(codec->toUnicode(lines.at(l))));
                     error = true;
                     break;
             }
@@ -703,7 +745,7 @@ bool loadPO(Translator &translator, QIODevice &dev, ConversionData &cd)
             item.isPlural = true;
         } else {
             cd.appendError(QString(QLatin1String("PO-format error in line %1: '%2'"))
-                .arg(l + 1).arg(codec->toUnicode(lines[l])));
+                .arg(l + 1).arg(codec->toUnicode(lines.at(l))));
             error = true;
         }
     }
@@ -729,20 +771,29 @@ static QString escapeComment(const QString &in, bool escape)
     return out;
 }
 
-bool savePO(const Translator &translator, QIODevice &dev, ConversionData &)
+class POWriter : public TranslatorStreamWriter
 {
-    QString str_format = QLatin1String("-format");
+public:
+    // The messages are written with qt contexts if the header declares them
+    POWriter(QIODevice &dev, bool qtContexts)
+        : m_stream(&dev), m_qtContexts(qtContexts)
+    {
+        m_stream.setCodec("UTF-8");
+    }
 
-    bool ok = true;
-    QTextStream out(&dev);
-    out.setCodec("UTF-8");
+    void writeHeader(const Translator &translator) override;
+    void writeMessage(const TranslatorMessage &msg) override;
+    bool finish() override { return true; }
 
-    bool qtContexts = false;
-    foreach (const TranslatorMessage &msg, translator.messages())
-        if (!msg.context().isEmpty()) {
-            qtContexts = true;
-            break;
-        }
+private:
+    QTextStream m_stream;
+    bool m_qtContexts;
+};
+
+void POWriter::writeHeader(const Translator &translator)
+{
+    QTextStream &out = m_stream;
+    bool qtContexts = m_qtContexts;
 
     QString cmt = translator.extra(QLatin1String("po-header_comment"));
     if (!cmt.isEmpty())
@@ -777,106 +828,133 @@ bool savePO(const Translator &translator, QIODevice &dev, ConversionData &)
         hdrStr += QLatin1Char('\n');
     }
     out << poEscapedString(QString(), QString::fromLatin1("msgstr"), true, hdrStr);
+}
 
-    foreach (const TranslatorMessage &msg, translator.messages()) {
-        out << Qt::endl;
+void POWriter::writeMessage(const TranslatorMessage &msg)
+{
+    QString str_format = QLatin1String("-format");
+    QTextStream &out = m_stream;
+    bool qtContexts = m_qtContexts;
 
-        if (!msg.translatorComment().isEmpty())
-            out << poEscapedLines(QLatin1String("#"), true, msg.translatorComment());
+    out << Qt::endl;
 
-        if (!msg.extraComment().isEmpty())
-            out << poEscapedLines(QLatin1String("#."), true, msg.extraComment());
+    if (!msg.translatorComment().isEmpty())
+        out << poEscapedLines(QLatin1String("#"), true, msg.translatorComment());
 
-        if (!msg.id().isEmpty())
-            out << QLatin1String("#. ts-id ") << msg.id() << '\n';
+    if (!msg.extraComment().isEmpty())
+        out << poEscapedLines(QLatin1String("#."), true, msg.extraComment());
 
-        QString xrefs = msg.extra(QLatin1String("po-references"));
-        if (!msg.fileName().isEmpty() || !xrefs.isEmpty()) {
-            QStringList refs;
-            foreach (const TranslatorMessage::Reference &ref, msg.allReferences())
-                refs.append(QString(QLatin1String("%2:%1"))
-                                    .arg(ref.lineNumber()).arg(ref.fileName()));
-            if (!xrefs.isEmpty())
-                refs << xrefs;
-            out << poWrappedEscapedLines(QLatin1String("#:"), true, refs.join(QLatin1Char(' ')));
-        }
+    if (!msg.id().isEmpty())
+        out << QLatin1String("#. ts-id ") << msg.id() << '\n';
 
-        bool noWrap = false;
-        bool skipFormat = false;
-        QStringList flags;
-        if ((msg.type() == TranslatorMessage::Unfinished
-             || msg.type() == TranslatorMessage::Obsolete) && msg.isTranslated())
-            flags.append(QLatin1String("fuzzy"));
-        TranslatorMessage::ExtraData::const_iterator itr =
-                msg.extras().find(QLatin1String("po-flags"));
-        if (itr != msg.extras().end()) {
-            QStringList atoms = itr->split(QLatin1String(", "));
-            foreach (const QString &atom, atoms)
-                if (atom.endsWith(str_format)) {
-                    skipFormat = true;
-                    break;
-                }
-            if (atoms.contains(QLatin1String("no-wrap")))
-                noWrap = true;
-            flags.append(*itr);
-        }
-        if (!skipFormat) {
-            QString source = msg.sourceText();
-            // This is fuzzy logic, as we don't know whether the string is
-            // actually used with QString::arg().
-            for (int off = 0; (off = source.indexOf(QLatin1Char('%'), off)) >= 0; ) {
-                if (++off >= source.length())
-                    break;
-                if (source.at(off) == QLatin1Char('n') || source.at(off).isDigit()) {
-                    flags.append(QLatin1String("qt-format"));
-                    break;
-                }
+    QString xrefs = msg.extra(QLatin1String("po-references"));
+    if (!msg.fileName().isEmpty() || !xrefs.isEmpty()) {
+        QStringList refs;
+        foreach (const TranslatorMessage::Reference &ref, msg.allReferences())
+            refs.append(QString(QLatin1String("%2:%1"))
+                                .arg(ref.lineNumber()).arg(ref.fileName()));
+        if (!xrefs.isEmpty())
+            refs << xrefs;
+        out << poWrappedEscapedLines(QLatin1String("#:"), true, refs.join(QLatin1Char(' ')));
+    }
+
+    bool noWrap = false;
+    bool skipFormat = false;
+    QStringList flags;
+    if ((msg.type() == TranslatorMessage::Unfinished
+         || msg.type() == TranslatorMessage::Obsolete) && msg.isTranslated())
+        flags.append(QLatin1String("fuzzy"));
+    TranslatorMessage::ExtraData::const_iterator itr =
+            msg.extras().find(QLatin1String("po-flags"));
+    if (itr != msg.extras().end()) {
+        QStringList atoms = itr->split(QLatin1String(", "));
+        foreach (const QString &atom, atoms)
+            if (atom.endsWith(str_format)) {
+                skipFormat = true;
+                break;
             }
-        }
-        if (!flags.isEmpty())
-            out << "#, " << flags.join(QLatin1String(", ")) << '\n';
-
-        bool isObsolete = (msg.type() == TranslatorMessage::Obsolete
-                           || msg.type() == TranslatorMessage::Vanished);
-        QString prefix = QLatin1String(isObsolete ? "#~| " : "#| ");
-        if (!msg.oldComment().isEmpty())
-            out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
-                                   escapeComment(msg.oldComment(), qtContexts));
-        if (!msg.oldSourceText().isEmpty())
-            out << poEscapedString(prefix, QLatin1String("msgid"), noWrap, msg.oldSourceText());
-        QString plural = msg.extra(QLatin1String("po-old_msgid_plural"));
-        if (!plural.isEmpty())
-            out << poEscapedString(prefix, QLatin1String("msgid_plural"), noWrap, plural);
-        prefix = QLatin1String(isObsolete ? "#~ " : "");
-        if (!msg.context().isEmpty())
-            out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
-                                   escapeComment(msg.context(), true) + QLatin1Char('|')
-                                   + escapeComment(msg.comment(), true));
-        else if (!msg.comment().isEmpty())
-            out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
-                                   escapeComment(msg.comment(), qtContexts));
-        out << poEscapedString(prefix, QLatin1String("msgid"), noWrap, msg.sourceText());
-        if (!msg.isPlural()) {
-            QString transl = msg.translation();
-            transl.replace(QChar(Translator::BinaryVariantSeparator),
-                           QChar(Translator::TextVariantSeparator));
-            out << poEscapedString(prefix, QLatin1String("msgstr"), noWrap, transl);
-        } else {
-            QString plural = msg.extra(QLatin1String("po-msgid_plural"));
-            if (plural.isEmpty())
-                plural = msg.sourceText();
-            out << poEscapedString(prefix, QLatin1String("msgid_plural"), noWrap, plural);
-            const QStringList &translations = msg.translations();
-            for (int i = 0; i != translations.size(); ++i) {
-                QString str = translations.at(i);
-                str.replace(QChar(Translator::BinaryVariantSeparator),
-                            QChar(Translator::TextVariantSeparator));
-                out << poEscapedString(prefix, QString::fromLatin1("msgstr[%1]").arg(i), noWrap,
-                                       str);
+        if (atoms.contains(QLatin1String("no-wrap")))
+            noWrap = true;
+        flags.append(*itr);
+    }
+    if (!skipFormat) {
+        QString source = msg.sourceText();
+        // This is fuzzy logic, as we don't know whether the string is
+        // actually used with QString::arg().
+        for (int off = 0; (off = source.indexOf(QLatin1Char('%'), off)) >= 0; ) {
+            if (++off >= source.length())
+                break;
+            if (source.at(off) == QLatin1Char('n') || source.at(off).isDigit()) {
+                flags.append(QLatin1String("qt-format"));
+                break;
             }
         }
     }
-    return ok;
+    if (!flags.isEmpty())
+        out << "#, " << flags.join(QLatin1String(", ")) << '\n';
+
+    bool isObsolete = (msg.type() == TranslatorMessage::Obsolete
+                       || msg.type() == TranslatorMessage::Vanished);
+    QString prefix = QLatin1String(isObsolete ? "#~| " : "#| ");
+    if (!msg.oldComment().isEmpty())
+        out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
+                               escapeComment(msg.oldComment(), qtContexts));
+    if (!msg.oldSourceText().isEmpty())
+        out << poEscapedString(prefix, QLatin1String("msgid"), noWrap, msg.oldSourceText());
+    QString plural = msg.extra(QLatin1String("po-old_msgid_plural"));
+    if (!plural.isEmpty())
+        out << poEscapedString(prefix, QLatin1String("msgid_plural"), noWrap, plural);
+    prefix = QLatin1String(isObsolete ? "#~ " : "");
+    if (!msg.context().isEmpty())
+        out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
+                               escapeComment(msg.context(), true) + QLatin1Char('|')
+                               + escapeComment(msg.comment(), true));
+    else if (!msg.comment().isEmpty())
+        out << poEscapedString(prefix, QLatin1String("msgctxt"), noWrap,
+                               escapeComment(msg.comment(), qtContexts));
+    out << poEscapedString(prefix, QLatin1String("msgid"), noWrap, msg.sourceText());
+    if (!msg.isPlural()) {
+        QString transl = msg.translation();
+        transl.replace(QChar(Translator::BinaryVariantSeparator),
+                       QChar(Translator::TextVariantSeparator));
+        out << poEscapedString(prefix, QLatin1String("msgstr"), noWrap, transl);
+    } else {
+        QString plural = msg.extra(QLatin1String("po-msgid_plural"));
+        if (plural.isEmpty())
+            plural = msg.sourceText();
+        out << poEscapedString(prefix, QLatin1String("msgid_plural"), noWrap, plural);
+        const QStringList &translations = msg.translations();
+        for (int i = 0; i != translations.size(); ++i) {
+            QString str = translations.at(i);
+            str.replace(QChar(Translator::BinaryVariantSeparator),
+                        QChar(Translator::TextVariantSeparator));
+            out << poEscapedString(prefix, QString::fromLatin1("msgstr[%1]").arg(i), noWrap,
+                                   str);
+        }
+    }
+}
+
+bool savePO(const Translator &translator, QIODevice &dev, ConversionData &)
+{
+    bool qtContexts = false;
+    foreach (const TranslatorMessage &msg, translator.constMessages())
+        if (!msg.context().isEmpty()) {
+            qtContexts = true;
+            break;
+        }
+
+    POWriter writer(dev, qtContexts);
+    writer.writeHeader(translator);
+    foreach (const TranslatorMessage &msg, translator.constMessages())
+        writer.writeMessage(msg);
+    return writer.finish();
+}
+
+// The header is written before any message is seen, so it always declares
+// qt contexts. The escaping this implies is undone when loading.
+static TranslatorStreamWriter *createPOWriter(QIODevice &dev, ConversionData &)
+{
+    return new POWriter(dev, true);
 }
 
 static bool savePOT(const Translator &translator, QIODevice &dev, ConversionData &cd)
@@ -893,6 +971,7 @@ int initPO()
     format.untranslatedDescription = QT_TRANSLATE_NOOP("FMT", "GNU Gettext localization files");
     format.loader = &loadPO;
     format.saver = &savePO;
+    format.streamWriter = &createPOWriter;
     format.fileType = Translator::FileFormat::TranslationSource;
     format.priority = 1;
     Translator::registerFileFormat(format);
@@ -0,0 +1,505 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "projectevaluator.h"
+
+#include <profileevaluator.h>
+#include <profileutils.h>
+#include <qmakeparser.h>
+#include <qmakevfs.h>
+#include <qrcreader.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QDirIterator>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QMutex>
+#include <QtCore/QRegExp>
+#include <QtCore/QRunnable>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QVector>
+
+#include <algorithm>
+#include <iostream>
+
+class LD {
+    Q_DECLARE_TR_FUNCTIONS(LProDump)
+};
+
+static QMutex printMutex;
+
+static void printErr(const QString &out)
+{
+    // Sub-projects are evaluated concurrently; keep the messages in one piece.
+    QMutexLocker locker(&printMutex);
+    std::cerr << qPrintable(out);
+}
+
+static void print(const QString &fileName, int lineNo, const QString &msg)
+{
+    if (lineNo > 0)
+        printErr(QString::fromLatin1("WARNING: %1:%2: %3\n").arg(fileName, QString::number(lineNo), msg));
+    else if (lineNo)
+        printErr(QString::fromLatin1("WARNING: %1: %2\n").arg(fileName, msg));
+    else
+        printErr(QString::fromLatin1("WARNING: %1\n").arg(msg));
+}
+
+class EvalHandler : public QMakeHandler {
+public:
+    virtual void message(int type, const QString &msg, const QString &fileName, int lineNo)
+    {
+        if (verbose && !(type & CumulativeEvalMessage) && (type & CategoryMask) == ErrorMessage)
+            print(fileName, lineNo, msg);
+    }
+
+    virtual void fileMessage(int type, const QString &msg)
+    {
+        if (verbose && !(type & CumulativeEvalMessage) && (type & CategoryMask) == ErrorMessage) {
+            // "Downgrade" errors, as we don't really care for them
+            printErr(QLatin1String("WARNING: ") + msg + QLatin1Char('\n'));
+        }
+    }
+
+    virtual void aboutToEval(ProFile *, ProFile *, EvalFileType) {}
+    virtual void doneWithEval(ProFile *) {}
+
+    bool verbose = true;
+};
+
+static bool isSupportedExtension(const QString &ext)
+{
+    return ext == QLatin1String("qml")
+        || ext == QLatin1String("js") || ext == QLatin1String("qs")
+        || ext == QLatin1String("ui") || ext == QLatin1String("jui");
+}
+
+static QStringList getResources(const QString &resourceFile, QMakeVfs *vfs)
+{
+    Q_ASSERT(vfs);
+    if (!vfs->exists(resourceFile, QMakeVfs::VfsCumulative))
+        return QStringList();
+    QString content;
+    QString errStr;
+    if (vfs->readFile(vfs->idForFileName(resourceFile, QMakeVfs::VfsCumulative),
+                      &content, &errStr) != QMakeVfs::ReadOk) {
+        printErr(LD::tr("lprodump error: Cannot read %1: %2\n").arg(resourceFile, errStr));
+        return QStringList();
+    }
+    const ReadQrcResult rqr = readQrcFile(resourceFile, content);
+    if (rqr.hasError()) {
+        printErr(LD::tr("lprodump error: %1:%2: %3\n")
+                 .arg(resourceFile, QString::number(rqr.line), rqr.errorString));
+    }
+    return rqr.files;
+}
+
+static QStringList getSources(const char *var, const char *vvar, const QStringList &baseVPaths,
+                              const QString &projectDir, const ProFileEvaluator &visitor)
+{
+    QStringList vPaths = visitor.absolutePathValues(QLatin1String(vvar), projectDir);
+    vPaths += baseVPaths;
+    vPaths.removeDuplicates();
+    return visitor.absoluteFileValues(QLatin1String(var), projectDir, vPaths, 0);
+}
+
+static QStringList getSources(const ProFileEvaluator &visitor, const QString &projectDir,
+                              const QStringList &excludes, QMakeVfs *vfs)
+{
+    QStringList baseVPaths;
+    baseVPaths += visitor.absolutePathValues(QLatin1String("VPATH"), projectDir);
+    baseVPaths << projectDir; // QMAKE_ABSOLUTE_SOURCE_PATH
+    baseVPaths.removeDuplicates();
+
+    QStringList sourceFiles;
+
+    // app/lib template
+    sourceFiles += getSources("SOURCES", "VPATH_SOURCES", baseVPaths, projectDir, visitor);
+    sourceFiles += getSources("HEADERS", "VPATH_HEADERS", baseVPaths, projectDir, visitor);
+
+    sourceFiles += getSources("FORMS", "VPATH_FORMS", baseVPaths, projectDir, visitor);
+
+    QStringList resourceFiles = getSources("RESOURCES", "VPATH_RESOURCES", baseVPaths, projectDir, visitor);
+    foreach (const QString &resource, resourceFiles)
+        sourceFiles += getResources(resource, vfs);
+
+    QStringList installs = visitor.values(QLatin1String("INSTALLS"))
+                         + visitor.values(QLatin1String("DEPLOYMENT"));
+    installs.removeDuplicates();
+    QDir baseDir(projectDir);
+    foreach (const QString inst, installs) {
+        foreach (const QString &file, visitor.values(inst + QLatin1String(".files"))) {
+            QFileInfo info(file);
+            if (!info.isAbsolute())
+                info.setFile(baseDir.absoluteFilePath(file));
+            QStringList nameFilter;
+            QString searchPath;
+            if (info.isDir()) {
+                nameFilter << QLatin1String("*");
+                searchPath = info.filePath();
+            } else {
+                nameFilter << info.fileName();
+                searchPath = info.path();
+            }
+
+            QDirIterator iterator(searchPath, nameFilter,
+                                  QDir::Files | QDir::NoDotAndDotDot | QDir::NoSymLinks,
+                                  QDirIterator::Subdirectories);
+            while (iterator.hasNext()) {
+                iterator.next();
+                QFileInfo cfi = iterator.fileInfo();
+                if (isSupportedExtension(cfi.suffix()))
+                    sourceFiles << cfi.filePath();
+            }
+        }
+    }
+
+    sourceFiles.removeDuplicates();
+    sourceFiles.sort();
+
+    // The list is sorted, so each pattern only needs to be matched against
+    // the range of files starting with its literal prefix.
+    QVector<bool> excluded(sourceFiles.size());
+    bool anyExcluded = false;
+    foreach (const QString &ex, excludes) {
+        QRegExp rx(ex, Qt::CaseSensitive, QRegExp::Wildcard);
+        const QString prefix = ex.left(ex.indexOf(QRegExp(QLatin1String("[*?[]"))));
+        QStringList::ConstIterator it = std::lower_bound(sourceFiles.constBegin(),
+                                                         sourceFiles.constEnd(), prefix);
+        for (; it != sourceFiles.constEnd() && it->startsWith(prefix); ++it) {
+            if (rx.exactMatch(*it)) {
+                excluded[it - sourceFiles.constBegin()] = true;
+                anyExcluded = true;
+            }
+        }
+    }
+    if (!anyExcluded)
+        return sourceFiles;
+
+    QStringList result;
+    result.reserve(sourceFiles.size());
+    for (int i = 0; i < sourceFiles.size(); ++i) {
+        if (!excluded.at(i))
+            result << sourceFiles.at(i);
+    }
+    return result;
+}
+
+static QStringList getExcludes(const ProFileEvaluator &visitor, const QString &projectDirPath)
+{
+    const QStringList trExcludes = visitor.values(QLatin1String("TR_EXCLUDE"));
+    QStringList excludes;
+    excludes.reserve(trExcludes.size());
+    const QDir projectDir(projectDirPath);
+    for (const QString &ex : trExcludes)
+        excludes << QDir::cleanPath(projectDir.absoluteFilePath(ex));
+    return excludes;
+}
+
+static void excludeProjects(const ProFileEvaluator &visitor, QStringList *subProjects)
+{
+    foreach (const QString &ex, visitor.values(QLatin1String("TR_EXCLUDE"))) {
+        QRegExp rx(ex, Qt::CaseSensitive, QRegExp::Wildcard);
+        for (QStringList::Iterator it = subProjects->begin(); it != subProjects->end(); ) {
+            if (rx.exactMatch(*it))
+                it = subProjects->erase(it);
+            else
+                ++it;
+        }
+    }
+}
+
+static QStringList getSubProFiles(const ProFileEvaluator &visitor, const QString &proPath)
+{
+    QStringList subProjects = visitor.values(QLatin1String("SUBDIRS"));
+    excludeProjects(visitor, &subProjects);
+    QStringList subProFiles;
+    QDir proDir(proPath);
+    foreach (const QString &subdir, subProjects) {
+        QString realdir = visitor.value(subdir + QLatin1String(".subdir"));
+        if (realdir.isEmpty())
+            realdir = visitor.value(subdir + QLatin1String(".file"));
+        if (realdir.isEmpty())
+            realdir = subdir;
+        QString subPro = QDir::cleanPath(proDir.absoluteFilePath(realdir));
+        QFileInfo subInfo(subPro);
+        if (subInfo.isDir()) {
+            subProFiles << (subPro + QLatin1Char('/')
+                            + subInfo.fileName() + QLatin1String(".pro"));
+        } else {
+            subProFiles << subPro;
+        }
+    }
+    return subProFiles;
+}
+
+bool parseProjectArguments(const QStringList &args, ProjectEvaluationOptions *options,
+                           QString *errorString)
+{
+    QString outDir = QDir::currentPath();
+    for (int i = 0; i < args.size(); ++i) {
+        const QString &arg = args.at(i);
+        if (arg == QLatin1String("-silent")) {
+            options->verbose = false;
+        } else if (arg == QLatin1String("-pro-debug")) {
+            options->proDebug++;
+        } else if (arg == QLatin1String("-pro")) {
+            ++i;
+            if (i == args.size()) {
+                *errorString = LD::tr("The -pro option should be followed by a filename of .pro file.\n");
+                return false;
+            }
+            QString file = QDir::cleanPath(QFileInfo(args[i]).absoluteFilePath());
+            options->proFiles += file;
+            options->outDirMap[file] = outDir;
+        } else if (arg == QLatin1String("-pro-out")) {
+            ++i;
+            if (i == args.size()) {
+                *errorString = LD::tr("The -pro-out option should be followed by a directory name.\n");
+                return false;
+            }
+            outDir = QDir::cleanPath(QFileInfo(args[i]).absoluteFilePath());
+        } else if (arg == QLatin1String("-threads")) {
+            ++i;
+            bool ok = false;
+            int threadCount = i < args.size() ? args[i].toInt(&ok) : -1;
+            if (!ok || threadCount < 0) {
+                *errorString = LD::tr("The -threads option should be followed by a non-negative number.\n");
+                return false;
+            }
+            options->threadCount = threadCount ? threadCount : QThread::idealThreadCount();
+        } else if (arg == QLatin1String("-cache-dir")) {
+            ++i;
+            if (i == args.size()) {
+                *errorString = LD::tr("The -cache-dir option should be followed by a directory name.\n");
+                return false;
+            }
+            options->cacheDirectory = args[i];
+        } else if (arg == QLatin1String("-cache-system")) {
+            options->cacheSystemCalls = true;
+        } else if (arg.startsWith(QLatin1String("-")) && arg != QLatin1String("-")) {
+            *errorString = LD::tr("Unrecognized option '%1'.\n").arg(arg);
+            return false;
+        } else {
+            QFileInfo fi(arg);
+            if (!fi.exists()) {
+                *errorString = LD::tr("lprodump error: File '%1' does not exist.\n").arg(arg);
+                return false;
+            }
+            if (!isProOrPriFile(arg)) {
+                *errorString = LD::tr("lprodump error: '%1' is neither a .pro nor a .pri file.\n")
+                               .arg(arg);
+                return false;
+            }
+            QString cleanFile = QDir::cleanPath(fi.absoluteFilePath());
+            options->proFiles << cleanFile;
+            options->outDirMap[cleanFile] = outDir;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+struct ProjectNode
+{
+    Project project;
+    bool valid = false;
+    std::vector<ProjectNode> subProjects;
+};
+
+// Every sub-project is evaluated as a task of its own. The tasks share the
+// parse cache and the VFS, but each one needs its own parser.
+class ProjectEvaluation
+{
+public:
+    ProjectEvaluation(ProFileGlobals *option, QMakeVfs *vfs, ProFileCache *cache,
+                      EvalHandler *handler, int threadCount)
+        : m_option(option), m_vfs(vfs), m_cache(cache), m_handler(handler)
+    {
+        m_pool.setMaxThreadCount(qMax(threadCount, 1));
+    }
+
+    bool evaluate(ProjectNode *node, const QString &proFile, bool topLevel);
+    void waitForDone() { m_pool.waitForDone(); }
+
+private:
+    void schedule(ProjectNode *node, const QString &proFile);
+
+    ProFileGlobals *m_option;
+    QMakeVfs *m_vfs;
+    ProFileCache *m_cache;
+    EvalHandler *m_handler;
+    QThreadPool m_pool;
+};
+
+void ProjectEvaluation::schedule(ProjectNode *node, const QString &proFile)
+{
+    if (m_pool.maxThreadCount() <= 1) {
+        evaluate(node, proFile, false);
+        return;
+    }
+    m_pool.start(QRunnable::create([this, node, proFile] {
+        evaluate(node, proFile, false);
+    }));
+}
+
+bool ProjectEvaluation::evaluate(ProjectNode *node, const QString &proFile, bool topLevel)
+{
+    QMakeParser parser(m_cache, m_vfs, m_handler);
+    ProFile *pro = parser.parsedProFile(proFile, topLevel
+            ? QMakeParser::ParseFlags(QMakeParser::ParseUseCache | QMakeParser::ParseReportMissing)
+            : QMakeParser::ParseFlags(QMakeParser::ParseUseCache));
+    if (!pro)
+        return false;
+    ProFileEvaluator visitor(m_option, &parser, m_vfs, m_handler);
+    visitor.setCumulative(true);
+    visitor.setOutputDir(m_option->shadowedPath(pro->directoryName()));
+    if (!visitor.accept(pro)) {
+        pro->deref();
+        return false;
+    }
+
+    Project &project = node->project;
+    project.filePath = proFile;
+    QStringList tmp = visitor.values(QLatin1String("CODECFORSRC"));
+    if (!tmp.isEmpty())
+        project.codec = tmp.last();
+    QString proPath = QFileInfo(proFile).path();
+    if (visitor.templateType() == ProFileEvaluator::TT_Subdirs) {
+        const QStringList subProFiles = getSubProFiles(visitor, proPath);
+        // The nodes must not move once the tasks refer to them.
+        node->subProjects.resize(subProFiles.size());
+        for (int i = 0; i < subProFiles.size(); ++i)
+            schedule(&node->subProjects[i], subProFiles.at(i));
+    } else {
+        project.excluded = getExcludes(visitor, proPath);
+        project.sources = getSources(visitor, proPath, project.excluded, m_vfs);
+        project.includePaths = visitor.absolutePathValues(QLatin1String("INCLUDEPATH"), proPath);
+    }
+    if (visitor.contains(QLatin1String("TRANSLATIONS"))) {
+        QStringList tsFiles;
+        QDir proDir(proPath);
+        const QStringList translations = visitor.values(QLatin1String("TRANSLATIONS"));
+        for (const QString &tsFile : translations)
+            tsFiles << proDir.filePath(tsFile);
+        project.translations.reset(new QStringList(tsFiles));
+    }
+    node->valid = true;
+    pro->deref();
+    return true;
+}
+
+} // namespace
+
+static Projects toProjects(std::vector<ProjectNode> &nodes)
+{
+    Projects result;
+    for (ProjectNode &node : nodes) {
+        if (!node.valid)
+            continue;
+        node.project.subProjects = toProjects(node.subProjects);
+        result.push_back(std::move(node.project));
+    }
+    return result;
+}
+
+Projects evaluateProjects(const ProjectEvaluationOptions &options, bool *fail)
+{
+    static EvalHandler evalHandler;
+    evalHandler.verbose = options.verbose;
+
+    ProFileGlobals option;
+    option.qmake_abslocation = QString::fromLocal8Bit(qgetenv("QMAKE"));
+    if (option.qmake_abslocation.isEmpty())
+        option.qmake_abslocation = QCoreApplication::applicationDirPath() + QLatin1String("/qmake");
+    option.debugLevel = options.proDebug;
+    option.initProperties();
+    option.setCommandLineArguments(QDir::currentPath(),
+                                   QStringList() << QLatin1String("CONFIG+=lupdate_run"));
+    QMakeVfs vfs;
+    ProFileCache cache;
+    // Shares the directory with lupdate's extraction cache.
+    if (!options.cacheDirectory.isEmpty())
+        cache.setPersistentDirectory(options.cacheDirectory + QLatin1String("/profiles"));
+    if (options.cacheSystemCalls) {
+        option.enableCommandCache(options.cacheDirectory.isEmpty()
+                                  ? QString()
+                                  : options.cacheDirectory + QLatin1String("/system"));
+    }
+    QMakeParser::initialize();
+    ProFileEvaluator::initialize();
+
+    ProjectEvaluation evaluation(&option, &vfs, &cache, &evalHandler, options.threadCount);
+    std::vector<ProjectNode> nodes(options.proFiles.size());
+    for (int i = 0; i < options.proFiles.size(); ++i) {
+        const QString &proFile = options.proFiles.at(i);
+        // The directories are global state of the evaluation, so the
+        // top-level projects are processed one after another.
+        if (!options.outDirMap.isEmpty())
+            option.setDirectories(QFileInfo(proFile).path(), options.outDirMap[proFile]);
+        if (!evaluation.evaluate(&nodes[i], proFile, true))
+            *fail = true;
+        evaluation.waitForDone();
+    }
+    option.saveCommandCache();
+    return toProjects(nodes);
+}
+
+static QJsonObject projectToJson(const Project &project)
+{
+    QJsonObject result;
+    result[QStringLiteral("projectFile")] = project.filePath;
+    if (!project.codec.isEmpty())
+        result[QStringLiteral("codec")] = project.codec;
+    if (!project.subProjects.empty()) {
+        QJsonArray subProjects;
+        for (const Project &subProject : project.subProjects)
+            subProjects.append(projectToJson(subProject));
+        result[QStringLiteral("subProjects")] = subProjects;
+    } else {
+        result[QStringLiteral("includePaths")] = QJsonArray::fromStringList(project.includePaths);
+        result[QStringLiteral("excluded")] = QJsonArray::fromStringList(project.excluded);
+        result[QStringLiteral("sources")] = QJsonArray::fromStringList(project.sources);
+    }
+    if (hasTranslations(project))
+        result[QStringLiteral("translations")] = QJsonArray::fromStringList(*project.translations);
+    return result;
+}
+
+QByteArray projectDescriptionToJson(const Projects &projects)
+{
+    QJsonArray result;
+    for (const Project &project : projects)
+        result.append(projectToJson(project));
+    return QJsonDocument(result).toJson(QJsonDocument::Compact);
+}
@@ -26,6 +26,7 @@
 **
 ****************************************************************************/
 
+#include "qmview.h"
 #include "translator.h"
 
 #ifndef QT_BOOTSTRAPPED
@@ -36,9 +37,15 @@
 #include <QtCore/QDir>
 #include <QtCore/QFile>
 #include <QtCore/QFileInfo>
-#include <QtCore/QMap>
+#include <QtCore/QSet>
 #include <QtCore/QString>
 #include <QtCore/QTextCodec>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 QT_BEGIN_NAMESPACE
 
@@ -111,6 +118,11 @@ public:
     const QByteArray &comment() const { return m_comment; }
     const QStringList &translations() const { return m_translations; }
     bool operator<(const ByteTranslatorMessage& m) const;
+    bool operator==(const ByteTranslatorMessage& m) const
+    {
+        return m_context == m.m_context && m_sourcetext == m.m_sourcetext
+            && m_comment == m.m_comment;
+    }
 
 private:
     QByteArray m_context;
@@ -130,6 +142,13 @@ bool ByteTranslatorMessage::operator<(const ByteTranslatorMessage& m) const
     return m_comment < m.m_comment;
 }
 
+// Like operator==, this ignores the translations.
+static inline uint qHash(const ByteTranslatorMessage &msg, uint seed = 0)
+{
+    return qHash(msg.context(), seed) ^ (qHash(msg.sourceText(), seed) * 31)
+        ^ (qHash(msg.comment(), seed) * 1021);
+}
+
 class Releaser
 {
 public:
@@ -141,17 +160,13 @@ public:
             : h(hash), o(offset)
         {}
 
-        bool operator<(const Offset &other) const {
-            return (h != other.h) ? h < other.h : o < other.o;
-        }
-        bool operator==(const Offset &other) const {
-            return h == other.h && o == other.o;
-        }
         uint h;
         uint o;
     };
 
     enum { Contexts = 0x2f, Hashes = 0x42, Messages = 0x69, NumerusRules = 0x88, Dependencies = 0x96, Language = 0xa7 };
+    // Not interpreted by QTranslator, which skips unknown blocks.
+    enum { ReleaseStamp = 0xb3 };
 
     Releaser(const QString &language) : m_language(language) {}
 
@@ -164,6 +179,7 @@ public:
 
     void setNumerusRules(const QByteArray &rules);
     void setDependencies(const QStringList &dependencies);
+    void setReleaseStamp(const QByteArray &stamp) { m_releaseStamp = stamp; }
 
 private:
     Q_DISABLE_COPY(Releaser)
@@ -184,10 +200,12 @@ private:
     QByteArray m_messageArray;
     QByteArray m_offsetArray;
     QByteArray m_contextArray;
-    QMap<ByteTranslatorMessage, void *> m_messages;
+    // A message inserted again keeps its first translations.
+    QSet<ByteTranslatorMessage> m_messages;
     QByteArray m_numerusRules;
     QStringList m_dependencies;
     QByteArray m_dependencyArray;
+    QByteArray m_releaseStamp;
 };
 
 QByteArray Releaser::originalBytes(const QString &str) const
@@ -250,6 +268,12 @@ bool Releaser::save(QIODevice *iod)
     QDataStream s(iod);
     s.writeRawData((const char *)magic, MagicLength);
 
+    // Comes first, so that readQMReleaseStamp() does not need to read the whole file
+    if (!m_releaseStamp.isEmpty()) {
+        quint32 rss = quint32(m_releaseStamp.size());
+        s << quint8(ReleaseStamp) << rss;
+        s.writeRawData(m_releaseStamp.constData(), rss);
+    }
     if (!m_language.isEmpty()) {
         QByteArray lang = originalBytes(m_language);
         quint32 las = quint32(lang.size());
@@ -284,6 +308,22 @@ bool Releaser::save(QIODevice *iod)
     return true;
 }
 
+// Stable LSD radix sort on the 32-bit hash, one byte per pass.
+static void radixSortByHash(std::vector<Releaser::Offset> *offsets)
+{
+    std::vector<Releaser::Offset> buffer(offsets->size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        size_t counts[257] = {};
+        for (const Releaser::Offset &k : *offsets)
+            ++counts[((k.h >> shift) & 0xff) + 1];
+        for (int b = 0; b < 256; ++b)
+            counts[b + 1] += counts[b];
+        for (const Releaser::Offset &k : *offsets)
+            buffer[counts[(k.h >> shift) & 0xff]++] = k;
+        offsets->swap(buffer);
+    }
+}
+
 void Releaser::squeeze(TranslatorSaveMode mode)
 {
     m_dependencyArray.clear();
@@ -294,7 +334,8 @@ void Releaser::squeeze(TranslatorSaveMode mode)
     if (m_messages.isEmpty() && mode == SaveEverything)
         return;
 
-    QMap<ByteTranslatorMessage, void *> messages = m_messages;
+    std::vector<ByteTranslatorMessage> messages(m_messages.cbegin(), m_messages.cend());
+    std::sort(messages.begin(), messages.end());
 
     // re-build contents
     m_messageArray.clear();
@@ -302,36 +343,45 @@ void Releaser::squeeze(TranslatorSaveMode mode)
     m_contextArray.clear();
     m_messages.clear();
 
-    QMap<Offset, void *> offsets;
+    std::vector<Offset> offsets;
+    offsets.reserve(messages.size());
+    std::vector<uint> hashes;
+    hashes.reserve(messages.size());
+    for (const ByteTranslatorMessage &msg : messages)
+        hashes.push_back(msgHash(msg));
 
     QDataStream ms(&m_messageArray, QIODevice::WriteOnly);
-    QMap<ByteTranslatorMessage, void *>::const_iterator it, next;
     int cpPrev = 0, cpNext = 0;
-    for (it = messages.constBegin(); it != messages.constEnd(); ++it) {
+    for (size_t i = 0; i < messages.size(); ++i) {
         cpPrev = cpNext;
-        next = it;
-        ++next;
-        if (next == messages.constEnd())
+        if (i + 1 == messages.size())
             cpNext = 0;
+        else if (hashes[i] != hashes[i + 1])
+            cpNext = NoPrefix;
         else
-            cpNext = commonPrefix(it.key(), next.key());
-        offsets.insert(Offset(msgHash(it.key()), ms.device()->pos()), (void *)0);
-        writeMessage(it.key(), ms, mode, Prefix(qMax(cpPrev, cpNext + 1)));
+            cpNext = commonPrefix(messages[i], messages[i + 1]);
+        offsets.push_back(Offset(hashes[i], ms.device()->pos()));
+        writeMessage(messages[i], ms, mode, Prefix(qMax(cpPrev, cpNext + 1)));
     }
 
-    QMap<Offset, void *>::Iterator offset;
-    offset = offsets.begin();
-    QDataStream ds(&m_offsetArray, QIODevice::WriteOnly);
-    while (offset != offsets.end()) {
-        Offset k = offset.key();
-        ++offset;
-        ds << quint32(k.h) << quint32(k.o);
+    // The offsets are in ascending order already, so a stable sort by hash
+    // yields the (hash, offset) order QTranslator's binary search expects.
+    radixSortByHash(&offsets);
+    m_offsetArray.resize(int(offsets.size() * 2 * sizeof(quint32)));
+    uchar *od = reinterpret_cast<uchar *>(m_offsetArray.data());
+    for (const Offset &k : offsets) {
+        qToBigEndian(quint32(k.h), od);
+        qToBigEndian(quint32(k.o), od + 4);
+        od += 8;
     }
 
     if (mode == SaveStripped) {
-        QMap<QByteArray, int> contextSet;
-        for (it = messages.constBegin(); it != messages.constEnd(); ++it)
-            ++contextSet[it.key().context()];
+        // The messages are sorted by context first.
+        QVector<QByteArray> contextSet;
+        for (const ByteTranslatorMessage &msg : messages) {
+            if (contextSet.isEmpty() || contextSet.constLast() != msg.context())
+                contextSet.append(msg.context());
+        }
 
         quint16 hTableSize;
         if (contextSet.size() < 200)
@@ -341,10 +391,16 @@ void Releaser::squeeze(TranslatorSaveMode mode)
         else
             hTableSize = (contextSet.size() < 10000) ? 15013 : 3 * contextSet.size() / 2;
 
-        QMultiMap<int, QByteArray> hashMap;
-        QMap<QByteArray, int>::const_iterator c;
-        for (c = contextSet.constBegin(); c != contextSet.constEnd(); ++c)
-            hashMap.insert(elfHash(c.key()) % hTableSize, c.key());
+        // Contexts sharing a bucket are stored in descending order, as
+        // they used to come out of a QMultiMap filled in ascending order.
+        std::vector<std::pair<int, QByteArray> > hashMap;
+        hashMap.reserve(contextSet.size());
+        for (int c = contextSet.size(); --c >= 0; )
+            hashMap.emplace_back(elfHash(contextSet.at(c)) % hTableSize, contextSet.at(c));
+        std::stable_sort(hashMap.begin(), hashMap.end(),
+                         [](const std::pair<int, QByteArray> &a, const std::pair<int, QByteArray> &b) {
+                             return a.first < b.first;
+                         });
 
         /*
           The contexts found in this translator are stored in a hash
@@ -379,20 +435,20 @@ void Releaser::squeeze(TranslatorSaveMode mode)
         t << quint16(0); // the entry at offset 0 cannot be used
         uint upto = 2;
 
-        QMap<int, QByteArray>::const_iterator entry = hashMap.constBegin();
-        while (entry != hashMap.constEnd()) {
-            int i = entry.key();
+        auto entry = hashMap.cbegin();
+        while (entry != hashMap.cend()) {
+            int i = entry->first;
             hTable[i] = quint16(upto >> 1);
 
             do {
-                const char *con = entry.value().constData();
-                uint len = uint(entry.value().length());
+                const char *con = entry->second.constData();
+                uint len = uint(entry->second.length());
                 len = qMin(len, 255u);
                 t << quint8(len);
                 t.writeRawData(con, len);
                 upto += 1 + len;
                 ++entry;
-            } while (entry != hashMap.constEnd() && entry.key() == i);
+            } while (entry != hashMap.cend() && entry->first == i);
             if (upto & 0x1) {
                 // offsets have to be even
                 t << quint8(0); // empty string
@@ -421,17 +477,17 @@ void Releaser::insert(const TranslatorMessage &message, const QStringList &tlns,
         ByteTranslatorMessage bmsg2(
                 bmsg.context(), bmsg.sourceText(), QByteArray(""), bmsg.translations());
         if (!m_messages.contains(bmsg2)) {
-            m_messages.insert(bmsg2, 0);
+            m_messages.insert(bmsg2);
             return;
         }
     }
-    m_messages.insert(bmsg, 0);
+    m_messages.insert(bmsg);
 }
 
 void Releaser::insertIdBased(const TranslatorMessage &message, const QStringList &tlns)
 {
     ByteTranslatorMessage bmsg("", originalBytes(message.id()), "", tlns);
-    m_messages.insert(bmsg, 0);
+    m_messages.insert(bmsg);
 }
 
 void Releaser::setNumerusRules(const QByteArray &rules)
@@ -462,11 +518,77 @@ static void fromBytes(const char *str, int len, QString *out, bool *utf8Fail)
     *utf8Fail = cvtState.invalidChars;
 }
 
-bool loadQM(Translator &translator, QIODevice &dev, ConversionData &cd)
+struct QmView::RawMessage
+{
+    QByteArray context;
+    QByteArray sourceText;
+    QByteArray comment;
+    bool hasContext = false;
+    bool hasSourceText = false;
+    bool hasComment = false;
+    QStringList translations;
+};
+
+QmView::QmView()
+    : m_mapped(0), m_offsetArray(0), m_messageArray(0), m_messageEnd(0), m_messageCount(0),
+      m_guessPlurals(true)
+{
+}
+
+QmView::~QmView()
 {
-    QByteArray ba = dev.readAll();
-    const uchar *data = (uchar*)ba.data();
-    int len = ba.size();
+    unmap();
+}
+
+// Closing the file also unmaps it, hence the guarded pointer.
+void QmView::unmap()
+{
+    if (m_mapped && m_mappedFile)
+        m_mappedFile->unmap(m_mapped);
+    m_mapped = 0;
+    m_mappedFile = nullptr;
+}
+
+bool QmView::load(const QString &fileName, ConversionData &cd)
+{
+    unmap();
+    m_file.close();
+    m_file.setFileName(fileName);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        cd.appendError(QString::fromLatin1("Cannot open %1: %2")
+                       .arg(fileName, m_file.errorString()));
+        return false;
+    }
+    return load(m_file, cd);
+}
+
+bool QmView::load(QIODevice &dev, ConversionData &cd)
+{
+    unmap();
+    if (QFile *file = qobject_cast<QFile *>(&dev)) {
+        const qint64 pos = file->pos();
+        const qint64 size = file->size() - pos;
+        if (!file->isSequential() && size > 0) {
+            if (uchar *mapped = file->map(pos, size)) {
+                m_mapped = mapped;
+                m_mappedFile = file;
+                return parse(mapped, size, cd);
+            }
+        }
+    }
+    m_data = dev.readAll();
+    return parse((const uchar *)m_data.constData(), m_data.size(), cd);
+}
+
+bool QmView::parse(const uchar *data, qint64 len, ConversionData &cd)
+{
+    m_offsetArray = m_messageArray = m_messageEnd = 0;
+    m_messageCount = 0;
+    m_checkpoints.clear();
+    m_guessPlurals = true;
+    m_language.clear();
+    m_dependencies.clear();
+
     if (len < MagicLength || memcmp(data, magic, MagicLength) != 0) {
         cd.appendError(QLatin1String("QM-Format error: magic marker missing"));
         return false;
@@ -474,12 +596,7 @@ bool loadQM(Translator &translator, QIODevice &dev, ConversionData &cd)
 
     enum { Contexts = 0x2f, Hashes = 0x42, Messages = 0x69, NumerusRules = 0x88, Dependencies = 0x96, Language = 0xa7 };
 
-    // for squeezed but non-file data, this is what needs to be deleted
-    const uchar *messageArray = 0;
-    const uchar *offsetArray = 0;
     uint offsetLength = 0;
-
-    bool ok = true;
     bool utf8Fail = false;
     const uchar *end = data + len;
 
@@ -488,152 +605,278 @@ bool loadQM(Translator &translator, QIODevice &dev, ConversionData &cd)
     while (data < end - 4) {
         quint8 tag = read8(data++);
         quint32 blockLen = read32(data);
-        //qDebug() << "TAG:" << tag <<  "BLOCKLEN:" << blockLen;
         data += 4;
         if (!tag || !blockLen)
             break;
-        if (data + blockLen > end) {
-            ok = false;
-            break;
+        if (blockLen > quint32(end - data)) {
+            cd.appendError(QLatin1String("QM-Format error"));
+            return false;
         }
 
         if (tag == Hashes) {
-            offsetArray = data;
+            m_offsetArray = data;
             offsetLength = blockLen;
-            //qDebug() << "HASHES: " << blockLen << QByteArray((const char *)data, blockLen).toHex();
         } else if (tag == Messages) {
-            messageArray = data;
-            //qDebug() << "MESSAGES: " << blockLen << QByteArray((const char *)data, blockLen).toHex();
+            m_messageArray = data;
+            m_messageEnd = data + blockLen;
         } else if (tag == Dependencies) {
-            QStringList dependencies;
             QDataStream stream(QByteArray::fromRawData((const char*)data, blockLen));
             QString dep;
             while (!stream.atEnd()) {
                 stream >> dep;
-                dependencies.append(dep);
+                m_dependencies.append(dep);
             }
-            translator.setDependencies(dependencies);
         } else if (tag == Language) {
-            QString language;
-            fromBytes((const char *)data, blockLen, &language, &utf8Fail);
-            translator.setLanguageCode(language);
+            fromBytes((const char *)data, blockLen, &m_language, &utf8Fail);
         }
 
         data += blockLen;
     }
+    if (utf8Fail) {
+        cd.appendError(QLatin1String("Cannot read file with UTF-8 codec"));
+        return false;
+    }
 
+    m_messageCount = m_messageArray ? int(offsetLength / (2 * sizeof(quint32))) : 0;
 
-    size_t numItems = offsetLength / (2 * sizeof(quint32));
-    //qDebug() << "NUMITEMS: " << numItems;
-
-    QString strProN = QLatin1String("%n");
     QLocale::Language l;
     QLocale::Country c;
-    Translator::languageAndCountry(translator.languageCode(), &l, &c);
+    Translator::languageAndCountry(m_language, &l, &c);
     QStringList numerusForms;
-    bool guessPlurals = true;
     if (getNumerusInfo(l, c, 0, &numerusForms, 0))
-        guessPlurals = (numerusForms.count() == 1);
+        m_guessPlurals = (numerusForms.count() == 1);
+    return true;
+}
 
-    QString context, sourcetext, comment;
-    QStringList translations;
+quint32 QmView::hashAt(int index) const
+{
+    return read32(m_offsetArray + 8 * index);
+}
 
-    for (const uchar *start = offsetArray; start != offsetArray + (numItems << 3); start += 8) {
-        //quint32 hash = read32(start);
-        quint32 ro = read32(start + 4);
-        //qDebug() << "\nHASH:" << hash;
-        const uchar *m = messageArray + ro;
-
-        for (;;) {
-            uchar tag = read8(m++);
-            //qDebug() << "Tag:" << tag << " ADDR: " << m;
-            switch(tag) {
-            case Tag_End:
-                goto end;
-            case Tag_Translation: {
-                int len = read32(m);
-                if (len % 1) {
-                    cd.appendError(QLatin1String("QM-Format error"));
-                    return false;
-                }
-                m += 4;
-                QString str = QString((const QChar *)m, len/2);
-                if (QSysInfo::ByteOrder == QSysInfo::LittleEndian) {
-                    for (int i = 0; i < str.length(); ++i)
-                        str[i] = QChar((str.at(i).unicode() >> 8) +
-                            ((str.at(i).unicode() << 8) & 0xff00));
-                }
-                translations << str;
-                m += len;
-                break;
-            }
-            case Tag_Obsolete1:
-                m += 4;
-                //qDebug() << "OBSOLETE";
-                break;
-            case Tag_SourceText: {
-                quint32 len = read32(m);
-                m += 4;
-                //qDebug() << "SOURCE LEN: " << len;
-                //qDebug() << "SOURCE: " << QByteArray((const char*)m, len);
-                fromBytes((const char*)m, len, &sourcetext, &utf8Fail);
-                m += len;
-                break;
-            }
-            case Tag_Context: {
-                quint32 len = read32(m);
-                m += 4;
-                //qDebug() << "CONTEXT LEN: " << len;
-                //qDebug() << "CONTEXT: " << QByteArray((const char*)m, len);
-                fromBytes((const char*)m, len, &context, &utf8Fail);
-                m += len;
-                break;
-            }
-            case Tag_Comment: {
-                quint32 len = read32(m);
-                m += 4;
-                //qDebug() << "COMMENT LEN: " << len;
-                //qDebug() << "COMMENT: " << QByteArray((const char*)m, len);
-                fromBytes((const char*)m, len, &comment, &utf8Fail);
-                m += len;
-                break;
-            }
-            default:
-                //qDebug() << "UNKNOWN TAG" << tag;
-                break;
+// Reads the fields that are actually stored for the message.
+// Decoding stops at the end of the message data.
+void QmView::readRawMessage(int index, RawMessage *raw, bool withTranslations) const
+{
+    const uchar *m = m_messageArray + read32(m_offsetArray + 8 * index + 4);
+    const uchar *end = m_messageEnd;
+
+    auto readBlock = [&m, end](QByteArray *bytes) {
+        if (end - m < 4)
+            return false;
+        quint32 len = read32(m);
+        m += 4;
+        if (len == 0xffffffff) { // null
+            *bytes = QByteArray();
+            return true;
+        }
+        if (len > quint32(end - m))
+            return false;
+        *bytes = QByteArray::fromRawData((const char *)m, len);
+        m += len;
+        return true;
+    };
+
+    while (m < end) {
+        uchar tag = read8(m++);
+        switch (tag) {
+        case Tag_End:
+            return;
+        case Tag_Translation: {
+            QByteArray bytes;
+            if (!readBlock(&bytes))
+                return;
+            if (withTranslations) {
+                // UTF-16, big endian
+                QString str(bytes.size() / 2, Qt::Uninitialized);
+                const uchar *b = (const uchar *)bytes.constData();
+                for (int i = 0; i < str.length(); ++i, b += 2)
+                    str[i] = QChar((b[0] << 8) | b[1]);
+                raw->translations << str;
             }
+            break;
         }
-    end:;
-        TranslatorMessage msg;
-        msg.setType(TranslatorMessage::Finished);
-        if (translations.count() > 1) {
-            // If guessPlurals is not false here, plural form discard messages
-            // will be spewn out later.
+        case Tag_Obsolete1:
+            m += 4;
+            break;
+        case Tag_SourceText:
+            if (!readBlock(&raw->sourceText))
+                return;
+            raw->hasSourceText = true;
+            break;
+        case Tag_Context:
+            if (!readBlock(&raw->context))
+                return;
+            raw->hasContext = true;
+            break;
+        case Tag_Comment:
+            if (!readBlock(&raw->comment))
+                return;
+            raw->hasComment = true;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+TranslatorMessage QmView::toMessage(const RawMessage &raw, bool *utf8Fail) const
+{
+    QString context, sourcetext, comment;
+    bool fail = false;
+    fromBytes(raw.context.constData(), raw.context.size(), &context, &fail);
+    *utf8Fail |= fail;
+    fromBytes(raw.sourceText.constData(), raw.sourceText.size(), &sourcetext, &fail);
+    *utf8Fail |= fail;
+    fromBytes(raw.comment.constData(), raw.comment.size(), &comment, &fail);
+    *utf8Fail |= fail;
+
+    TranslatorMessage msg;
+    msg.setType(TranslatorMessage::Finished);
+    if (raw.translations.count() > 1) {
+        // If guessPlurals is not false here, plural form discard messages
+        // will be spewn out later.
+        msg.setPlural(true);
+    } else if (m_guessPlurals) {
+        // This might cause false positives, so it is a fallback only.
+        if (sourcetext.contains(QLatin1String("%n")))
             msg.setPlural(true);
-        } else if (guessPlurals) {
-            // This might cause false positives, so it is a fallback only.
-            if (sourcetext.contains(strProN))
-                msg.setPlural(true);
+    }
+    msg.setTranslations(raw.translations);
+    msg.setContext(context);
+    msg.setSourceText(sourcetext);
+    msg.setComment(comment);
+    return msg;
+}
+
+// Takes over the fields stored for a message into the state of a
+// decoder that walks the messages in a row.
+void QmView::carryOver(const RawMessage &raw, RawMessage *state)
+{
+    if (raw.hasContext) {
+        state->context = raw.context;
+        state->hasContext = true;
+    }
+    if (raw.hasSourceText) {
+        state->sourceText = raw.sourceText;
+        state->hasSourceText = true;
+    }
+    if (raw.hasComment) {
+        state->comment = raw.comment;
+        state->hasComment = true;
+    }
+    state->translations = raw.translations;
+}
+
+// Decodes the file forward once, so a message with stripped fields is at
+// most CheckpointInterval messages away from a known state.
+void QmView::ensureCheckpoints() const
+{
+    if (!m_checkpoints.isEmpty())
+        return;
+    m_checkpoints.reserve(m_messageCount / CheckpointInterval + 1);
+    RawMessage state;
+    for (int i = 0; i < m_messageCount; ++i) {
+        if (i % CheckpointInterval == 0)
+            m_checkpoints.append(state);
+        RawMessage raw;
+        readRawMessage(i, &raw, false);
+        carryOver(raw, &state);
+    }
+}
+
+TranslatorMessage QmView::message(int index, bool *utf8Fail) const
+{
+    RawMessage raw;
+    readRawMessage(index, &raw, true);
+    if (!(raw.hasContext && raw.hasSourceText && raw.hasComment)) {
+        // Stripped fields are taken over from the preceding messages, like
+        // appendTo() does when decoding all messages in a row.
+        ensureCheckpoints();
+        RawMessage state = m_checkpoints.at(index / CheckpointInterval);
+        for (int i = index - index % CheckpointInterval; i < index; ++i) {
+            RawMessage prev;
+            readRawMessage(i, &prev, false);
+            carryOver(prev, &state);
         }
-        msg.setTranslations(translations);
-        translations.clear();
-        msg.setContext(context);
-        msg.setSourceText(sourcetext);
-        msg.setComment(comment);
-        translator.append(msg);
+        carryOver(raw, &state);
+        raw = state;
+    }
+    bool fail = false;
+    TranslatorMessage msg = toMessage(raw, &fail);
+    if (utf8Fail)
+        *utf8Fail = fail;
+    return msg;
+}
+
+int QmView::findRaw(const QByteArray &context, const QByteArray &sourceText,
+                    const QByteArray &comment) const
+{
+    const quint32 h = elfHash(sourceText + comment);
+    int lo = 0;
+    int hi = m_messageCount;
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+        if (hashAt(mid) < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    // Fields stripped from the file match anything, as in QTranslator.
+    for (; lo < m_messageCount && hashAt(lo) == h; ++lo) {
+        RawMessage raw;
+        readRawMessage(lo, &raw, false);
+        if ((!raw.hasContext || raw.context == context)
+            && (!raw.hasSourceText || raw.sourceText == sourceText)
+            && (!raw.hasComment || raw.comment == comment)) {
+            return lo;
+        }
+    }
+    return -1;
+}
+
+int QmView::find(const QString &context, const QString &sourceText,
+                 const QString &comment) const
+{
+    const QByteArray contextBytes = context.toUtf8();
+    const QByteArray sourceTextBytes = sourceText.toUtf8();
+    const QByteArray commentBytes = comment.toUtf8();
+    int index = findRaw(contextBytes, sourceTextBytes, commentBytes);
+    if (index < 0 && !commentBytes.isEmpty())
+        index = findRaw(contextBytes, sourceTextBytes, QByteArray());
+    return index;
+}
+
+bool QmView::appendTo(Translator &translator, ConversionData &cd) const
+{
+    translator.setDependencies(m_dependencies);
+    translator.setLanguageCode(m_language);
+
+    bool utf8Fail = false;
+    RawMessage state;
+    for (int i = 0; i < m_messageCount; ++i) {
+        RawMessage raw;
+        readRawMessage(i, &raw, true);
+        carryOver(raw, &state);
+        translator.append(toMessage(state, &utf8Fail));
     }
     if (utf8Fail) {
         cd.appendError(QLatin1String("Cannot read file with UTF-8 codec"));
         return false;
     }
-    return ok;
+    return true;
+}
+
+bool loadQM(Translator &translator, QIODevice &dev, ConversionData &cd)
+{
+    QmView view;
+    return view.load(dev, cd) && view.appendTo(translator, cd);
 }
 
 
 
 static bool containsStripped(const Translator &translator, const TranslatorMessage &msg)
 {
-    foreach (const TranslatorMessage &tmsg, translator.messages())
+    foreach (const TranslatorMessage &tmsg, translator.constMessages())
         if (tmsg.sourceText() == msg.sourceText()
             && tmsg.context() == msg.context()
             && tmsg.comment().isEmpty())
@@ -712,6 +955,7 @@ bool saveQM(const Translator &translator, QIODevice &dev, ConversionData &cd)
             droppedData));
 
     releaser.setDependencies(translator.dependencies());
+    releaser.setReleaseStamp(cd.m_releaseStamp);
     releaser.squeeze(cd.m_saveMode);
     bool saved = releaser.save(&dev);
     if (saved && cd.isVerbose()) {
@@ -727,6 +971,19 @@ bool saveQM(const Translator &translator, QIODevice &dev, ConversionData &cd)
     return saved;
 }
 
+QByteArray readQMReleaseStamp(QIODevice &dev)
+{
+    uchar header[MagicLength + 5];
+    if (dev.read((char *)header, sizeof(header)) != qint64(sizeof(header))
+        || memcmp(header, magic, MagicLength) != 0
+        || read8(header + MagicLength) != Releaser::ReleaseStamp) {
+        return QByteArray();
+    }
+    const quint32 blockLen = read32(header + MagicLength + 1);
+    QByteArray stamp = dev.read(blockLen);
+    return stamp.size() == int(blockLen) ? stamp : QByteArray();
+}
+
 int initQM()
 {
     Translator::FileFormat format;
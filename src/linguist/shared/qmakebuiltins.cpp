@@ -35,6 +35,7 @@
 #include "ioutils.h"
 
 #include <qbytearray.h>
+#include <qcryptographichash.h>
 #include <qdir.h>
 #include <qfile.h>
 #include <qfileinfo.h>
@@ -507,25 +508,79 @@ void QMakeEvaluator::runProcess(QProcess *proc, const QString &command) const
 }
 #endif
 
+#ifndef PROEVALUATOR_FULL
+QByteArray QMakeEvaluator::commandCacheKey(const QString &command) const
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    hasher.addData(command.toUtf8());
+    hasher.addData("", 1);
+    hasher.addData(currentDirectory().toUtf8());
+# if QT_CONFIG(process)
+    QStringList env;
+#  ifdef PROEVALUATOR_SETENV
+    if (!m_option->environment.isEmpty())
+        env = m_option->environment.toStringList();
+    else
+#  endif
+        env = QProcessEnvironment::systemEnvironment().toStringList();
+    env.sort();
+    for (const QString &var : qAsConst(env)) {
+        hasher.addData("", 1);
+        hasher.addData(var.toUtf8());
+    }
+# endif
+    return hasher.result();
+}
+
+void QMakeEvaluator::reportCommandErrors(QByteArray errout) const
+{
+    if (!errout.isEmpty()) {
+        if (errout.endsWith('\n'))
+            errout.chop(1);
+        m_handler->message(
+            QMakeHandler::EvalError | (m_cumulative ? QMakeHandler::CumulativeEvalMessage : 0),
+            QString::fromLocal8Bit(errout));
+    }
+}
+#endif
+
 QByteArray QMakeEvaluator::getCommandOutput(const QString &args, int *exitCode) const
 {
+#ifndef PROEVALUATOR_FULL
+    QByteArray cacheKey;
+    if (m_option->command_cache) {
+        cacheKey = commandCacheKey(args);
+        QMakeGlobals::CommandResult result;
+        bool found;
+        {
+# ifdef PROEVALUATOR_THREAD_SAFE
+            QMutexLocker locker(&m_option->command_mutex);
+# endif
+            auto it = m_option->command_results.constFind(cacheKey);
+            found = it != m_option->command_results.constEnd();
+            if (found)
+                result = *it;
+        }
+        if (found) {
+            // Replay the command's diagnostics, so the output stays the same.
+            reportCommandErrors(result.errout);
+            *exitCode = result.exitCode;
+            return result.out;
+        }
+    }
+#endif
     QByteArray out;
+    QByteArray errout;
 #if QT_CONFIG(process)
     QProcess proc;
     runProcess(&proc, args);
     *exitCode = (proc.exitStatus() == QProcess::NormalExit) ? proc.exitCode() : -1;
-    QByteArray errout = proc.readAllStandardError();
+    errout = proc.readAllStandardError();
 # ifdef PROEVALUATOR_FULL
     // FIXME: Qt really should have the option to set forwarding per channel
     fputs(errout.constData(), stderr);
 # else
-    if (!errout.isEmpty()) {
-        if (errout.endsWith('\n'))
-            errout.chop(1);
-        m_handler->message(
-            QMakeHandler::EvalError | (m_cumulative ? QMakeHandler::CumulativeEvalMessage : 0),
-            QString::fromLocal8Bit(errout));
-    }
+    reportCommandErrors(errout);
 # endif
     out = proc.readAllStandardOutput();
 # ifdef Q_OS_WIN
@@ -549,10 +604,25 @@ QByteArray QMakeEvaluator::getCommandOutput(const QString &args, int *exitCode)
 # else
         *exitCode = WIFEXITED(ec) ? WEXITSTATUS(ec) : -1;
 # endif
+    } else {
+        *exitCode = -1;
     }
 # ifdef Q_OS_WIN
     out.replace("\r\n", "\n");
 # endif
+#endif
+#ifndef PROEVALUATOR_FULL
+    if (!cacheKey.isEmpty()) {
+        QMakeGlobals::CommandResult result;
+        result.out = out;
+        result.errout = errout;
+        result.exitCode = *exitCode;
+# ifdef PROEVALUATOR_THREAD_SAFE
+        QMutexLocker locker(&m_option->command_mutex);
+# endif
+        m_option->command_results.insert(cacheKey, result);
+        m_option->command_cache_dirty = true;
+    }
 #endif
     return out;
 }
@@ -1035,19 +1105,18 @@ QMakeEvaluator::VisitReturn QMakeEvaluator::evaluateBuiltinExpand(
         }
 
         r.detach(); // Keep m_tmp out of QRegExp's cache
-        QRegExp regex(r, Qt::CaseSensitive, QRegExp::Wildcard);
+        // Plain names are common, and need no pattern matching.
+        const bool wildcard = r.contains(QLatin1Char('*')) || r.contains(QLatin1Char('?'))
+                || r.contains(QLatin1Char('['));
+        QRegExp regex(wildcard ? r : QString(), Qt::CaseSensitive, QRegExp::Wildcard);
         for (int d = 0; d < dirs.count(); d++) {
             QString dir = dirs[d];
-            QDir qdir(pfx + dir);
-            for (int i = 0; i < (int)qdir.count(); ++i) {
-                if (qdir[i] == statics.strDot || qdir[i] == statics.strDotDot)
-                    continue;
-                QString fname = dir + qdir[i];
-                if (IoUtils::fileType(pfx + fname) == IoUtils::FileIsDir) {
-                    if (recursive)
-                        dirs.append(fname + QLatin1Char('/'));
-                }
-                if (regex.exactMatch(qdir[i]))
+            const QStringList entries = m_vfs->directoryEntries(pfx + dir);
+            for (const QString &entry : entries) {
+                QString fname = dir + entry;
+                if (recursive && m_vfs->fileType(pfx + fname) == IoUtils::FileIsDir)
+                    dirs.append(fname + QLatin1Char('/'));
+                if (wildcard ? regex.exactMatch(entry) : entry == r)
                       ret += ProString(fname).setSource(currentFileId());
             }
         }
@@ -1786,18 +1855,22 @@ QMakeEvaluator::VisitReturn QMakeEvaluator::evaluateBuiltinConditional(
     }
     case T_EXISTS: {
         QString file = filePathEnvArg0(args);
-        // Don't use VFS here:
-        // - it supports neither listing nor even directories
+        // Don't use the VFS' virtual files here:
+        // - they support neither listing nor even directories
         // - it's unlikely that somebody would test for files they created themselves
-        if (IoUtils::exists(file))
+        if (m_vfs->fileType(file) != IoUtils::FileNotFound)
             return ReturnTrue;
         int slsh = file.lastIndexOf(QLatin1Char('/'));
         QString fn = file.mid(slsh+1);
         if (fn.contains(QLatin1Char('*')) || fn.contains(QLatin1Char('?'))) {
             QString dirstr = file.left(slsh+1);
-            dirstr.detach();
-            if (!QDir(dirstr).entryList(QStringList(fn)).isEmpty())
-                return ReturnTrue;
+            // Like QDir's name filters, this is case-insensitive.
+            QRegExp regex(fn, Qt::CaseInsensitive, QRegExp::Wildcard);
+            const QStringList entries = m_vfs->directoryEntries(dirstr);
+            for (const QString &entry : entries) {
+                if (regex.exactMatch(entry))
+                    return ReturnTrue;
+            }
         }
 
         return ReturnFalse;
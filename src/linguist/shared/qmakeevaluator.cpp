@@ -1577,7 +1577,7 @@ void QMakeEvaluator::updateFeaturePaths()
 
     QStringList ret;
     for (const QString &root : qAsConst(feature_roots))
-        if (IoUtils::exists(root))
+        if (m_vfs->fileType(root) != IoUtils::FileNotFound)
             ret << root;
     m_featureRoots = new QMakeFeatureRoots(ret);
 }
@@ -2012,7 +2012,7 @@ QMakeEvaluator::VisitReturn QMakeEvaluator::evaluateFeatureFile(
             }
             for (int root = start_root; root < paths.size(); ++root) {
                 QString fname = paths.at(root) + fn;
-                if (IoUtils::exists(fname)) {
+                if (m_vfs->fileType(fname) != IoUtils::FileNotFound) {
                     fn = fname;
                     goto cool;
                 }
@@ -250,6 +250,10 @@ public:
     void runProcess(QProcess *proc, const QString &command) const;
 #endif
     QByteArray getCommandOutput(const QString &args, int *exitCode) const;
+#ifndef PROEVALUATOR_FULL
+    QByteArray commandCacheKey(const QString &command) const;
+    void reportCommandErrors(QByteArray errout) const;
+#endif
 
 private:
     // Implementation detail of evaluateBuiltinConditional():
@@ -32,6 +32,7 @@
 #include "ioutils.h"
 
 #include <qbytearray.h>
+#include <qdatastream.h>
 #include <qdatetime.h>
 #include <qdebug.h>
 #include <qdir.h>
@@ -39,6 +40,7 @@
 #include <qfileinfo.h>
 #include <qlist.h>
 #include <qregexp.h>
+#include <qsavefile.h>
 #include <qset.h>
 #include <qstack.h>
 #include <qstring.h>
@@ -75,6 +77,10 @@ using namespace QMakeInternal; // for IoUtils
 QMakeGlobals::QMakeGlobals()
 {
     do_cache = true;
+#ifndef PROEVALUATOR_FULL
+    command_cache = false;
+    command_cache_dirty = false;
+#endif
 
 #ifdef PROEVALUATOR_DEBUG
     debugLevel = 0;
@@ -93,6 +99,59 @@ QMakeGlobals::~QMakeGlobals()
     qDeleteAll(baseEnvs);
 }
 
+#ifndef PROEVALUATOR_FULL
+// Bump whenever the file format changes.
+static const quint32 commandCacheVersion = 1;
+
+void QMakeGlobals::enableCommandCache(const QString &fileName)
+{
+    command_cache = true;
+    command_cache_file = fileName;
+    if (fileName.isEmpty())
+        return;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_5_15);
+    quint32 version, count;
+    in >> version >> count;
+    if (version != commandCacheVersion)
+        return;
+    QHash<QByteArray, CommandResult> results;
+    for (quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray key;
+        CommandResult result;
+        qint32 exitCode;
+        in >> key >> result.out >> result.errout >> exitCode;
+        result.exitCode = exitCode;
+        results.insert(key, result);
+    }
+    // A truncated file is ignored as a whole.
+    if (in.status() == QDataStream::Ok)
+        command_results = results;
+}
+
+void QMakeGlobals::saveCommandCache()
+{
+    if (command_cache_file.isEmpty() || !command_cache_dirty)
+        return;
+
+    // The cache is merely an optimization, so failing to write it is not an error.
+    QSaveFile file(command_cache_file);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_5_15);
+    out << commandCacheVersion << quint32(command_results.count());
+    for (auto it = command_results.cbegin(), end = command_results.cend(); it != end; ++it)
+        out << it.key() << it->out << it->errout << qint32(it->exitCode);
+    if (file.commit())
+        command_cache_dirty = false;
+}
+#endif
+
 QString QMakeGlobals::cleanSpec(QMakeCmdLineParserState &state, const QString &spec)
 {
     QString ret = QDir::cleanPath(spec);
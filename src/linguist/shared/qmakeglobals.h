@@ -144,6 +144,14 @@ public:
     QString shadowedPath(const QString &fileName) const;
     QStringList splitPathList(const QString &value) const;
 
+#ifndef PROEVALUATOR_FULL
+    // Makes $$system() remember its results, keyed on the command, its working
+    // directory and environment, as projects tend to run the same probes in every
+    // sub-project. With a file name, the results also carry over between runs.
+    void enableCommandCache(const QString &fileName = QString());
+    void saveCommandCache();
+#endif
+
 private:
     QString getEnv(const QString &) const;
     QStringList getPathListEnv(const QString &var) const;
@@ -163,6 +171,21 @@ private:
 #endif
     QHash<QMakeBaseKey, QMakeBaseEnv *> baseEnvs;
 
+#ifndef PROEVALUATOR_FULL
+    struct CommandResult {
+        QByteArray out;
+        QByteArray errout;
+        int exitCode;
+    };
+# ifdef PROEVALUATOR_THREAD_SAFE
+    QMutex command_mutex;
+# endif
+    bool command_cache;
+    bool command_cache_dirty;
+    QString command_cache_file;
+    QHash<QByteArray, CommandResult> command_results;
+#endif
+
     friend class QMakeEvaluator;
 };
 
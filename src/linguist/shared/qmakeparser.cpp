@@ -32,7 +32,10 @@
 #include "ioutils.h"
 using namespace QMakeInternal;
 
+#include <qcryptographichash.h>
+#include <qdir.h>
 #include <qfile.h>
+#include <qsavefile.h>
 #ifdef PROPARSER_THREAD_SAFE
 # include <qthreadpool.h>
 #endif
@@ -124,6 +127,82 @@ void ProFileCache::discardFiles(const QString &prefix, QMakeVfs *vfs)
     }
 }
 
+// Bump whenever the token stream format changes.
+static const quint32 persistentMagic = 0x514d5046; // "QMPF"
+static const quint32 persistentVersion = 1;
+
+struct PersistentHeader {
+    quint32 magic;
+    quint32 version;
+    quint32 hostBuild;
+    quint32 length; // In ushorts
+};
+
+void ProFileCache::setPersistentDirectory(const QString &directory)
+{
+    // The cache is merely an optimization, so it is silently disabled if unusable.
+    if (QDir().mkpath(directory))
+        persistent_dir = QDir(directory).absolutePath();
+}
+
+QString ProFileCache::persistentFileName(const QString &fileName, const QString &contents) const
+{
+    QCryptographicHash hasher(QCryptographicHash::Sha1);
+    hasher.addData(reinterpret_cast<const char *>(&persistentVersion), sizeof(persistentVersion));
+    hasher.addData(QT_VERSION_STR);
+    // The parser expands $$_FILE_, so the name is part of the key.
+    hasher.addData(fileName.toUtf8());
+    hasher.addData(reinterpret_cast<const char *>(contents.constData()),
+                   contents.size() * sizeof(QChar));
+    return persistent_dir + QLatin1Char('/') + QString::fromLatin1(hasher.result().toHex());
+}
+
+ProFile *ProFileCache::loadPersistent(int id, const QString &fileName,
+                                      const QString &entryName) const
+{
+    QFile file(entryName);
+    if (!file.open(QIODevice::ReadOnly))
+        return nullptr;
+    const qint64 size = file.size();
+    if (size < qint64(sizeof(PersistentHeader)))
+        return nullptr;
+    uchar *data = file.map(0, size);
+    if (!data)
+        return nullptr;
+
+    ProFile *pro = nullptr;
+    PersistentHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic == persistentMagic && header.version == persistentVersion
+        && size == qint64(sizeof(header) + header.length * sizeof(ushort))) {
+        pro = new ProFile(id, fileName);
+        pro->setHostBuild(header.hostBuild);
+        QString *items = pro->itemsRef();
+        items->resize(header.length);
+        memcpy(items->data(), data + sizeof(header), header.length * sizeof(ushort));
+    }
+    file.unmap(data);
+    return pro;
+}
+
+void ProFileCache::storePersistent(const ProFile *pro, const QString &entryName) const
+{
+    // Concurrent writers of the same entry write the same data, so the
+    // atomic replacement is all the synchronization needed.
+    QSaveFile file(entryName);
+    if (!file.open(QIODevice::WriteOnly))
+        return;
+    PersistentHeader header;
+    header.magic = persistentMagic;
+    header.version = persistentVersion;
+    header.hostBuild = pro->isHostBuild();
+    header.length = pro->items().size();
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(pro->items().constData()),
+               header.length * sizeof(ushort));
+    file.commit();
+}
+
 ////////// Parser ///////////
 
 #define fL1S(s) QString::fromLatin1(s)
@@ -176,6 +255,7 @@ QMakeParser::QMakeParser(ProFileCache *cache, QMakeVfs *vfs, QMakeParserHandler
     : m_cache(cache)
     , m_handler(handler)
     , m_vfs(vfs)
+    , m_reported(false)
 {
     // So that single-threaded apps don't have to call initialize() for now.
     initialize();
@@ -217,8 +297,20 @@ ProFile *QMakeParser::parsedProFile(const QString &fileName, ParseFlags flags)
 #endif
             QString contents;
             if (readFile(id, flags, &contents)) {
-                pro = parsedProBlock(QStringRef(&contents), id, fileName, 1, FullGrammar);
-                pro->itemsRef()->squeeze();
+                QString persistentName;
+                pro = nullptr;
+                if (!m_cache->persistent_dir.isEmpty()) {
+                    persistentName = m_cache->persistentFileName(fileName, contents);
+                    pro = m_cache->loadPersistent(id, fileName, persistentName);
+                }
+                if (!pro) {
+                    m_reported = false;
+                    pro = parsedProBlock(QStringRef(&contents), id, fileName, 1, FullGrammar);
+                    pro->itemsRef()->squeeze();
+                    // Messages would not be repeated when loading the file later.
+                    if (!persistentName.isEmpty() && pro->isOk() && !m_reported)
+                        m_cache->storePersistent(pro, persistentName);
+                }
                 pro->ref();
             } else {
                 pro = nullptr;
@@ -1310,8 +1402,10 @@ bool QMakeParser::resolveVariable(ushort *xprPtr, int tlen, int needSep, ushort
 
 void QMakeParser::message(int type, const QString &msg) const
 {
-    if (!m_inError && m_handler)
+    if (!m_inError && m_handler) {
+        m_reported = true;
         m_handler->message(type, msg, m_proFile->fileName(), m_lineNo);
+    }
 }
 
 #ifdef PROPARSER_DEBUG
@@ -188,6 +188,7 @@ private:
     ProFileCache *m_cache;
     QMakeParserHandler *m_handler;
     QMakeVfs *m_vfs;
+    mutable bool m_reported; // Messages were issued while parsing the current file
 
     // This doesn't help gcc 3.3 ...
     template<typename T> friend class QTypeInfo;
@@ -207,7 +208,15 @@ public:
     void discardFile(const QString &fileName, QMakeVfs *vfs);
     void discardFiles(const QString &prefix, QMakeVfs *vfs);
 
+    // Also keep the parsed files in the given directory, keyed on their
+    // name and contents, so later processes need not parse them again.
+    void setPersistentDirectory(const QString &directory);
+
 private:
+    QString persistentFileName(const QString &fileName, const QString &contents) const;
+    ProFile *loadPersistent(int id, const QString &fileName, const QString &entryName) const;
+    void storePersistent(const ProFile *pro, const QString &entryName) const;
+
     struct Entry {
         ProFile *pro;
 #ifdef PROPARSER_THREAD_SAFE
@@ -222,6 +231,7 @@ private:
     };
 
     QHash<int, Entry> parsed_files;
+    QString persistent_dir;
 #ifdef PROPARSER_THREAD_SAFE
     QMutex mutex;
 #endif
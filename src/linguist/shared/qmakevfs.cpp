@@ -263,6 +263,69 @@ bool QMakeVfs::exists(const QString &fn, VfsFlags flags)
     return ex;
 }
 
+IoUtils::FileType QMakeVfs::fileType(const QString &fn)
+{
+#ifndef PROEVALUATOR_FULL
+    {
+# ifdef PROEVALUATOR_THREAD_SAFE
+        QMutexLocker locker(&m_mutex);
+# endif
+        auto it = m_fileTypes.constFind(fn);
+        if (it != m_fileTypes.constEnd())
+            return *it;
+    }
+#endif
+    IoUtils::FileType type = IoUtils::fileType(fn);
+#ifndef PROEVALUATOR_FULL
+# ifdef PROEVALUATOR_THREAD_SAFE
+    QMutexLocker locker(&m_mutex);
+# endif
+    m_fileTypes.insert(fn, type);
+#endif
+    return type;
+}
+
+QStringList QMakeVfs::directoryEntries(const QString &dirName)
+{
+    QString dir = dirName;
+    if (!dir.endsWith(QLatin1Char('/')))
+        dir += QLatin1Char('/');
+#ifndef PROEVALUATOR_FULL
+    {
+# ifdef PROEVALUATOR_THREAD_SAFE
+        QMutexLocker locker(&m_mutex);
+# endif
+        auto it = m_directories.constFind(dir);
+        if (it != m_directories.constEnd())
+            return *it;
+    }
+#endif
+    // The listing provides the types of the entries, so they need no stat() later.
+    QStringList names;
+    QHash<QString, IoUtils::FileType> types;
+    const QFileInfoList infos = QDir(dir).entryInfoList(QDir::AllEntries | QDir::NoDotAndDotDot,
+                                                        QDir::Name | QDir::IgnoreCase);
+    for (const QFileInfo &fi : infos) {
+        const QString name = fi.fileName();
+        names << name;
+        // Special files and broken links are classified differently per platform,
+        // so leave the few of them to the very same check an uncached lookup does.
+        const QString fileName = dir + name;
+        types.insert(fileName, fi.isDir() ? IoUtils::FileIsDir
+                               : fi.isFile() ? IoUtils::FileIsRegular
+                                             : IoUtils::fileType(fileName));
+    }
+#ifndef PROEVALUATOR_FULL
+# ifdef PROEVALUATOR_THREAD_SAFE
+    QMutexLocker locker(&m_mutex);
+# endif
+    m_directories.insert(dir, names);
+    for (auto it = types.cbegin(), end = types.cend(); it != end; ++it)
+        m_fileTypes.insert(it.key(), it.value());
+#endif
+    return names;
+}
+
 #ifndef PROEVALUATOR_FULL
 // This should be called when the sources may have changed (e.g., VCS update).
 void QMakeVfs::invalidateCache()
@@ -270,6 +333,8 @@ void QMakeVfs::invalidateCache()
 # ifdef PROEVALUATOR_THREAD_SAFE
     QMutexLocker locker(&m_mutex);
 # endif
+    m_fileTypes.clear();
+    m_directories.clear();
     auto it = m_files.begin(), eit = m_files.end();
     while (it != eit) {
         if (it->constData() == m_magicMissing.constData()
@@ -30,10 +30,12 @@
 #define QMAKEVFS_H
 
 #include "qmake_global.h"
+#include "ioutils.h"
 
 #include <qiodevice.h>
 #include <qhash.h>
 #include <qstring.h>
+#include <qstringlist.h>
 #ifdef PROEVALUATOR_THREAD_SAFE
 # include <qmutex.h>
 #endif
@@ -87,6 +89,12 @@ public:
     ReadResult readFile(int id, QString *contents, QString *errStr);
     bool exists(const QString &fn, QMakeVfs::VfsFlags flags);
 
+    // Like IoUtils::fileType() and a QDir listing of the real file system, but
+    // cached, as evaluating many projects probes the same paths over and over.
+    // Hidden files are not listed.
+    QMakeInternal::IoUtils::FileType fileType(const QString &fn);
+    QStringList directoryEntries(const QString &dirName);
+
 #ifndef PROEVALUATOR_FULL
     void invalidateCache();
     void invalidateContents();
@@ -128,6 +136,8 @@ private:
     QHash<int, QString> m_files;
     QString m_magicMissing;
     QString m_magicExisting;
+    QHash<QString, QMakeInternal::IoUtils::FileType> m_fileTypes;
+    QHash<QString, QStringList> m_directories; // Keyed on names ending with a slash
 #endif
 #ifndef QT_NO_TEXTCODEC
     const QTextCodec *m_textCodec;
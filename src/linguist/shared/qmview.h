@@ -0,0 +1,108 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#ifndef QMVIEW_H
+#define QMVIEW_H
+
+#include "translatormessage.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QFile>
+#include <QtCore/QPointer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+QT_BEGIN_NAMESPACE
+
+class ConversionData;
+class Translator;
+
+/*
+  Read-only view of a QM file. The file is memory-mapped where possible,
+  and messages are only decoded when they are asked for.
+
+  The messages are indexed in the order of the file's hash table, which
+  is also the order loadQM() appends them to a Translator in.
+*/
+class QmView
+{
+public:
+    QmView();
+    ~QmView();
+
+    bool load(const QString &fileName, ConversionData &cd);
+    // If dev is a QFile, the view is only valid while dev stays open.
+    bool load(QIODevice &dev, ConversionData &cd);
+
+    QString languageCode() const { return m_language; }
+    QStringList dependencies() const { return m_dependencies; }
+
+    int messageCount() const { return m_messageCount; }
+    TranslatorMessage message(int index, bool *utf8Fail = nullptr) const;
+
+    // Looks up a message the way QTranslator does; returns -1 if there is none.
+    int find(const QString &context, const QString &sourceText,
+             const QString &comment = QString()) const;
+
+    // Decodes all messages at once, which is what loadQM() does.
+    bool appendTo(Translator &translator, ConversionData &cd) const;
+
+private:
+    Q_DISABLE_COPY(QmView)
+
+    struct RawMessage;
+    void readRawMessage(int index, RawMessage *raw, bool withTranslations) const;
+    static void carryOver(const RawMessage &raw, RawMessage *state);
+    void ensureCheckpoints() const;
+    TranslatorMessage toMessage(const RawMessage &raw, bool *utf8Fail) const;
+    quint32 hashAt(int index) const;
+    int findRaw(const QByteArray &context, const QByteArray &sourceText,
+                const QByteArray &comment) const;
+    bool parse(const uchar *data, qint64 len, ConversionData &cd);
+    void unmap();
+
+    QFile m_file;
+    QPointer<QFile> m_mappedFile;
+    uchar *m_mapped;
+    QByteArray m_data;
+    const uchar *m_offsetArray;
+    const uchar *m_messageArray;
+    const uchar *m_messageEnd;
+    int m_messageCount;
+    bool m_guessPlurals;
+    QString m_language;
+    QStringList m_dependencies;
+    // The fields carried into every CheckpointInterval-th message, built on demand
+    enum { CheckpointInterval = 64 };
+    mutable QVector<RawMessage> m_checkpoints;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMVIEW_H
@@ -156,7 +156,7 @@ static bool saveQPH(const Translator &translator, QIODevice &dev, ConversionData
     if (!languageCode.isEmpty() && languageCode != QLatin1String("C"))
         t << " sourcelanguage=\"" << languageCode << "\"";
     t << ">\n";
-    foreach (const TranslatorMessage &msg, translator.messages()) {
+    foreach (const TranslatorMessage &msg, translator.constMessages()) {
         t << "<phrase>\n";
         t << "    <source>" << protect(msg.sourceText()) << "</source>\n";
         QString str = msg.translations().join(QLatin1Char('@'));
@@ -35,16 +35,11 @@
 #include <QtCore/qregexp.h>
 
 #include <cstdlib>
-#include <iostream>
 
 #ifdef Q_OS_UNIX
 #include <sys/wait.h>
 #endif
 
-class FMT {
-    Q_DECLARE_TR_FUNCTIONS(Linguist)
-};
-
 static QString qtToolFilePath(const QString &toolName)
 {
     QString filePath = QCoreApplication::instance()->applicationDirPath()
@@ -55,11 +50,6 @@ static QString qtToolFilePath(const QString &toolName)
     return QDir::cleanPath(filePath);
 }
 
-static void printErr(const QString &out)
-{
-    std::cerr << qUtf8Printable(out);
-}
-
 static QString shellQuoted(const QString &str)
 {
     static QRegExp rx(QStringLiteral("\\s"));
@@ -104,16 +94,3 @@ void runQtTool(const QString &toolName, const QStringList &arguments)
     if (exitCode != 0)
         exit(exitCode);
 }
-
-std::unique_ptr<QTemporaryFile> createProjectDescription(QStringList args)
-{
-    std::unique_ptr<QTemporaryFile> file(new QTemporaryFile(QStringLiteral("XXXXXX.json")));
-    if (!file->open()) {
-        printErr(FMT::tr("Cannot create temporary file: %1\n").arg(file->errorString()));
-        exit(1);
-    }
-    file->close();
-    args << QStringLiteral("-out") << file->fileName();
-    runQtTool(QStringLiteral("lprodump"), args);
-    return file;
-}
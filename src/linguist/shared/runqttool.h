@@ -31,11 +31,7 @@
 
 #include <QtCore/qstring.h>
 #include <QtCore/qstringlist.h>
-#include <QtCore/qtemporaryfile.h>
-
-#include <memory>
 
 void runQtTool(const QString &toolName, const QStringList &arguments);
-std::unique_ptr<QTemporaryFile> createProjectDescription(QStringList args);
 
 #endif // RUNQTTOOL_H
@@ -32,6 +32,9 @@
 #include <QtCore/QByteArray>
 #include <QtCore/QString>
 #include <QtCore/QList>
+#include <QtCore/qalgorithms.h>
+
+#include <algorithm>
 
 
 QT_BEGIN_NAMESPACE
@@ -96,29 +99,6 @@ static const int indexOf[256] = {
     15, 12, 16, 17, 18, 19, 2,  10, 15, 7,  19, 2,  6,  7,  10, 0
 };
 
-/*
-  The entry bitCount[i] (for i between 0 and 255) is the number of bits used to
-  represent i in binary.
-*/
-static const int bitCount[256] = {
-    0,  1,  1,  2,  1,  2,  2,  3,  1,  2,  2,  3,  2,  3,  3,  4,
-    1,  2,  2,  3,  2,  3,  3,  4,  2,  3,  3,  4,  3,  4,  4,  5,
-    1,  2,  2,  3,  2,  3,  3,  4,  2,  3,  3,  4,  3,  4,  4,  5,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    1,  2,  2,  3,  2,  3,  3,  4,  2,  3,  3,  4,  3,  4,  4,  5,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    3,  4,  4,  5,  4,  5,  5,  6,  4,  5,  5,  6,  5,  6,  6,  7,
-    1,  2,  2,  3,  2,  3,  3,  4,  2,  3,  3,  4,  3,  4,  4,  5,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    3,  4,  4,  5,  4,  5,  5,  6,  4,  5,  5,  6,  5,  6,  6,  7,
-    2,  3,  3,  4,  3,  4,  4,  5,  3,  4,  4,  5,  4,  5,  5,  6,
-    3,  4,  4,  5,  4,  5,  5,  6,  4,  5,  5,  6,  5,  6,  6,  7,
-    3,  4,  4,  5,  4,  5,  5,  6,  4,  5,  5,  6,  5,  6,  6,  7,
-    4,  5,  5,  6,  5,  6,  6,  7,  5,  6,  6,  7,  6,  7,  7,  8
-};
-
 static inline void setCoOccurence(CoMatrix &m, char c, char d)
 {
     int k = indexOf[(uchar) c] + 20 * indexOf[(uchar) d];
@@ -144,11 +124,12 @@ CoMatrix::CoMatrix(const QString &str)
     }
 }
 
+// The two padding bytes at the end are always zero.
 static inline int worth(const CoMatrix &m)
 {
     int w = 0;
-    for (int i = 0; i < 50; i++)
-        w += bitCount[m.b[i]];
+    for (int i = 0; i < 13; ++i)
+        w += qPopulationCount(m.w[i]);
     return w;
 }
 
@@ -174,29 +155,120 @@ StringSimilarityMatcher::StringSimilarityMatcher(const QString &stringToMatch)
     m_length = stringToMatch.length();
 }
 
-int StringSimilarityMatcher::getSimilarityScore(const QString &strCandidate)
+static inline int similarityScore(const CoMatrix &m, int mLength, const CoMatrix &n, int nLength)
 {
-    CoMatrix cmTarget(strCandidate);
-    int delta = qAbs(m_length - strCandidate.size());
-    int score = ( (worth(intersection(m_cm, cmTarget)) + 1) << 10 ) /
-        ( worth(reunion(m_cm, cmTarget)) + (delta << 1) + 1 );
+    int delta = qAbs(mLength - nLength);
+    int score = ( (worth(intersection(m, n)) + 1) << 10 ) /
+        ( worth(reunion(m, n)) + (delta << 1) + 1 );
     return score;
 }
 
-CandidateList similarTextHeuristicCandidates(const Translator *tor,
-    const QString &text, int maxCandidates)
+int StringSimilarityMatcher::getSimilarityScore(const QString &strCandidate)
 {
-    QList<int> scores;
-    CandidateList candidates;
-    StringSimilarityMatcher matcher(text);
+    return similarityScore(m_cm, m_length, CoMatrix(strCandidate), strCandidate.size());
+}
+
+void SimilarTextIndex::clear()
+{
+    m_entries.clear();
+    m_lengthOrder.clear();
+    m_lengthOrderOk = true;
+}
+
+void SimilarTextIndex::addText(const QString &text)
+{
+    Entry entry;
+    entry.cm = CoMatrix(text);
+    entry.worth = worth(entry.cm);
+    entry.length = text.length();
+    m_entries.append(entry);
+    m_lengthOrderOk = false;
+}
+
+/*
+  The intersection of two matrices has at most as many bits as the smaller
+  one, and the union at least as many as the bigger one. This gives an upper
+  bound for the score which does not need the actual matrices.
+*/
+static inline int maximumScore(int worth1, int worth2, int delta)
+{
+    return ((qMin(worth1, worth2) + 1) << 10) / (qMax(worth1, worth2) + (delta << 1) + 1);
+}
+
+QVector<SimilarTextIndex::Match> SimilarTextIndex::findSimilar(const QString &text) const
+{
+    QVector<Match> matches;
+    if (m_entries.isEmpty())
+        return matches;
+
+    if (!m_lengthOrderOk) {
+        m_lengthOrderOk = true;
+        m_lengthOrder.resize(m_entries.count());
+        for (int i = 0; i < m_entries.count(); ++i)
+            m_lengthOrder[i] = i;
+        std::stable_sort(m_lengthOrder.begin(), m_lengthOrder.end(), [this](int i, int j) {
+            return m_entries.at(i).length < m_entries.at(j).length;
+        });
+    }
 
-    foreach (const TranslatorMessage &mtm, tor->messages()) {
+    const CoMatrix cm(text);
+    const int textWorth = worth(cm);
+    const int length = text.length();
+
+    // Even a perfect overlap cannot make up for more than this length difference.
+    const int slack = (((textWorth + 1) << 10) / textSimilarityThreshold) - textWorth - 1;
+    if (slack < 0)
+        return matches;
+    const int maxDelta = slack >> 1;
+
+    const auto lengthLess = [this](int entry, int length) {
+        return m_entries.at(entry).length < length;
+    };
+    auto it = std::lower_bound(m_lengthOrder.cbegin(), m_lengthOrder.cend(),
+                               length - maxDelta, lengthLess);
+    for (; it != m_lengthOrder.cend(); ++it) {
+        const Entry &entry = m_entries.at(*it);
+        const int delta = qAbs(length - entry.length);
+        if (entry.length > length && delta > maxDelta)
+            break;
+        if (maximumScore(textWorth, entry.worth, delta) < textSimilarityThreshold)
+            continue;
+        const int score = similarityScore(cm, length, entry.cm, entry.length);
+        if (score >= textSimilarityThreshold) {
+            const Match match = { *it, score };
+            matches.append(match);
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const Match &m1, const Match &m2) {
+        return m1.entry < m2.entry;
+    });
+    return matches;
+}
+
+TranslatorTextIndex::TranslatorTextIndex(const Translator *tor)
+    : translator(tor)
+{
+    for (int i = 0; i < tor->messageCount(); ++i) {
+        const TranslatorMessage &mtm = tor->constMessage(i);
         if (mtm.type() == TranslatorMessage::Unfinished
             || mtm.translation().isEmpty())
             continue;
+        messages << i;
+        texts.addText(mtm.sourceText());
+    }
+}
+
+CandidateList similarTextHeuristicCandidates(const TranslatorTextIndex &index,
+    const QString &text, int maxCandidates)
+{
+    QList<int> scores;
+    CandidateList candidates;
 
+    foreach (const SimilarTextIndex::Match &match, index.texts.findSimilar(text)) {
+        const TranslatorMessage &mtm =
+                index.translator->constMessage(index.messages.at(match.entry));
         QString s = mtm.sourceText();
-        int score = matcher.getSimilarityScore(s);
+        int score = match.score;
 
         if (candidates.size() == maxCandidates && score > scores[maxCandidates - 1] )
             candidates.removeLast();
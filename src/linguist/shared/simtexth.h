@@ -33,6 +33,7 @@ const int textSimilarityThreshold = 190;
 
 #include <QString>
 #include <QList>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 
@@ -92,6 +93,40 @@ private:
     int m_length;
 };
 
+/**
+ * Keeps the co-occurrence matrices of a set of texts, so they can be searched
+ * for similar texts repeatedly without recomputing them.
+ * Texts whose length and number of co-occurrences rule out a score of at least
+ * textSimilarityThreshold are skipped without scoring them.
+ * \sa StringSimilarityMatcher
+ */
+class SimilarTextIndex {
+public:
+    struct Match {
+        int entry; // in the order the texts were added
+        int score;
+    };
+
+    SimilarTextIndex() : m_lengthOrderOk(true) {}
+    void clear();
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int count() const { return m_entries.count(); }
+    void addText(const QString &text);
+    // The matches are ordered by entry.
+    QVector<Match> findSimilar(const QString &text) const;
+
+private:
+    struct Entry {
+        CoMatrix cm;
+        int worth;
+        int length;
+    };
+
+    QVector<Entry> m_entries;
+    mutable QVector<int> m_lengthOrder; // entries sorted by length
+    mutable bool m_lengthOrderOk;
+};
+
 /**
  * Checks how similar two strings are.
  * The return value is the score, and a higher score is more similar
@@ -104,7 +139,21 @@ static inline int getSimilarityScore(const QString &str1, const QString &str2)
     return StringSimilarityMatcher(str1).getSimilarityScore(str2);
 }
 
-CandidateList similarTextHeuristicCandidates( const Translator *tor,
+/**
+ * The finished messages of a Translator, indexed for
+ * similarTextHeuristicCandidates(). Build it once and reuse it for as long
+ * as the Translator does not change.
+ */
+struct TranslatorTextIndex
+{
+    explicit TranslatorTextIndex(const Translator *tor);
+
+    const Translator *translator;
+    QVector<int> messages; // the message of each entry of texts
+    SimilarTextIndex texts;
+};
+
+CandidateList similarTextHeuristicCandidates( const TranslatorTextIndex &index,
                                               const QString &text,
                                               int maxCandidates );
 
@@ -52,8 +52,11 @@
 QT_BEGIN_NAMESPACE
 
 Translator::Translator() :
+    m_sink(nullptr),
     m_locationsType(AbsoluteLocations),
-    m_indexOk(true)
+    m_indexOk(true),
+    m_locationIndexOk(false),
+    m_deferAppends(false)
 {
 }
 
@@ -75,15 +78,32 @@ QList<Translator::FileFormat> &Translator::registeredFileFormats()
     return theFormats;
 }
 
+// Among equal keys, the last message wins, no matter in which order they were indexed.
+template <typename Key>
+static void setIndexSlot(QHash<Key, int> &hash, const Key &key, int slot,
+                         const QVector<int> &positions)
+{
+    typename QHash<Key, int>::Iterator it = hash.find(key);
+    if (it == hash.end())
+        hash.insert(key, slot);
+    else if (positions.at(*it) < positions.at(slot))
+        *it = slot;
+}
+
 void Translator::addIndex(int idx, const TranslatorMessage &msg) const
 {
+    const int slot = m_indexPositions.count();
+    m_indexPositions.append(idx);
     if (msg.sourceText().isEmpty() && msg.id().isEmpty()) {
-        m_ctxCmtIdx[msg.context()] = idx;
+        setIndexSlot(m_ctxCmtIdx, msg.context(), slot, m_indexPositions);
     } else {
-        m_msgIdx[TMMKey(msg)] = idx;
+        setIndexSlot(m_msgIdx, TMMKey(msg), slot, m_indexPositions);
         if (!msg.id().isEmpty())
-            m_idMsgIdx[msg.id()] = idx;
+            setIndexSlot(m_idMsgIdx, msg.id(), slot, m_indexPositions);
     }
+    // Re-indexed messages leave unused slots behind. Start afresh once they dominate.
+    if (m_indexPositions.count() > 2 * m_messages.count() + 64)
+        m_indexOk = false;
 }
 
 void Translator::delIndex(int idx) const
@@ -105,6 +125,8 @@ void Translator::ensureIndexed() const
         m_ctxCmtIdx.clear();
         m_idMsgIdx.clear();
         m_msgIdx.clear();
+        m_indexPositions.clear();
+        m_indexPositions.reserve(m_messages.count());
         for (int i = 0; i < m_messages.count(); i++)
             addIndex(i, m_messages.at(i));
     }
@@ -117,7 +139,11 @@ void Translator::replaceSorted(const TranslatorMessage &msg)
         appendSorted(msg);
     } else {
         delIndex(index);
+        const TranslatorMessage &omsg = m_messages.at(index);
+        if (omsg.fileName() != msg.fileName() || omsg.context() != msg.context())
+            m_locationIndexOk = false;
         m_messages[index] = msg;
+        internStrings(m_messages[index]);
         addIndex(index, msg);
     }
 }
@@ -135,64 +161,280 @@ static QString makeMsgId(const TranslatorMessage &msg)
     return id;
 }
 
-void Translator::extend(const TranslatorMessage &msg, ConversionData &cd)
+int Translator::extendTarget(const TranslatorMessage &msg, ConversionData &cd)
 {
     int index = find(msg);
     if (index == -1) {
         append(msg);
-    } else {
-        TranslatorMessage &emsg = m_messages[index];
-        if (emsg.sourceText().isEmpty()) {
-            delIndex(index);
-            emsg.setSourceText(msg.sourceText());
-            addIndex(index, msg);
-        } else if (!msg.sourceText().isEmpty() && emsg.sourceText() != msg.sourceText()) {
-            cd.appendError(QString::fromLatin1("Contradicting source strings for message with id '%1'.")
-                           .arg(emsg.id()));
-            return;
-        }
-        if (emsg.extras().isEmpty()) {
-            emsg.setExtras(msg.extras());
-        } else if (!msg.extras().isEmpty() && emsg.extras() != msg.extras()) {
-            cd.appendError(QString::fromLatin1("Contradicting meta data for for %1.")
-                           .arg(!emsg.id().isEmpty()
-                                ? QString::fromLatin1("message with id '%1'").arg(emsg.id())
-                                : QString::fromLatin1("message '%1'").arg(makeMsgId(msg))));
-            return;
+        return -1;
+    }
+    TranslatorMessage &emsg = m_messages[index];
+    if (emsg.sourceText().isEmpty()) {
+        delIndex(index);
+        emsg.setSourceText(msg.sourceText());
+        addIndex(index, msg);
+    } else if (!msg.sourceText().isEmpty() && emsg.sourceText() != msg.sourceText()) {
+        cd.appendError(QString::fromLatin1("Contradicting source strings for message with id '%1'.")
+                       .arg(emsg.id()));
+        return -1;
+    }
+    if (emsg.extras().isEmpty()) {
+        emsg.setExtras(msg.extras());
+    } else if (!msg.extras().isEmpty() && emsg.extras() != msg.extras()) {
+        cd.appendError(QString::fromLatin1("Contradicting meta data for for %1.")
+                       .arg(!emsg.id().isEmpty()
+                            ? QString::fromLatin1("message with id '%1'").arg(emsg.id())
+                            : QString::fromLatin1("message '%1'").arg(makeMsgId(msg))));
+        return -1;
+    }
+    return index;
+}
+
+static const char extraCommentSeparator[] = "\n----------\n";
+
+void Translator::extend(const TranslatorMessage &msg, ConversionData &cd)
+{
+    int index = extendTarget(msg, cd);
+    if (index == -1)
+        return;
+    TranslatorMessage &emsg = m_messages[index];
+    emsg.addReferenceUniq(internedString(msg.fileName()), msg.lineNumber());
+    if (!msg.extraComment().isEmpty()) {
+        QString cmt = emsg.extraComment();
+        if (!cmt.isEmpty()) {
+            QStringList cmts = cmt.split(QLatin1String(extraCommentSeparator));
+            if (!cmts.contains(msg.extraComment())) {
+                cmts.append(msg.extraComment());
+                cmt = cmts.join(QLatin1String(extraCommentSeparator));
+            }
+        } else {
+            cmt = msg.extraComment();
         }
-        emsg.addReferenceUniq(msg.fileName(), msg.lineNumber());
-        if (!msg.extraComment().isEmpty()) {
-            QString cmt = emsg.extraComment();
-            if (!cmt.isEmpty()) {
-                QStringList cmts = cmt.split(QLatin1String("\n----------\n"));
-                if (!cmts.contains(msg.extraComment())) {
-                    cmts.append(msg.extraComment());
-                    cmt = cmts.join(QLatin1String("\n----------\n"));
+        emsg.setExtraComment(cmt);
+    }
+}
+
+// The references and extra comments of a message hit by extend(QList) more than once
+struct MergedMessage
+{
+    QSet<QPair<QString, int> > refs;
+    QSet<QString> cmtSet;
+    QStringList cmts;
+    bool cmtsChanged = false;
+};
+
+// Equivalent to calling extend() for every message of every source in turn. The
+// references and extra comments of the messages hit repeatedly are collected in hashes
+// and written back once at the end, so the cost does not grow with the number of hits.
+void Translator::extend(const QList<const Translator *> &sources, ConversionData &cd)
+{
+    QHash<int, MergedMessage> merged;
+    for (const Translator *source : sources) {
+        for (const TranslatorMessage &msg : source->m_messages) {
+            int index = extendTarget(msg, cd);
+            if (index == -1)
+                continue;
+            TranslatorMessage &emsg = m_messages[index];
+            QHash<int, MergedMessage>::Iterator it = merged.find(index);
+            if (it == merged.end()) {
+                it = merged.insert(index, MergedMessage());
+                foreach (const TranslatorMessage::Reference &ref, emsg.allReferences())
+                    it->refs.insert(qMakePair(ref.fileName(), ref.lineNumber()));
+                if (!emsg.extraComment().isEmpty()) {
+                    it->cmts = emsg.extraComment().split(QLatin1String(extraCommentSeparator));
+                    it->cmtSet = QSet<QString>(it->cmts.constBegin(), it->cmts.constEnd());
                 }
-            } else {
-                cmt = msg.extraComment();
             }
-            emsg.setExtraComment(cmt);
+            const QString fileName = internedString(msg.fileName());
+            if (emsg.fileName().isEmpty()) {
+                emsg.addReferenceUniq(fileName, msg.lineNumber());
+                it->refs.insert(qMakePair(fileName, msg.lineNumber()));
+            } else if (!it->refs.contains(qMakePair(fileName, msg.lineNumber()))) {
+                emsg.addReference(fileName, msg.lineNumber());
+                it->refs.insert(qMakePair(fileName, msg.lineNumber()));
+            }
+            const QString cmt = msg.extraComment();
+            if (!cmt.isEmpty() && !it->cmtSet.contains(cmt)) {
+                // A comment is matched as a whole, but its parts are what later ones
+                // are compared against, just like after a round trip through the string.
+                foreach (const QString &part, cmt.split(QLatin1String(extraCommentSeparator))) {
+                    it->cmts.append(part);
+                    it->cmtSet.insert(part);
+                }
+                it->cmtsChanged = true;
+            }
         }
     }
+    for (QHash<int, MergedMessage>::ConstIterator it = merged.constBegin();
+         it != merged.constEnd(); ++it) {
+        if (it->cmtsChanged)
+            m_messages[it.key()].setExtraComment(it->cmts.join(QLatin1String(extraCommentSeparator)));
+    }
 }
 
 void Translator::insert(int idx, const TranslatorMessage &msg)
 {
     if (m_indexOk) {
-        if (idx == m_messages.count())
-            addIndex(idx, msg);
-        else
-            m_indexOk = false;
+        if (idx != m_messages.count()) {
+            for (int &pos : m_indexPositions) {
+                if (pos >= idx)
+                    ++pos;
+            }
+        }
+        addIndex(idx, msg);
     }
     m_messages.insert(idx, msg);
+    internStrings(m_messages[idx]);
+}
+
+QString Translator::internedString(const QString &str)
+{
+    if (str.isEmpty())
+        return str;
+    QSet<QString>::const_iterator it = m_stringPool.constFind(str);
+    if (it != m_stringPool.constEnd())
+        return *it;
+    m_stringPool.insert(str);
+    return str;
+}
+
+void Translator::internStrings(TranslatorMessage &msg)
+{
+    msg.setContext(internedString(msg.context()));
+    msg.setComment(internedString(msg.comment()));
+    if (msg.extraReferences().isEmpty()) {
+        msg.setFileName(internedString(msg.fileName()));
+    } else {
+        TranslatorMessage::References refs;
+        foreach (const TranslatorMessage::Reference &ref, msg.allReferences())
+            refs.append(TranslatorMessage::Reference(internedString(ref.fileName()), ref.lineNumber()));
+        msg.setReferences(refs);
+    }
+}
+
+static bool sameLocationKey(const TranslatorMessage &msg1, const TranslatorMessage &msg2)
+{
+    return msg1.fileName() == msg2.fileName() && msg1.context() == msg2.context();
+}
+
+void Translator::ensureLocationIndexed()
+{
+    if (!m_locationIndexOk) {
+        m_locationIndexOk = true;
+        m_locationRuns.clear();
+        m_locationRunIdx.clear();
+        for (int i = 0; i < m_messages.count(); i++) {
+            const TranslatorMessage &msg = m_messages.at(i);
+            if (i && sameLocationKey(m_messages.at(i - 1), msg)) {
+                ++m_locationRuns.last().count;
+            } else {
+                const LocationRun run = { i, 1 };
+                m_locationRunIdx[LocationKey(msg.fileName(), msg.context())] << m_locationRuns.count();
+                m_locationRuns << run;
+            }
+        }
+    }
 }
 
 void Translator::append(const TranslatorMessage &msg)
 {
+    if (m_sink) {
+        m_sink->put(*this, msg);
+        return;
+    }
+    if (m_deferAppends) {
+        TranslatorMessage copy = msg;
+        internStrings(copy);
+        if (!m_locationRuns.isEmpty()) {
+            LocationRun &run = m_locationRuns.last();
+            if (sameLocationKey(runMessages(m_locationRuns.count() - 1)[run.count - 1], msg)) {
+                runContents(m_locationRuns.count() - 1).append(copy);
+                ++run.count;
+                return;
+            }
+        }
+        const LocationRun run = { -1, 1 };
+        m_locationRunIdx[LocationKey(msg.fileName(), msg.context())] << m_locationRuns.count();
+        m_runContents.insert(m_locationRuns.count(), QVector<TranslatorMessage>() << copy);
+        m_locationRuns << run;
+        return;
+    }
+    if (m_locationIndexOk) {
+        if (!m_messages.isEmpty() && sameLocationKey(m_messages.last(), msg)) {
+            ++m_locationRuns.last().count;
+        } else {
+            const LocationRun run = { m_messages.count(), 1 };
+            m_locationRunIdx[LocationKey(msg.fileName(), msg.context())] << m_locationRuns.count();
+            m_locationRuns << run;
+        }
+    }
     insert(m_messages.count(), msg);
 }
 
+// The messages of a run, wherever they are kept at the moment
+const TranslatorMessage *Translator::runMessages(int runId) const
+{
+    if (m_deferAppends) {
+        QHash<int, QVector<TranslatorMessage> >::ConstIterator it = m_runContents.constFind(runId);
+        if (it != m_runContents.constEnd())
+            return it->constData();
+    }
+    return m_messages.constData() + m_locationRuns.at(runId).start;
+}
+
+// Takes a run out of m_messages, so messages can be inserted into it cheaply.
+QVector<TranslatorMessage> &Translator::runContents(int runId)
+{
+    QHash<int, QVector<TranslatorMessage> >::Iterator it = m_runContents.find(runId);
+    if (it == m_runContents.end()) {
+        const LocationRun &run = m_locationRuns.at(runId);
+        QVector<TranslatorMessage> contents;
+        contents.reserve(run.count + 1);
+        for (int i = run.start; i < run.start + run.count; ++i)
+            contents.append(m_messages.at(i));
+        it = m_runContents.insert(runId, contents);
+    }
+    return *it;
+}
+
+void Translator::beginSortedAppends()
+{
+    ensureLocationIndexed();
+    m_deferAppends = true;
+}
+
+// Splices the changed runs back in one pass. Doing so after every message made
+// merging large catalogues quadratic, as every insertion moved all later messages.
+void Translator::endSortedAppends()
+{
+    if (!m_deferAppends)
+        return;
+    m_deferAppends = false;
+    if (m_runContents.isEmpty())
+        return;
+
+    QVector<TranslatorMessage> messages;
+    int total = 0;
+    for (const LocationRun &run : qAsConst(m_locationRuns))
+        total += run.count;
+    messages.reserve(total);
+    for (int runId = 0; runId < m_locationRuns.count(); ++runId) {
+        LocationRun &run = m_locationRuns[runId];
+        QHash<int, QVector<TranslatorMessage> >::ConstIterator it = m_runContents.constFind(runId);
+        const int start = messages.count();
+        if (it != m_runContents.constEnd()) {
+            messages += *it;
+        } else {
+            for (int i = run.start; i < run.start + run.count; ++i)
+                messages.append(m_messages.at(i));
+        }
+        run.start = start;
+    }
+    m_messages.swap(messages);
+    m_runContents.clear();
+    m_indexOk = false;
+}
+
 void Translator::appendSorted(const TranslatorMessage &msg)
 {
     int msgLine = msg.lineNumber();
@@ -201,55 +443,83 @@ void Translator::appendSorted(const TranslatorMessage &msg)
         return;
     }
 
+    // Only the messages from the same file and context are of interest. All others
+    // merely split them into runs, which the location index already knows about.
+    ensureLocationIndexed();
+    const QVector<int> runIds =
+            m_locationRunIdx.value(LocationKey(msg.fileName(), msg.context()));
+
+    // Insertion points are offsets into a run; regions never span runs.
     int bestIdx = 0; // Best insertion point found so far
+    int bestRun = -1; // The run it belongs to
     int bestScore = 0; // Its category: 0 = no hit, 1 = pre or post, 2 = middle
     int bestSize = 0; // The length of the region. Longer is better within one category.
 
     // The insertion point to use should this region turn out to be the best one so far
     int thisIdx = 0;
+    int thisRun = -1;
     int thisScore = 0;
     int thisSize = 0;
     // Working vars
     int prevLine = 0;
-    int curIdx = 0;
-    foreach (const TranslatorMessage &mit, m_messages) {
-        bool sameFile = mit.fileName() == msg.fileName() && mit.context() == msg.context();
-        int curLine;
-        if (sameFile && (curLine = mit.lineNumber()) >= prevLine) {
-            if (msgLine >= prevLine && msgLine < curLine) {
-                thisIdx = curIdx;
-                thisScore = thisSize ? 2 : 1;
-            }
-            ++thisSize;
-            prevLine = curLine;
-        } else {
-            if (thisSize) {
-                if (!thisScore) {
+    auto endRegion = [&](int curIdx, int runId) {
+        if (!thisScore) {
+            thisIdx = curIdx;
+            thisRun = runId;
+            thisScore = 1;
+        }
+        if (thisScore > bestScore || (thisScore == bestScore && thisSize > bestSize)) {
+            bestIdx = thisIdx;
+            bestRun = thisRun;
+            bestScore = thisScore;
+            bestSize = thisSize;
+        }
+        thisScore = 0;
+        prevLine = 0;
+    };
+    foreach (int runId, runIds) {
+        const TranslatorMessage *runMsgs = runMessages(runId);
+        const int runEnd = m_locationRuns.at(runId).count;
+        for (int curIdx = 0; curIdx < runEnd; ++curIdx) {
+            int curLine = runMsgs[curIdx].lineNumber();
+            if (curLine >= prevLine) {
+                if (msgLine >= prevLine && msgLine < curLine) {
                     thisIdx = curIdx;
-                    thisScore = 1;
-                }
-                if (thisScore > bestScore || (thisScore == bestScore && thisSize > bestSize)) {
-                    bestIdx = thisIdx;
-                    bestScore = thisScore;
-                    bestSize = thisSize;
+                    thisRun = runId;
+                    thisScore = thisSize ? 2 : 1;
                 }
-                thisScore = 0;
-                thisSize = sameFile ? 1 : 0;
-                prevLine = 0;
+                ++thisSize;
+                prevLine = curLine;
+            } else if (thisSize) {
+                endRegion(curIdx, runId);
+                thisSize = 1;
             }
         }
-        ++curIdx;
-    }
-    if (thisSize && !thisScore) {
-        thisIdx = curIdx;
-        thisScore = 1;
+        // Whatever follows the run is from another file or context, or the end.
+        if (thisSize) {
+            endRegion(runEnd, runId);
+            thisSize = 0;
+        }
     }
-    if (thisScore > bestScore || (thisScore == bestScore && thisSize > bestSize))
-        insert(thisIdx, msg);
-    else if (bestScore)
-        insert(bestIdx, msg);
-    else
+    if (!bestScore) {
         append(msg);
+        return;
+    }
+
+    if (m_deferAppends) {
+        TranslatorMessage copy = msg;
+        internStrings(copy);
+        runContents(bestRun).insert(bestIdx, copy);
+        ++m_locationRuns[bestRun].count;
+        return;
+    }
+
+    // Inserting next to the messages of one run never splits another one.
+    const int idx = m_locationRuns.at(bestRun).start + bestIdx;
+    ++m_locationRuns[bestRun].count;
+    for (int i = bestRun + 1; i < m_locationRuns.count(); ++i)
+        ++m_locationRuns[i].start;
+    insert(idx, msg);
 }
 
 static QString guessFormat(const QString &filename, const QString &format)
@@ -310,9 +580,8 @@ bool Translator::load(const QString &filename, ConversionData &cd, const QString
 }
 
 
-bool Translator::save(const QString &filename, ConversionData &cd, const QString &format) const
+bool Translator::openForWriting(QFile &file, const QString &filename, ConversionData &cd)
 {
-    QFile file;
     if (filename.isEmpty() || filename == QLatin1String("-")) {
 #ifdef Q_OS_WIN
         // QFile is broken for text files
@@ -331,6 +600,14 @@ bool Translator::save(const QString &filename, ConversionData &cd, const QString
             return false;
         }
     }
+    return true;
+}
+
+bool Translator::save(const QString &filename, ConversionData &cd, const QString &format) const
+{
+    QFile file;
+    if (!openForWriting(file, filename, cd))
+        return false;
 
     QString fmt = guessFormat(filename, format);
     cd.m_targetDir = QFileInfo(filename).absoluteDir();
@@ -349,6 +626,38 @@ bool Translator::save(const QString &filename, ConversionData &cd, const QString
     return false;
 }
 
+bool Translator::canStream(const QString &filename, const QString &format)
+{
+    QString fmt = guessFormat(filename, format);
+    foreach (const FileFormat &format, registeredFileFormats()) {
+        if (fmt == format.extension)
+            return format.streamWriter != 0;
+    }
+    return false;
+}
+
+TranslatorStreamWriter *Translator::createStreamWriter(QFile &file, const QString &filename,
+                                                       ConversionData &cd, const QString &format)
+{
+    QString fmt = guessFormat(filename, format);
+    foreach (const FileFormat &format, registeredFileFormats()) {
+        if (fmt == format.extension) {
+            if (!format.streamWriter) {
+                cd.appendError(QString(QLatin1String("Cannot stream %1 files")).arg(fmt));
+                return 0;
+            }
+            if (!openForWriting(file, filename, cd))
+                return 0;
+            cd.m_targetDir = QFileInfo(filename).absoluteDir();
+            return (*format.streamWriter)(file, cd);
+        }
+    }
+
+    cd.appendError(QString(QLatin1String("Unknown format %1 for file %2"))
+        .arg(format).arg(filename));
+    return 0;
+}
+
 QString Translator::makeLanguageCode(QLocale::Language language, QLocale::Country country)
 {
     QString result = QLocalePrivate::languageToCode(language);
@@ -370,11 +679,11 @@ int Translator::find(const TranslatorMessage &msg) const
 {
     ensureIndexed();
     if (msg.id().isEmpty())
-        return m_msgIdx.value(TMMKey(msg), -1);
-    int i = m_idMsgIdx.value(msg.id(), -1);
+        return indexPosition(m_msgIdx.value(TMMKey(msg), -1));
+    int i = indexPosition(m_idMsgIdx.value(msg.id(), -1));
     if (i >= 0)
         return i;
-    i = m_msgIdx.value(TMMKey(msg), -1);
+    i = indexPosition(m_msgIdx.value(TMMKey(msg), -1));
     // If both have an id, then find only by id.
     return i >= 0 && m_messages.at(i).id().isEmpty() ? i : -1;
 }
@@ -400,7 +709,7 @@ int Translator::find(const QString &context,
 int Translator::find(const QString &context) const
 {
     ensureIndexed();
-    return m_ctxCmtIdx.value(context, -1);
+    return indexPosition(m_ctxCmtIdx.value(context, -1));
 }
 
 void Translator::stripObsoleteMessages()
@@ -411,6 +720,7 @@ void Translator::stripObsoleteMessages()
         else
             ++it;
     m_indexOk = false;
+    m_locationIndexOk = false;
 }
 
 void Translator::stripFinishedMessages()
@@ -421,6 +731,7 @@ void Translator::stripFinishedMessages()
         else
             ++it;
     m_indexOk = false;
+    m_locationIndexOk = false;
 }
 
 void Translator::stripUntranslatedMessages()
@@ -431,6 +742,7 @@ void Translator::stripUntranslatedMessages()
         else
             ++it;
     m_indexOk = false;
+    m_locationIndexOk = false;
 }
 
 bool Translator::translationsExist()
@@ -452,6 +764,7 @@ void Translator::stripEmptyContexts()
         else
             ++it;
     m_indexOk = false;
+    m_locationIndexOk = false;
 }
 
 void Translator::stripNonPluralForms()
@@ -462,6 +775,7 @@ void Translator::stripNonPluralForms()
         else
             ++it;
     m_indexOk = false;
+    m_locationIndexOk = false;
 }
 
 void Translator::stripIdenticalSourceTranslations()
@@ -474,35 +788,45 @@ void Translator::stripIdenticalSourceTranslations()
             ++it;
     }
     m_indexOk = false;
+    m_locationIndexOk = false;
+}
+
+void Translator::dropTranslation(TranslatorMessage &msg)
+{
+    if (msg.type() == TranslatorMessage::Finished)
+        msg.setType(TranslatorMessage::Unfinished);
+    msg.setTranslation(QString());
 }
 
 void Translator::dropTranslations()
 {
-    for (TMM::Iterator it = m_messages.begin(); it != m_messages.end(); ++it) {
-        if (it->type() == TranslatorMessage::Finished)
-            it->setType(TranslatorMessage::Unfinished);
-        it->setTranslation(QString());
-    }
+    for (TMM::Iterator it = m_messages.begin(); it != m_messages.end(); ++it)
+        dropTranslation(*it);
 }
 
-void Translator::dropUiLines()
+void Translator::dropUiLines(TranslatorMessage &msg)
 {
     QString uiXt = QLatin1String(".ui");
     QString juiXt = QLatin1String(".jui");
-    for (TMM::Iterator it = m_messages.begin(); it != m_messages.end(); ++it) {
-        QHash<QString, int> have;
-        QList<TranslatorMessage::Reference> refs;
-        foreach (const TranslatorMessage::Reference &itref, it->allReferences()) {
-            const QString &fn = itref.fileName();
-            if (fn.endsWith(uiXt) || fn.endsWith(juiXt)) {
-                if (++have[fn] == 1)
-                    refs.append(TranslatorMessage::Reference(fn, -1));
-            } else {
-                refs.append(itref);
-            }
+    QHash<QString, int> have;
+    QList<TranslatorMessage::Reference> refs;
+    foreach (const TranslatorMessage::Reference &itref, msg.allReferences()) {
+        const QString &fn = itref.fileName();
+        if (fn.endsWith(uiXt) || fn.endsWith(juiXt)) {
+            if (++have[fn] == 1)
+                refs.append(TranslatorMessage::Reference(fn, -1));
+        } else {
+            refs.append(itref);
         }
-        it->setReferences(refs);
     }
+    msg.setReferences(refs);
+}
+
+void Translator::dropUiLines()
+{
+    for (TMM::Iterator it = m_messages.begin(); it != m_messages.end(); ++it)
+        dropUiLines(*it);
+    m_locationIndexOk = false;
 }
 
 struct TranslatorMessageIdPtr {
@@ -613,6 +937,7 @@ Translator::Duplicates Translator::resolveDuplicates()
         if (!omsg->isTranslated() && msg.isTranslated())
             omsg->setTranslations(msg.translations());
         m_indexOk = false;
+        m_locationIndexOk = false;
         m_messages.removeAt(i);
     }
     return dups;
@@ -656,11 +981,12 @@ void Translator::makeFileNamesAbsolute(const QDir &originalPath)
             msg.addReference(fileName, ref.lineNumber());
         }
     }
+    m_locationIndexOk = false;
 }
 
 QList<TranslatorMessage> Translator::messages() const
 {
-    return m_messages;
+    return m_messages.toList();
 }
 
 QStringList Translator::normalizedTranslations(const TranslatorMessage &msg, int numPlurals)
@@ -680,37 +1006,55 @@ QStringList Translator::normalizedTranslations(const TranslatorMessage &msg, int
     return translations;
 }
 
-void Translator::normalizeTranslations(ConversionData &cd)
+int Translator::numerusFormCount(const QString &languageCode)
 {
-    bool truncated = false;
     QLocale::Language l;
     QLocale::Country c;
-    languageAndCountry(languageCode(), &l, &c);
+    languageAndCountry(languageCode, &l, &c);
     int numPlurals = 1;
     if (l != QLocale::C) {
         QStringList forms;
         if (getNumerusInfo(l, c, 0, &forms, 0))
             numPlurals = forms.count(); // includes singular
     }
-    for (int i = 0; i < m_messages.count(); ++i) {
-        const TranslatorMessage &msg = m_messages.at(i);
-        QStringList tlns = msg.translations();
-        int ccnt = msg.isPlural() ? numPlurals : 1;
-        if (tlns.count() != ccnt) {
-            while (tlns.count() < ccnt)
-                tlns.append(QString());
-            while (tlns.count() > ccnt) {
-                tlns.removeLast();
-                truncated = true;
-            }
-            m_messages[i].setTranslations(tlns);
+    return numPlurals;
+}
+
+bool Translator::normalizeTranslation(TranslatorMessage &msg, int numPlurals)
+{
+    bool truncated = false;
+    QStringList tlns = msg.translations();
+    int ccnt = msg.isPlural() ? numPlurals : 1;
+    if (tlns.count() != ccnt) {
+        while (tlns.count() < ccnt)
+            tlns.append(QString());
+        while (tlns.count() > ccnt) {
+            tlns.removeLast();
+            truncated = true;
         }
+        msg.setTranslations(tlns);
+    }
+    return truncated;
+}
+
+void Translator::reportTruncatedTranslations(ConversionData &cd)
+{
+    cd.appendError(QLatin1String(
+        "Removed plural forms as the target language has less "
+        "forms.\nIf this sounds wrong, possibly the target language is "
+        "not set or recognized."));
+}
+
+void Translator::normalizeTranslations(ConversionData &cd)
+{
+    bool truncated = false;
+    int numPlurals = numerusFormCount(languageCode());
+    for (int i = 0; i < m_messages.count(); ++i) {
+        if (normalizeTranslation(m_messages[i], numPlurals))
+            truncated = true;
     }
     if (truncated)
-        cd.appendError(QLatin1String(
-            "Removed plural forms as the target language has less "
-            "forms.\nIf this sounds wrong, possibly the target language is "
-            "not set or recognized."));
+        reportTruncatedTranslations(cd);
 }
 
 QString Translator::guessLanguageCodeFromFileName(const QString &filename)
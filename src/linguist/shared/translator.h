@@ -36,8 +36,10 @@
 #include <QList>
 #include <QLocale>
 #include <QMultiHash>
+#include <QPair>
 #include <QString>
 #include <QSet>
+#include <QVector>
 
 
 QT_BEGIN_NAMESPACE
@@ -46,6 +48,7 @@ class FMT {
     Q_DECLARE_TR_FUNCTIONS(Linguist)
 };
 
+class QFile;
 class QIODevice;
 
 // A struct of "interesting" data passed to and from the load and save routines
@@ -58,7 +61,8 @@ public:
         m_sortContexts(false),
         m_noUiLines(false),
         m_idBased(false),
-        m_saveMode(SaveEverything)
+        m_saveMode(SaveEverything),
+        m_threadCount(1)
     {}
 
     // tag manipulation
@@ -94,6 +98,8 @@ public:
     bool m_noUiLines;
     bool m_idBased;
     TranslatorSaveMode m_saveMode;
+    int m_threadCount; // lupdate specific: number of concurrent parser threads
+    QByteArray m_releaseStamp; // QM specific: identifies the inputs and options of a release
 };
 
 class TMMKey {
@@ -107,6 +113,29 @@ public:
 Q_DECLARE_TYPEINFO(TMMKey, Q_MOVABLE_TYPE);
 inline uint qHash(const TMMKey &key) { return qHash(key.context) ^ qHash(key.source) ^ qHash(key.comment); }
 
+class Translator;
+
+// Receives the messages of a file as they are loaded, instead of the Translator
+class TranslatorMessageSink
+{
+public:
+    virtual ~TranslatorMessageSink() {}
+    // The translator holds the header data (languages, extras, ...) read so far
+    virtual void put(const Translator &translator, const TranslatorMessage &msg) = 0;
+};
+
+// Writes a file one message at a time. Only formats which need not see all
+// messages before writing the first one provide a stream writer.
+class TranslatorStreamWriter
+{
+public:
+    virtual ~TranslatorStreamWriter() {}
+    // The messages of the translator are ignored
+    virtual void writeHeader(const Translator &translator) = 0;
+    virtual void writeMessage(const TranslatorMessage &msg) = 0;
+    virtual bool finish() = 0;
+};
+
 class Translator
 {
 public:
@@ -123,8 +152,14 @@ public:
 
     void replaceSorted(const TranslatorMessage &msg);
     void extend(const TranslatorMessage &msg, ConversionData &cd); // Only for single-location messages
+    void extend(const QList<const Translator *> &sources, ConversionData &cd); // Ditto
     void append(const TranslatorMessage &msg);
     void appendSorted(const TranslatorMessage &msg);
+    // In between, append() and appendSorted() only queue the messages next to
+    // their neighbors, and the end splices them in at once. Nothing else may be
+    // called on the Translator in between.
+    void beginSortedAppends();
+    void endSortedAppends();
 
     void stripObsoleteMessages();
     void stripFinishedMessages();
@@ -134,6 +169,8 @@ public:
     void stripIdenticalSourceTranslations();
     void dropTranslations();
     void dropUiLines();
+    static void dropTranslation(TranslatorMessage &msg);
+    static void dropUiLines(TranslatorMessage &msg);
     void makeFileNamesAbsolute(const QDir &originalPath);
     bool translationsExist();
 
@@ -155,10 +192,19 @@ public:
     void setSourceLanguageCode(const QString &languageCode) { m_sourceLanguage = languageCode; }
     static QString guessLanguageCodeFromFileName(const QString &fileName);
     QList<TranslatorMessage> messages() const;
+    // The stored messages without a conversion; prefer this for iterating.
+    const QVector<TranslatorMessage> &constMessages() const { return m_messages; }
     static QStringList normalizedTranslations(const TranslatorMessage &m, int numPlurals);
+    static int numerusFormCount(const QString &languageCode);
+    static bool normalizeTranslation(TranslatorMessage &msg, int numPlurals); // true if truncated
+    static void reportTruncatedTranslations(ConversionData &cd);
     void normalizeTranslations(ConversionData &cd);
     QStringList normalizedTranslations(const TranslatorMessage &m, ConversionData &cd, bool *ok) const;
 
+    // While a sink is set, appended messages are passed to it instead of being stored
+    void setMessageSink(TranslatorMessageSink *sink) { m_sink = sink; }
+    TranslatorMessageSink *messageSink() const { return m_sink; }
+
     int messageCount() const { return m_messages.size(); }
     TranslatorMessage &message(int i) { return m_messages[i]; }
     const TranslatorMessage &message(int i) const { return m_messages.at(i); }
@@ -181,19 +227,26 @@ public:
     // registration of file formats
     typedef bool (*SaveFunction)(const Translator &, QIODevice &out, ConversionData &data);
     typedef bool (*LoadFunction)(Translator &, QIODevice &in, ConversionData &data);
+    typedef TranslatorStreamWriter *(*StreamWriterFunction)(QIODevice &out, ConversionData &data);
     struct FileFormat {
-        FileFormat() : untranslatedDescription(nullptr), loader(0), saver(0), priority(-1) {}
+        FileFormat() : untranslatedDescription(nullptr), loader(0), saver(0), streamWriter(0),
+                       priority(-1) {}
         QString extension; // such as "ts", "xlf", ...
         const char *untranslatedDescription;
         // human-readable description
         QString description() const { return FMT::tr(untranslatedDescription); }
         LoadFunction loader;
         SaveFunction saver;
+        StreamWriterFunction streamWriter; // optional
         enum FileType { TranslationSource, TranslationBinary } fileType;
         int priority; // 0 = highest, -1 = invisible
     };
     static void registerFileFormat(const FileFormat &format);
     static QList<FileFormat> &registeredFileFormats();
+    static bool canStream(const QString &filename, const QString &format);
+    // Opens the file and returns a writer for it, or null with an error in cd
+    static TranslatorStreamWriter *createStreamWriter(QFile &file, const QString &filename,
+                                                      ConversionData &cd, const QString &format);
 
     enum {
         TextVariantSeparator = 0x2762, // some weird character nobody ever heard of :-D
@@ -202,13 +255,25 @@ public:
 
 private:
     void insert(int idx, const TranslatorMessage &msg);
+    int extendTarget(const TranslatorMessage &msg, ConversionData &cd);
     void addIndex(int idx, const TranslatorMessage &msg) const;
     void delIndex(int idx) const;
     void ensureIndexed() const;
+    int indexPosition(int slot) const { return slot < 0 ? -1 : m_indexPositions.at(slot); }
+    void ensureLocationIndexed();
+    const TranslatorMessage *runMessages(int runId) const;
+    QVector<TranslatorMessage> &runContents(int runId);
+    QString internedString(const QString &str);
+    void internStrings(TranslatorMessage &msg);
+    static bool openForWriting(QFile &file, const QString &filename, ConversionData &cd);
 
-    typedef QList<TranslatorMessage> TMM;       // int stores the sequence position.
+    typedef QVector<TranslatorMessage> TMM;       // int stores the sequence position.
 
     TMM m_messages;
+    TranslatorMessageSink *m_sink;
+    // Contexts, comments and file names repeat across many messages; the
+    // messages share one copy of each.
+    QSet<QString> m_stringPool;
     LocationsType m_locationsType;
 
     // A string beginning with a 2 or 3 letter language code (ISO 639-1
@@ -225,10 +290,28 @@ private:
     QStringList m_dependencies;
     ExtraData m_extra;
 
+    // The hashes map to slots in m_indexPositions, so inserting a message
+    // in the middle only needs to shift these numbers instead of rehashing.
     mutable bool m_indexOk;
     mutable QHash<QString, int> m_ctxCmtIdx;
     mutable QHash<QString, int> m_idMsgIdx;
     mutable QHash<TMMKey, int> m_msgIdx;
+    mutable QVector<int> m_indexPositions;
+
+    // Used by appendSorted(): the runs of adjacent messages sharing file name
+    // and context, in the order of m_messages, and per file name and context.
+    struct LocationRun {
+        int start;
+        int count;
+    };
+    typedef QPair<QString, QString> LocationKey;
+    bool m_locationIndexOk;
+    QVector<LocationRun> m_locationRuns;
+    QHash<LocationKey, QVector<int> > m_locationRunIdx;
+    // Between beginSortedAppends() and endSortedAppends(): the runs which were
+    // appended to, keyed by run. Their start in m_locationRuns is then stale.
+    bool m_deferAppends;
+    QHash<int, QVector<TranslatorMessage> > m_runContents;
 };
 
 bool getNumerusInfo(QLocale::Language language, QLocale::Country country,
@@ -237,6 +320,7 @@ bool getNumerusInfo(QLocale::Language language, QLocale::Country country,
 QString getNumerusInfoString();
 
 bool saveQM(const Translator &translator, QIODevice &dev, ConversionData &cd);
+QByteArray readQMReleaseStamp(QIODevice &dev);
 
 /*
   This is a quick hack. The proper way to handle this would be
@@ -132,6 +132,8 @@ void TranslatorMessage::setExtra(const QString &key, const QString &value)
 void TranslatorMessage::unsetExtra(const QString &key)
 {
     m_extra.remove(key);
+    if (m_extra.isEmpty())
+        m_extra = ExtraData();
 }
 
 void TranslatorMessage::dump() const
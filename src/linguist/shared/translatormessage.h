@@ -125,7 +125,8 @@ public:
     void setExtra(const QString &ba, const QString &var);
     bool hasExtra(const QString &ba) const;
     const ExtraData &extras() const { return m_extra; }
-    void setExtras(const ExtraData &extras) { m_extra = extras; }
+    // An empty ExtraData shares the static empty hash instead of keeping its own table.
+    void setExtras(const ExtraData &extras) { m_extra = extras.isEmpty() ? ExtraData() : extras; }
     void unsetExtra(const QString &key);
 
     void dump() const;
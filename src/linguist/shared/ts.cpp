@@ -512,11 +512,34 @@ static void writeVariants(QTextStream &t, const char *indent, const QString &inp
     }
 }
 
-bool saveTS(const Translator &translator, QIODevice &dev, ConversionData &cd)
+class TSWriter : public TranslatorStreamWriter
 {
-    bool result = true;
-    QTextStream t(&dev);
-    t.setCodec(QTextCodec::codecForName("UTF-8"));
+public:
+    TSWriter(QIODevice &dev, ConversionData &cd)
+        : m_stream(&dev), m_cd(cd), m_locationsType(Translator::AbsoluteLocations),
+          m_inContext(false)
+    {
+        m_stream.setCodec(QTextCodec::codecForName("UTF-8"));
+    }
+
+    void writeHeader(const Translator &translator) override;
+    void writeMessage(const TranslatorMessage &msg) override;
+    bool finish() override;
+
+private:
+    QTextStream m_stream;
+    ConversionData &m_cd;
+    QRegExp m_drops;
+    Translator::LocationsType m_locationsType;
+    QHash<QString, int> m_currentLine;
+    QString m_currentFile;
+    QString m_context;
+    bool m_inContext;
+};
+
+void TSWriter::writeHeader(const Translator &translator)
+{
+    QTextStream &t = m_stream;
     //qDebug() << translator.codecName();
 
     // The xml prolog allows processors to easily detect the correct encoding
@@ -540,13 +563,145 @@ bool saveTS(const Translator &translator, QIODevice &dev, ConversionData &cd)
         t << "</dependencies>\n";
     }
 
-    QRegExp drops(cd.dropTags().join(QLatin1Char('|')));
+    m_drops = QRegExp(m_cd.dropTags().join(QLatin1Char('|')));
+    m_locationsType = translator.locationsType();
+
+    writeExtras(t, "    ", translator.extras(), m_drops);
+}
+
+// Consecutive messages of the same context share one <context> element.
+void TSWriter::writeMessage(const TranslatorMessage &msg)
+{
+    // no need for such noise
+    if ((msg.type() == TranslatorMessage::Obsolete || msg.type() == TranslatorMessage::Vanished)
+        && msg.translation().isEmpty()) {
+        return;
+    }
+
+    QTextStream &t = m_stream;
+    if (!m_inContext || msg.context() != m_context) {
+        if (m_inContext)
+            t << "</context>\n";
+        m_context = msg.context();
+        m_inContext = true;
+        t << "<context>\n"
+             "    <name>"
+          << protect(m_context)
+          << "</name>\n";
+    }
+
+    t << "    <message";
+    if (!msg.id().isEmpty())
+        t << " id=\"" << msg.id() << "\"";
+    if (msg.isPlural())
+        t << " numerus=\"yes\"";
+    t << ">\n";
+    if (m_locationsType != Translator::NoLocations) {
+        QString cfile = m_currentFile;
+        bool first = true;
+        foreach (const TranslatorMessage::Reference &ref, msg.allReferences()) {
+            QString fn = m_cd.m_targetDir.relativeFilePath(ref.fileName())
+                        .replace(QLatin1Char('\\'),QLatin1Char('/'));
+            int ln = ref.lineNumber();
+            QString ld;
+            if (m_locationsType == Translator::RelativeLocations) {
+                if (ln != -1) {
+                    int dlt = ln - m_currentLine[fn];
+                    if (dlt >= 0)
+                        ld.append(QLatin1Char('+'));
+                    ld.append(QString::number(dlt));
+                    m_currentLine[fn] = ln;
+                }
+
+                if (fn != cfile) {
+                    if (first)
+                        m_currentFile = fn;
+                    cfile = fn;
+                } else {
+                    fn.clear();
+                }
+                first = false;
+            } else {
+                if (ln != -1)
+                    ld = QString::number(ln);
+            }
+            t << "        <location";
+            if (!fn.isEmpty())
+                t << " filename=\"" << fn << "\"";
+            if (!ld.isEmpty())
+                t << " line=\"" << ld << "\"";
+            t << "/>\n";
+        }
+    }
+
+    t << "        <source>"
+      << protect(msg.sourceText())
+      << "</source>\n";
+
+    if (!msg.oldSourceText().isEmpty())
+        t << "        <oldsource>" << protect(msg.oldSourceText()) << "</oldsource>\n";
+
+    if (!msg.comment().isEmpty()) {
+        t << "        <comment>"
+          << protect(msg.comment())
+          << "</comment>\n";
+    }
+
+    if (!msg.oldComment().isEmpty())
+        t << "        <oldcomment>" << protect(msg.oldComment()) << "</oldcomment>\n";
+
+    if (!msg.extraComment().isEmpty())
+        t << "        <extracomment>" << protect(msg.extraComment())
+          << "</extracomment>\n";
+
+    if (!msg.translatorComment().isEmpty())
+        t << "        <translatorcomment>" << protect(msg.translatorComment())
+          << "</translatorcomment>\n";
+
+    t << "        <translation";
+    if (msg.type() == TranslatorMessage::Unfinished)
+        t << " type=\"unfinished\"";
+    else if (msg.type() == TranslatorMessage::Vanished)
+        t << " type=\"vanished\"";
+    else if (msg.type() == TranslatorMessage::Obsolete)
+        t << " type=\"obsolete\"";
+    if (msg.isPlural()) {
+        t << ">";
+        const QStringList &translns = msg.translations();
+        for (int j = 0; j < translns.count(); ++j) {
+            t << "\n            <numerusform";
+            writeVariants(t, "            ", translns[j]);
+            t << "</numerusform>";
+        }
+        t << "\n        ";
+    } else {
+        writeVariants(t, "        ", msg.translation());
+    }
+    t << "</translation>\n";
+
+    writeExtras(t, "        ", msg.extras(), m_drops);
+
+    if (!msg.userData().isEmpty())
+        t << "        <userdata>" << msg.userData() << "</userdata>\n";
+    t << "    </message>\n";
+}
 
-    writeExtras(t, "    ", translator.extras(), drops);
+bool TSWriter::finish()
+{
+    if (m_inContext)
+        m_stream << "</context>\n";
+    m_stream << "</TS>\n";
+    return true;
+}
+
+bool saveTS(const Translator &translator, QIODevice &dev, ConversionData &cd)
+{
+    TSWriter writer(dev, cd);
+    writer.writeHeader(translator);
 
     QHash<QString, QList<TranslatorMessage> > messageOrder;
     QList<QString> contextOrder;
-    foreach (const TranslatorMessage &msg, translator.messages()) {
+    foreach (const TranslatorMessage &msg, translator.constMessages()) {
         // no need for such noise
         if ((msg.type() == TranslatorMessage::Obsolete || msg.type() == TranslatorMessage::Vanished)
             && msg.translation().isEmpty()) {
@@ -561,116 +716,17 @@ bool saveTS(const Translator &translator, QIODevice &dev, ConversionData &cd)
     if (cd.sortContexts())
         std::sort(contextOrder.begin(), contextOrder.end());
 
-    QHash<QString, int> currentLine;
-    QString currentFile;
     foreach (const QString &context, contextOrder) {
-        t << "<context>\n"
-             "    <name>"
-          << protect(context)
-          << "</name>\n";
-        foreach (const TranslatorMessage &msg, messageOrder[context]) {
-            //msg.dump();
-
-                t << "    <message";
-                if (!msg.id().isEmpty())
-                    t << " id=\"" << msg.id() << "\"";
-                if (msg.isPlural())
-                    t << " numerus=\"yes\"";
-                t << ">\n";
-                if (translator.locationsType() != Translator::NoLocations) {
-                    QString cfile = currentFile;
-                    bool first = true;
-                    foreach (const TranslatorMessage::Reference &ref, msg.allReferences()) {
-                        QString fn = cd.m_targetDir.relativeFilePath(ref.fileName())
-                                    .replace(QLatin1Char('\\'),QLatin1Char('/'));
-                        int ln = ref.lineNumber();
-                        QString ld;
-                        if (translator.locationsType() == Translator::RelativeLocations) {
-                            if (ln != -1) {
-                                int dlt = ln - currentLine[fn];
-                                if (dlt >= 0)
-                                    ld.append(QLatin1Char('+'));
-                                ld.append(QString::number(dlt));
-                                currentLine[fn] = ln;
-                            }
-
-                            if (fn != cfile) {
-                                if (first)
-                                    currentFile = fn;
-                                cfile = fn;
-                            } else {
-                                fn.clear();
-                            }
-                            first = false;
-                        } else {
-                            if (ln != -1)
-                                ld = QString::number(ln);
-                        }
-                        t << "        <location";
-                        if (!fn.isEmpty())
-                            t << " filename=\"" << fn << "\"";
-                        if (!ld.isEmpty())
-                            t << " line=\"" << ld << "\"";
-                        t << "/>\n";
-                    }
-                }
-
-                t << "        <source>"
-                  << protect(msg.sourceText())
-                  << "</source>\n";
-
-                if (!msg.oldSourceText().isEmpty())
-                    t << "        <oldsource>" << protect(msg.oldSourceText()) << "</oldsource>\n";
-
-                if (!msg.comment().isEmpty()) {
-                    t << "        <comment>"
-                      << protect(msg.comment())
-                      << "</comment>\n";
-                }
-
-                    if (!msg.oldComment().isEmpty())
-                        t << "        <oldcomment>" << protect(msg.oldComment()) << "</oldcomment>\n";
-
-                    if (!msg.extraComment().isEmpty())
-                        t << "        <extracomment>" << protect(msg.extraComment())
-                          << "</extracomment>\n";
-
-                    if (!msg.translatorComment().isEmpty())
-                        t << "        <translatorcomment>" << protect(msg.translatorComment())
-                          << "</translatorcomment>\n";
-
-                t << "        <translation";
-                if (msg.type() == TranslatorMessage::Unfinished)
-                    t << " type=\"unfinished\"";
-                else if (msg.type() == TranslatorMessage::Vanished)
-                    t << " type=\"vanished\"";
-                else if (msg.type() == TranslatorMessage::Obsolete)
-                    t << " type=\"obsolete\"";
-                if (msg.isPlural()) {
-                    t << ">";
-                    const QStringList &translns = msg.translations();
-                    for (int j = 0; j < translns.count(); ++j) {
-                        t << "\n            <numerusform";
-                        writeVariants(t, "            ", translns[j]);
-                        t << "</numerusform>";
-                    }
-                    t << "\n        ";
-                } else {
-                    writeVariants(t, "        ", msg.translation());
-                }
-                t << "</translation>\n";
-
-                writeExtras(t, "        ", msg.extras(), drops);
-
-                if (!msg.userData().isEmpty())
-                    t << "        <userdata>" << msg.userData() << "</userdata>\n";
-                t << "    </message>\n";
-        }
-        t << "</context>\n";
+        foreach (const TranslatorMessage &msg, messageOrder[context])
+            writer.writeMessage(msg);
     }
 
-    t << "</TS>\n";
-    return result;
+    return writer.finish();
+}
+
+static TranslatorStreamWriter *createTSWriter(QIODevice &dev, ConversionData &cd)
+{
+    return new TSWriter(dev, cd);
 }
 
 bool loadTS(Translator &translator, QIODevice &dev, ConversionData &cd)
@@ -689,6 +745,7 @@ int initTS()
     format.untranslatedDescription = QT_TRANSLATE_NOOP("FMT", "Qt translation sources");
     format.loader = &loadTS;
     format.saver = &saveTS;
+    format.streamWriter = &createTSWriter;
     Translator::registerFileFormat(format);
 
     return 1;
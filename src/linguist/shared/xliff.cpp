@@ -766,7 +766,7 @@ bool saveXLIFF(const Translator &translator, QIODevice &dev, ConversionData &cd)
     QHash<QString, QHash<QString, QList<TranslatorMessage> > > messageOrder;
     QHash<QString, QList<QString> > contextOrder;
     QList<QString> fileOrder;
-    foreach (const TranslatorMessage &msg, translator.messages()) {
+    foreach (const TranslatorMessage &msg, translator.constMessages()) {
         QString fn = msg.fileName();
         if (fn.isEmpty() && msg.type() == TranslatorMessage::Obsolete)
             fn = QLatin1String(MAGIC_OBSOLETE_REFERENCE);
@@ -28,6 +28,7 @@
 
 #include <QtTest/QtTest>
 #include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
 
 class tst_lconvert : public QObject
 {
@@ -48,12 +49,15 @@ private slots:
     void roundtrips();
     void chains_data();
     void chains();
+    void streams_data();
+    void streams();
     void merge();
 
 private:
     void doWait(QProcess *cvt, int stage);
     void doCompare(QIODevice *actual, const QString &expectedFn);
     void verifyReadFail(const QString &fn);
+    void convertFile(const QStringList &args, int stage);
     // args can be empty or have one element less than stations
     void convertChain(const QString &inFileName, const QString &outFileName,
             const QStringList &stations, const QList<QStringList> &args);
@@ -259,6 +263,9 @@ void tst_lconvert::chains_data()
     QTest::newRow("no-untranslated") << "untranslated.ts" << "untranslated.ts.out"
                                      << QStringList({"ts", "ts"})
                                      << QList<QStringList>({QStringList("-no-untranslated")});
+    QTest::newRow("no-untranslated (stream)") << "untranslated.ts" << "untranslated.ts.out"
+                                              << QStringList({"ts", "ts"})
+                                              << QList<QStringList>({QStringList({"-stream", "-no-untranslated"})});
 }
 
 void tst_lconvert::chains()
@@ -271,6 +278,74 @@ void tst_lconvert::chains()
     convertChain(inFileName, outFileName, stations, args);
 }
 
+void tst_lconvert::convertFile(const QStringList &args, int stage)
+{
+    QProcess cvt;
+    cvt.start(lconvert, args);
+    QVERIFY2(cvt.waitForStarted(), qPrintable(cvt.errorString()));
+    doWait(&cvt, stage);
+}
+
+void tst_lconvert::streams_data()
+{
+    QTest::addColumn<QString>("inFileName");
+    QTest::addColumn<QString>("outFormat");
+
+    QTest::newRow("po-ts (de)") << "test1-de.po" << "ts";
+    QTest::newRow("po-ts (cn)") << "test1-cn.po" << "ts";
+    QTest::newRow("po-ts (singular)") << "singular.po" << "ts";
+    QTest::newRow("po-ts (plural-3)") << "plural-3.po" << "ts";
+    QTest::newRow("po-ts (kde plurals)") << "test-kde-plurals.po" << "ts";
+    QTest::newRow("po-ts (references)") << "test-refs.po" << "ts";
+    QTest::newRow("po-ts (translator comment)") << "test-translator-comment.po" << "ts";
+    QTest::newRow("po-ts (line joins)") << "test-slurp.po" << "ts";
+    QTest::newRow("po-po (de)") << "test1-de.po" << "po";
+    QTest::newRow("po-po (escapes)") << "test-escapes.po" << "po";
+    QTest::newRow("po-po (broken utf8)") << "test-broken-utf8.po" << "po";
+    QTest::newRow("po-po (linewrapping)") << "wrapping.po" << "po";
+    QTest::newRow("po-po (developer comment)") << "test-developer-comment.po" << "po";
+    QTest::newRow("ts-po (ts20)") << "test20.ts" << "po";
+    QTest::newRow("ts-po (plurals-de)") << "plurals-de.ts" << "po";
+    QTest::newRow("ts-po (msgid)") << "msgid.ts" << "po";
+    QTest::newRow("ts-ts (variants)") << "variants.ts" << "ts";
+}
+
+// Streaming must produce what loading the file entirely produces.
+void tst_lconvert::streams()
+{
+    QFETCH(QString, inFileName);
+    QFETCH(QString, outFormat);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QString loaded = dir.filePath("loaded." + outFormat);
+    QString streamed = dir.filePath("streamed." + outFormat);
+    convertFile(QStringList() << "-i" << (dataDir + inFileName) << "-of" << outFormat
+                              << "-o" << loaded, 1);
+    convertFile(QStringList() << "-stream" << "-i" << (dataDir + inFileName)
+                              << "-of" << outFormat << "-o" << streamed, 2);
+    if (QTest::currentTestFailed())
+        return;
+
+    // The PO stream writer declares qt contexts up front, as it cannot know yet
+    // whether any message has one, so its output may differ in escaping. Compare
+    // what both files load as instead.
+    if (outFormat == "po") {
+        convertFile(QStringList() << "-if" << "po" << "-i" << loaded << "-of" << "ts"
+                                  << "-o" << loaded + ".ts", 3);
+        convertFile(QStringList() << "-if" << "po" << "-i" << streamed << "-of" << "ts"
+                                  << "-o" << streamed + ".ts", 4);
+        if (QTest::currentTestFailed())
+            return;
+        loaded += ".ts";
+        streamed += ".ts";
+    }
+
+    QFile actual(streamed);
+    QVERIFY(actual.open(QIODevice::ReadOnly | QIODevice::Text));
+    doCompare(&actual, loaded);
+}
+
 void tst_lconvert::roundtrips_data()
 {
     QTest::addColumn<QString>("fileName");
@@ -287,6 +362,14 @@ void tst_lconvert::roundtrips_data()
     QList<QStringList> filterPoArgs; filterPoArgs << QStringList() << (QStringList() << "-drop-tag" << "po:*");
     QList<QStringList> outDeArgs; outDeArgs << QStringList() << (QStringList() << "-target-language" << "de");
     QList<QStringList> outCnArgs; outCnArgs << QStringList() << (QStringList() << "-target-language" << "cn");
+    QList<QStringList> streamArgs; streamArgs << QStringList("-stream") << QStringList("-stream");
+    QList<QStringList> streamFilterPoArgs; streamFilterPoArgs << QStringList("-stream")
+            << (QStringList() << "-stream" << "-drop-tag" << "po:*");
+    // Only the first hop streams, so the final output is not affected by
+    // the PO stream writer always declaring qt contexts.
+    QList<QStringList> streamFirstArgs; streamFirstArgs << QStringList("-stream") << QStringList();
+    QList<QStringList> streamFirstFilterPoArgs; streamFirstFilterPoArgs << QStringList("-stream")
+            << (QStringList() << "-drop-tag" << "po:*");
 
     QTest::newRow("po-ts-po (translator comment)") << "test-translator-comment.po" << poTsPo << noArgs;
     QTest::newRow("po-xliff-po (translator comment)") << "test-translator-comment.po" << poXlfPo << noArgs;
@@ -318,6 +401,17 @@ void tst_lconvert::roundtrips_data()
 
     QTest::newRow("ts-po-ts (endless loop)") << "endless-po-loop.ts" << tsPoTs << noArgs;
     QTest::newRow("ts-qm-ts (whitespace)") << "whitespace.ts" << tsQmTs << noArgs;
+
+    QTest::newRow("ts20-po-ts20 (stream)") << "test20.ts" << tsPoTs << streamFilterPoArgs;
+    QTest::newRow("ts-po-ts (msgid, stream)") << "msgid.ts" << tsPoTs << streamArgs;
+    QTest::newRow("ts20-po-ts20 (stream to po)") << "test20.ts" << tsPoTs << streamFirstFilterPoArgs;
+    QTest::newRow("ts-po-ts (msgid, stream to po)") << "msgid.ts" << tsPoTs << streamFirstArgs;
+    QTest::newRow("po-ts-po (de, stream)") << "test1-de.po" << poTsPo << streamFirstArgs;
+    QTest::newRow("po-ts-po (cn, stream)") << "test1-cn.po" << poTsPo << streamFirstArgs;
+    QTest::newRow("po-ts-po (plural-2, stream)") << "plural-2.po" << poTsPo << streamFirstArgs;
+    QTest::newRow("po-ts-po (references, stream)") << "test-refs.po" << poTsPo << streamFirstArgs;
+    QTest::newRow("po-ts-po (translator comment, stream)") << "test-translator-comment.po"
+                                                           << poTsPo << streamFirstArgs;
 }
 
 void tst_lconvert::roundtrips()
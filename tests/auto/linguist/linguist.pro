@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS = lrelease lconvert lupdate
+SUBDIRS = lrelease lconvert lupdate qmview
@@ -52,6 +52,8 @@ private slots:
     void markuntranslated();
     void dupes();
     void noTranslations();
+    void threads();
+    void incremental();
 
 private:
     void doCompare(const QStringList &actual, const QString &expectedFn);
@@ -219,5 +221,45 @@ void tst_lrelease::noTranslations()
     QVERIFY(stderrOutput.contains("lrelease warning: Met no 'TRANSLATIONS' entry in project file"));
 }
 
+void tst_lrelease::threads()
+{
+    QVERIFY(!QProcess::execute(lrelease, QStringList() << "-threads" << "2"
+                               << (dataDir + "translate.ts") << (dataDir + "compressed.ts")));
+
+    QTranslator translator;
+    QVERIFY(translator.load(dataDir + "translate.qm"));
+    QCOMPARE(translator.translate("CubeForm", "Test"), QString::fromLatin1("BBBB"));
+    QVERIFY(translator.load(dataDir + "compressed.qm"));
+    QCOMPARE(translator.translate("Context1", "Foo"), QString::fromLatin1("in first context"));
+}
+
+void tst_lrelease::incremental()
+{
+    const QString tsFile = dataDir + "translate.ts";
+    const QString qmFile = dataDir + "translate.qm";
+    QFile::remove(qmFile);
+
+    QProcess proc;
+    proc.start(lrelease, QStringList() << "-incremental" << tsFile);
+    QVERIFY(proc.waitForFinished());
+    QCOMPARE(proc.exitCode(), 0);
+    QVERIFY(!proc.readAllStandardOutput().contains("is up to date"));
+
+    proc.start(lrelease, QStringList() << "-incremental" << tsFile);
+    QVERIFY(proc.waitForFinished());
+    QCOMPARE(proc.exitCode(), 0);
+    QVERIFY(proc.readAllStandardOutput().contains("is up to date"));
+
+    // Other options produce a different QM file
+    proc.start(lrelease, QStringList() << "-incremental" << "-compress" << tsFile);
+    QVERIFY(proc.waitForFinished());
+    QCOMPARE(proc.exitCode(), 0);
+    QVERIFY(!proc.readAllStandardOutput().contains("is up to date"));
+
+    QTranslator translator;
+    QVERIFY(translator.load(qmFile));
+    QCOMPARE(translator.translate("CubeForm", "Test"), QString::fromLatin1("BBBB"));
+}
+
 QTEST_MAIN(tst_lrelease)
 #include "tst_lrelease.moc"
@@ -0,0 +1,11 @@
+# Excluding a directory drops everything below it, but neither the
+# files next to it nor the directories sharing its name as a prefix.
+SOURCES += main.cpp \
+    generated.cpp \
+    generated/one.cpp \
+    generated/sub/two.cpp \
+    generated2/three.cpp
+
+TR_EXCLUDE = generated/*
+
+TRANSLATIONS = project.ts
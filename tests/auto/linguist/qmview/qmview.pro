@@ -0,0 +1,8 @@
+CONFIG += testcase
+QT = core-private testlib
+
+TARGET = tst_qmview
+
+SOURCES += tst_qmview.cpp
+
+include(../../../../src/linguist/shared/formats.pri)
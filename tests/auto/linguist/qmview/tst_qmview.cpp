@@ -0,0 +1,231 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include <qmview.h>
+#include <translator.h>
+
+#include <QtCore/QBuffer>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTranslator>
+
+#include <QtTest/QtTest>
+
+class tst_QmView : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void lookup_data();
+    void lookup();
+    void commentFallback();
+    void missing();
+    void unmapped();
+    void appendTo();
+    void strippedRandomAccess();
+
+private:
+    QString writeQm(TranslatorSaveMode mode);
+
+    QTemporaryDir m_dir;
+    Translator m_source;
+};
+
+void tst_QmView::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_source.setLanguageCode("de");
+    m_source.append(TranslatorMessage("Ctx", "Hello", QString(), QString(), "main.cpp", 1,
+                                      QStringList("Hallo"), TranslatorMessage::Finished));
+    m_source.append(TranslatorMessage("Ctx", "World", QString(), QString(), "main.cpp", 2,
+                                      QStringList("Welt"), TranslatorMessage::Finished));
+    m_source.append(TranslatorMessage("Ctx", "Open", "menu", QString(), "main.cpp", 3,
+                                      QStringList("Öffnen"), TranslatorMessage::Finished));
+    m_source.append(TranslatorMessage("Ctx", "Open", "verb", QString(), "main.cpp", 4,
+                                      QStringList("Aufmachen"), TranslatorMessage::Finished));
+    m_source.append(TranslatorMessage("Other", "Hello", QString(), QString(), "other.cpp", 1,
+                                      QStringList("Servus"), TranslatorMessage::Finished));
+    m_source.append(TranslatorMessage("Other", "%n file(s)", QString(), QString(), "other.cpp", 2,
+                                      QStringList() << "%n Datei" << "%n Dateien",
+                                      TranslatorMessage::Finished, true));
+}
+
+QString tst_QmView::writeQm(TranslatorSaveMode mode)
+{
+    const QString fileName = m_dir.filePath(mode == SaveStripped ? "stripped.qm" : "full.qm");
+    ConversionData cd;
+    cd.m_saveMode = mode;
+    if (!m_source.save(fileName, cd, "qm"))
+        qWarning("%s", qPrintable(cd.error()));
+    return fileName;
+}
+
+void tst_QmView::lookup_data()
+{
+    QTest::addColumn<int>("saveMode");
+
+    QTest::newRow("everything") << int(SaveEverything);
+    QTest::newRow("stripped") << int(SaveStripped);
+}
+
+void tst_QmView::lookup()
+{
+    QFETCH(int, saveMode);
+
+    const QString fileName = writeQm(TranslatorSaveMode(saveMode));
+    ConversionData cd;
+    QmView view;
+    QVERIFY2(view.load(fileName, cd), qPrintable(cd.error()));
+    QCOMPARE(view.languageCode(), QString("de"));
+    QCOMPARE(view.messageCount(), m_source.messageCount());
+
+    QTranslator translator;
+    QVERIFY(translator.load(fileName));
+
+    for (int i = 0; i < m_source.messageCount(); ++i) {
+        const TranslatorMessage &msg = m_source.message(i);
+        const int index = view.find(msg.context(), msg.sourceText(), msg.comment());
+        QVERIFY2(index >= 0, qPrintable(msg.sourceText()));
+        bool utf8Fail = true;
+        const TranslatorMessage found = view.message(index, &utf8Fail);
+        QVERIFY(!utf8Fail);
+        QCOMPARE(found.translations(), msg.translations());
+        QCOMPARE(found.isPlural(), msg.isPlural());
+        if (!msg.isPlural()) {
+            QCOMPARE(found.translation(),
+                     translator.translate(qPrintable(msg.context()), qPrintable(msg.sourceText()),
+                                          msg.comment().isEmpty() ? 0 : qPrintable(msg.comment())));
+        }
+        if (saveMode == SaveEverything) {
+            QCOMPARE(found.context(), msg.context());
+            QCOMPARE(found.sourceText(), msg.sourceText());
+            QCOMPARE(found.comment(), msg.comment());
+        }
+    }
+}
+
+void tst_QmView::commentFallback()
+{
+    ConversionData cd;
+    QmView view;
+    QVERIFY(view.load(writeQm(SaveEverything), cd));
+
+    // Like QTranslator, an unknown comment falls back to the message without one.
+    const int index = view.find("Ctx", "Hello", "greeting");
+    QVERIFY(index >= 0);
+    QCOMPARE(view.message(index).translation(), QString("Hallo"));
+
+    QCOMPARE(view.message(view.find("Ctx", "Open", "verb")).translation(), QString("Aufmachen"));
+}
+
+void tst_QmView::missing()
+{
+    ConversionData cd;
+    QmView view;
+    QVERIFY(view.load(writeQm(SaveEverything), cd));
+
+    QCOMPARE(view.find("Ctx", "Goodbye"), -1);
+    QCOMPARE(view.find("Nowhere", "World"), -1);
+    QCOMPARE(view.find("Ctx", "Open"), -1);
+}
+
+void tst_QmView::unmapped()
+{
+    const QString fileName = writeQm(SaveEverything);
+    QFile file(fileName);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+    QBuffer buffer;
+    buffer.setData(file.readAll());
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+
+    ConversionData cd;
+    QmView view;
+    QVERIFY(view.load(buffer, cd));
+    QCOMPARE(view.messageCount(), m_source.messageCount());
+    QCOMPARE(view.message(view.find("Other", "Hello")).translation(), QString("Servus"));
+
+    // Reloading from a mapped file replaces the previous contents.
+    file.seek(0);
+    QVERIFY(view.load(file, cd));
+    QCOMPARE(view.messageCount(), m_source.messageCount());
+    QCOMPARE(view.message(view.find("Ctx", "World")).translation(), QString("Welt"));
+}
+
+void tst_QmView::appendTo()
+{
+    ConversionData cd;
+    QmView view;
+    QVERIFY(view.load(writeQm(SaveEverything), cd));
+    Translator fromView;
+    QVERIFY(view.appendTo(fromView, cd));
+
+    Translator loaded;
+    QVERIFY(loaded.load(writeQm(SaveEverything), cd, "qm"));
+    QCOMPARE(fromView.messageCount(), loaded.messageCount());
+    for (int i = 0; i < loaded.messageCount(); ++i) {
+        QCOMPARE(fromView.message(i).context(), loaded.message(i).context());
+        QCOMPARE(fromView.message(i).sourceText(), loaded.message(i).sourceText());
+        QCOMPARE(fromView.message(i).translations(), loaded.message(i).translations());
+        QCOMPARE(view.message(i).translations(), loaded.message(i).translations());
+    }
+}
+
+void tst_QmView::strippedRandomAccess()
+{
+    // Enough messages sharing a context to span several checkpoints.
+    Translator source;
+    source.setLanguageCode("de");
+    for (int i = 0; i < 300; ++i) {
+        const QString ctx = QString("Ctx%1").arg(i / 100);
+        const QString text = QString("Text %1").arg(i);
+        source.append(TranslatorMessage(ctx, text, QString(), QString(), "main.cpp", i + 1,
+                                        QStringList(text.toUpper()),
+                                        TranslatorMessage::Finished));
+    }
+    const QString fileName = m_dir.filePath("many.qm");
+    ConversionData cd;
+    cd.m_saveMode = SaveStripped;
+    QVERIFY2(source.save(fileName, cd, "qm"), qPrintable(cd.error()));
+
+    QmView view;
+    QVERIFY(view.load(fileName, cd));
+    Translator fromView;
+    QVERIFY(view.appendTo(fromView, cd));
+    QCOMPARE(view.messageCount(), 300);
+
+    // Single lookups see the same carried-over fields as a full decode, in any order.
+    for (int i = view.messageCount() - 1; i >= 0; --i) {
+        const TranslatorMessage msg = view.message(i);
+        QCOMPARE(msg.context(), fromView.message(i).context());
+        QCOMPARE(msg.sourceText(), fromView.message(i).sourceText());
+        QCOMPARE(msg.translations(), fromView.message(i).translations());
+    }
+}
+
+QTEST_APPLESS_MAIN(tst_QmView)
+#include "tst_qmview.moc"
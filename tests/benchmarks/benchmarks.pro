@@ -0,0 +1,6 @@
+TEMPLATE = subdirs
+SUBDIRS = \
+    linguist
+
+# The benchmarks generate their data and run it on the host
+cross_compile: SUBDIRS -= linguist
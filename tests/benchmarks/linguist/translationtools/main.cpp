@@ -0,0 +1,648 @@
+/****************************************************************************
+**
+** Copyright (C) 2020 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of the Qt Linguist of the Qt Toolkit.
+**
+** $QT_BEGIN_LICENSE:GPL-EXCEPT$
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+** $QT_END_LICENSE$
+**
+****************************************************************************/
+
+#include "lupdate.h"
+
+#include <simtexth.h>
+#include <translator.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QRandomGenerator>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QTextStream>
+
+#if defined(Q_OS_WIN)
+#  include <qt_windows.h>
+#  include <psapi.h>
+#elif defined(Q_OS_UNIX)
+#  include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+
+QT_USE_NAMESPACE
+
+struct Options
+{
+    Options()
+        : messages(10000), contexts(100), density(20), plurals(5), obsolete(10),
+          languages(QStringList() << QLatin1String("de") << QLatin1String("pl")
+                                  << QLatin1String("ja")),
+          iterations(3), threads(1), queries(100), seed(1)
+    {}
+
+    int messages;
+    int contexts;
+    int density; // tr() calls per 100 lines of source
+    int plurals; // percentage of messages with plural forms
+    int obsolete; // percentage of the old catalogue that is gone from the sources
+    QStringList languages;
+    int iterations;
+    int threads;
+    int queries;
+    quint32 seed;
+    QStringList only;
+    QString outFileName;
+    QString workDir;
+};
+
+static void printErr(const QString &out)
+{
+    std::cerr << qPrintable(out);
+}
+
+static void printUsage()
+{
+    std::cout << "Usage:\n"
+        "    tst_bench_translationtools [options]\n\n"
+        "Generates C++ sources and catalogues of the requested size and times\n"
+        "the lupdate, lrelease and lconvert code paths on them. The results are\n"
+        "written as JSON, including the peak resident set size of the process.\n"
+        "The memory benchmark reports what a loaded catalogue itself occupies.\n\n"
+        "Options:\n"
+        "    -messages <n>      Number of tr() calls to generate (default 10000).\n"
+        "    -contexts <n>      Number of classes to spread them over (default 100).\n"
+        "    -density <n>       tr() calls per 100 lines of source (default 20).\n"
+        "    -plurals <pct>     Percentage of plural messages (default 5).\n"
+        "    -obsolete <pct>    Percentage of the old catalogue that no longer\n"
+        "                       occurs in the sources (default 10).\n"
+        "    -languages <list>  Comma separated target languages (default de,pl,ja).\n"
+        "    -iterations <n>    Repetitions of each benchmark (default 3).\n"
+        "    -threads <n>       Parser threads for loadCPP (default 1).\n"
+        "    -queries <n>       Texts looked up by the similarity benchmark (default 100).\n"
+        "    -seed <n>          Seed for the generated texts (default 1).\n"
+        "    -only <list>       Comma separated benchmarks to run (default all):\n"
+        "                       loadCPP, merge, ts, qm, po, xliff, similarity,\n"
+        "                       memory.\n"
+        "    -work-dir <dir>    Directory for the generated files (default temporary).\n"
+        "    -o <file>          Write the JSON to <file> instead of standard output.\n"
+        "    -help              Display this information and exit.\n";
+}
+
+// The high water mark of the whole process, so it only ever grows
+static qint64 peakRssKiB()
+{
+#if defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return qint64(counters.PeakWorkingSetSize / 1024);
+    return -1;
+#elif defined(Q_OS_UNIX)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage))
+        return -1;
+#  if defined(Q_OS_DARWIN)
+    return qint64(usage.ru_maxrss / 1024); // bytes
+#  else
+    return qint64(usage.ru_maxrss); // kilobytes
+#  endif
+#else
+    return -1;
+#endif
+}
+
+static const char * const vocabulary[] = {
+    "open", "save", "close", "the", "file", "folder", "recent", "document", "print",
+    "preview", "settings", "cannot", "find", "replace", "all", "next", "previous",
+    "window", "help", "about", "selected", "item", "items", "copy", "paste", "delete",
+    "undo", "redo", "zoom", "page", "export", "import", "as", "new", "project", "name"
+};
+
+class Generator
+{
+public:
+    Generator(const Options &options) : m_options(options), m_random(options.seed) {}
+
+    QString text(int context, int message)
+    {
+        const int vocabularySize = int(sizeof(vocabulary) / sizeof(vocabulary[0]));
+        QString str;
+        for (int i = 2 + m_random.bounded(6); i > 0; --i) {
+            if (!str.isEmpty())
+                str += QLatin1Char(' ');
+            str += QLatin1String(vocabulary[m_random.bounded(vocabularySize)]);
+        }
+        // Keep the texts unique, but similar to each other
+        return str + QString::fromLatin1(" %1.%2").arg(context).arg(message);
+    }
+
+    bool isPlural() { return int(m_random.bounded(100)) < m_options.plurals; }
+
+    // Returns the total size of the sources
+    qint64 writeSources(const QString &dir, QStringList *files)
+    {
+        qint64 size = 0;
+        const int perContext = (m_options.messages + m_options.contexts - 1) / m_options.contexts;
+        const int filler = qMax(0, 100 / qMax(1, m_options.density) - 1);
+        int remaining = m_options.messages;
+        for (int c = 0; c < m_options.contexts && remaining > 0; ++c) {
+            const QString className = QString::fromLatin1("Context%1").arg(c);
+            QString src;
+            QTextStream ts(&src);
+            ts << "#include <QObject>\n\n"
+               << "class " << className << " : public QObject\n{\n    Q_OBJECT\npublic:\n"
+               << "    void run(int n);\n};\n\n"
+               << "void " << className << "::run(int n)\n{\n";
+            for (int m = 0; m < perContext && remaining > 0; ++m, --remaining) {
+                for (int f = 0; f < filler; ++f)
+                    ts << "    int x" << m << '_' << f << " = n + " << f << ";\n";
+                if (isPlural())
+                    ts << "    setObjectName(tr(\"%n " << text(c, m) << "\", 0, n));\n";
+                else
+                    ts << "    setObjectName(tr(\"" << text(c, m) << "\"));\n";
+            }
+            ts << "}\n";
+            ts.flush();
+
+            const QString fileName = dir + QLatin1Char('/') + className.toLower()
+                                     + QLatin1String(".cpp");
+            QFile file(fileName);
+            if (!file.open(QIODevice::WriteOnly)) {
+                printErr(QString::fromLatin1("Cannot create %1: %2\n")
+                         .arg(fileName, file.errorString()));
+                return -1;
+            }
+            const QByteArray data = src.toUtf8();
+            file.write(data);
+            size += data.size();
+            files->append(fileName);
+        }
+        return size;
+    }
+
+private:
+    const Options &m_options;
+    QRandomGenerator m_random;
+};
+
+class Benchmarks
+{
+public:
+    Benchmarks(const Options &options) : m_options(options) {}
+
+    bool isEnabled(const char *name) const
+    {
+        return m_options.only.isEmpty() || m_options.only.contains(QLatin1String(name));
+    }
+
+    // Runs the function the requested number of times and records the timings.
+    // The function returns false if it failed.
+    template <typename Function>
+    bool run(const char *name, qint64 items, qint64 bytes, Function function)
+    {
+        QVector<qint64> times;
+        for (int i = 0; i < m_options.iterations; ++i) {
+            QElapsedTimer timer;
+            timer.start();
+            if (!function())
+                return false;
+            times.append(timer.nsecsElapsed());
+        }
+        std::sort(times.begin(), times.end());
+        const double best = times.first() / 1e6;
+        const double median = times.at(times.size() / 2) / 1e6;
+
+        QJsonObject result;
+        result.insert(QLatin1String("name"), QLatin1String(name));
+        result.insert(QLatin1String("iterations"), m_options.iterations);
+        result.insert(QLatin1String("bestMs"), best);
+        result.insert(QLatin1String("medianMs"), median);
+        result.insert(QLatin1String("items"), items);
+        if (best > 0)
+            result.insert(QLatin1String("itemsPerSecond"), items * 1000 / best);
+        if (bytes >= 0) {
+            result.insert(QLatin1String("bytes"), bytes);
+            if (best > 0)
+                result.insert(QLatin1String("megabytesPerSecond"), bytes / 1e3 / best);
+        }
+        result.insert(QLatin1String("peakRssKiB"), peakRssKiB());
+        m_results.append(result);
+        return true;
+    }
+
+    QJsonArray results() const { return m_results; }
+
+private:
+    const Options &m_options;
+    QJsonArray m_results;
+};
+
+static qint64 totalSize(const QStringList &files)
+{
+    qint64 size = 0;
+    foreach (const QString &file, files)
+        size += QFileInfo(file).size();
+    return size;
+}
+
+// The catalogue of a previous release: translated, and with part of the
+// messages changed so they become obsolete or are found by the heuristics
+static Translator oldCatalogue(const Translator &extracted, const Options &options)
+{
+    Translator tor;
+    tor.setLanguageCode(options.languages.value(0, QLatin1String("de")));
+    QRandomGenerator random(options.seed + 1);
+    foreach (TranslatorMessage msg, extracted.constMessages()) {
+        if (int(random.bounded(100)) < options.obsolete)
+            msg.setSourceText(msg.sourceText() + QLatin1String(" (old)"));
+        msg.setTranslation(QLatin1String("[") + msg.sourceText() + QLatin1Char(']'));
+        msg.setType(TranslatorMessage::Finished);
+        tor.append(msg);
+    }
+    return tor;
+}
+
+static Translator translatedCatalogue(const Translator &merged, const QString &language)
+{
+    Translator tor;
+    tor.setLanguageCode(language);
+    tor.setSourceLanguageCode(QLatin1String("en"));
+    const int forms = Translator::numerusFormCount(language);
+    foreach (TranslatorMessage msg, merged.constMessages()) {
+        if (msg.type() == TranslatorMessage::Obsolete || msg.type() == TranslatorMessage::Vanished)
+            continue;
+        const QString translation = language + QLatin1String(": ") + msg.sourceText();
+        QStringList translations;
+        for (int i = msg.isPlural() ? forms : 1; i > 0; --i)
+            translations << translation;
+        msg.setTranslations(translations);
+        msg.setType(TranslatorMessage::Finished);
+        tor.append(msg);
+    }
+    return tor;
+}
+
+static bool roundTrip(Benchmarks &bench, const char *saveName, const char *loadName,
+                      const QString &format, const QString &dir,
+                      const QList<Translator> &catalogues, const Options &options)
+{
+    QStringList files;
+    qint64 messages = 0;
+    for (int i = 0; i < catalogues.size(); ++i) {
+        files << dir + QLatin1String("/bench_") + options.languages.at(i)
+                 + QLatin1Char('.') + format;
+        messages += catalogues.at(i).messageCount();
+    }
+
+    const bool saved = bench.run(saveName, messages, -1, [&]() {
+        for (int i = 0; i < catalogues.size(); ++i) {
+            ConversionData cd;
+            if (!catalogues.at(i).save(files.at(i), cd, format)) {
+                printErr(cd.error());
+                return false;
+            }
+        }
+        return true;
+    });
+    if (!saved)
+        return false;
+
+    return bench.run(loadName, messages, totalSize(files), [&]() {
+        for (int i = 0; i < catalogues.size(); ++i) {
+            Translator tor;
+            ConversionData cd;
+            if (!tor.load(files.at(i), cd, format)) {
+                printErr(cd.error());
+                return false;
+            }
+        }
+        return true;
+    });
+}
+
+static const char * const benchmarkNames[] = {
+    "loadCPP", "merge", "ts", "qm", "po", "xliff", "similarity", "memory"
+};
+
+// Adds up the heap memory of the strings of a catalogue, counting every
+// shared string buffer only once, plus the storage of the messages themselves.
+class CatalogueMemory
+{
+public:
+    CatalogueMemory() : m_bytes(0) {}
+
+    void addMessage(const TranslatorMessage &msg)
+    {
+        addString(msg.id());
+        addString(msg.context());
+        addString(msg.sourceText());
+        addString(msg.oldSourceText());
+        addString(msg.comment());
+        addString(msg.oldComment());
+        addString(msg.fileName());
+        addString(msg.userData());
+        addString(msg.extraComment());
+        addString(msg.translatorComment());
+        const QStringList translations = msg.translations();
+        m_bytes += qint64(translations.size()) * sizeof(void *);
+        foreach (const QString &translation, translations)
+            addString(translation);
+        foreach (const TranslatorMessage::Reference &ref, msg.extraReferences()) {
+            m_bytes += sizeof(void *) + sizeof(TranslatorMessage::Reference);
+            addString(ref.fileName());
+        }
+    }
+
+    void addBytes(qint64 bytes) { m_bytes += bytes; }
+    qint64 bytes() const { return m_bytes; }
+
+private:
+    void addString(QString str)
+    {
+        const QStringData *d = str.data_ptr();
+        if (d->ref.isStatic() || m_seen.contains(d))
+            return;
+        m_seen.insert(d);
+        m_bytes += sizeof(QStringData) + qint64(d->alloc) * sizeof(QChar);
+    }
+
+    QSet<const void *> m_seen;
+    qint64 m_bytes;
+};
+
+static QString detached(const QString &str)
+{
+    return str.isEmpty() ? str : QString(str.constData(), str.size());
+}
+
+// What the catalogue took before strings were shared and messages stored
+// contiguously: every message owns its strings and lives in a list node.
+static qint64 unsharedCatalogueBytes(const Translator &tor)
+{
+    QList<TranslatorMessage> messages;
+    foreach (const TranslatorMessage &msg, tor.constMessages()) {
+        TranslatorMessage copy = msg;
+        copy.setId(detached(msg.id()));
+        copy.setContext(detached(msg.context()));
+        copy.setSourceText(detached(msg.sourceText()));
+        copy.setOldSourceText(detached(msg.oldSourceText()));
+        copy.setComment(detached(msg.comment()));
+        copy.setOldComment(detached(msg.oldComment()));
+        copy.setFileName(detached(msg.fileName()));
+        copy.setUserData(detached(msg.userData()));
+        copy.setExtraComment(detached(msg.extraComment()));
+        copy.setTranslatorComment(detached(msg.translatorComment()));
+        QStringList translations;
+        foreach (const QString &translation, msg.translations())
+            translations << detached(translation);
+        copy.setTranslations(translations);
+        TranslatorMessage::References refs;
+        foreach (const TranslatorMessage::Reference &ref, msg.extraReferences())
+            refs << TranslatorMessage::Reference(detached(ref.fileName()), ref.lineNumber());
+        copy.setReferences(TranslatorMessage::References()
+                           << TranslatorMessage::Reference(copy.fileName(), copy.lineNumber())
+                           << refs);
+        messages << copy;
+    }
+    CatalogueMemory memory;
+    foreach (const TranslatorMessage &msg, messages)
+        memory.addMessage(msg);
+    memory.addBytes(qint64(messages.size()) * (sizeof(void *) + sizeof(TranslatorMessage)));
+    return memory.bytes();
+}
+
+// Loads a TS file and reports what the catalogue itself occupies, as opposed
+// to the high water mark of the process.
+static bool measureMemory(const Translator &catalogue, const QString &dir, QJsonObject *result)
+{
+    const QString fileName = dir + QLatin1String("/bench_memory.ts");
+    ConversionData cd;
+    if (!catalogue.save(fileName, cd, QLatin1String("ts"))) {
+        printErr(cd.error());
+        return false;
+    }
+    Translator tor;
+    if (!tor.load(fileName, cd, QLatin1String("ts"))) {
+        printErr(cd.error());
+        return false;
+    }
+
+    CatalogueMemory memory;
+    foreach (const TranslatorMessage &msg, tor.constMessages())
+        memory.addMessage(msg);
+    memory.addBytes(qint64(tor.constMessages().capacity()) * sizeof(TranslatorMessage));
+
+    result->insert(QLatin1String("messages"), tor.messageCount());
+    result->insert(QLatin1String("catalogueBytes"), memory.bytes());
+    result->insert(QLatin1String("unsharedCatalogueBytes"), unsharedCatalogueBytes(tor));
+    return true;
+}
+
+static bool parseOptions(const QStringList &args, Options *options)
+{
+    for (int i = 1; i < args.size(); ++i) {
+        const QString &arg = args.at(i);
+        if (arg == QLatin1String("-help") || arg == QLatin1String("-h")) {
+            printUsage();
+            exit(0);
+        }
+        if (i + 1 >= args.size()) {
+            printErr(QString::fromLatin1("Unknown option or missing argument: %1\n").arg(arg));
+            return false;
+        }
+        const QString value = args.at(++i);
+        bool ok = true;
+        if (arg == QLatin1String("-messages"))
+            options->messages = value.toInt(&ok);
+        else if (arg == QLatin1String("-contexts"))
+            options->contexts = value.toInt(&ok);
+        else if (arg == QLatin1String("-density"))
+            options->density = value.toInt(&ok);
+        else if (arg == QLatin1String("-plurals"))
+            options->plurals = value.toInt(&ok);
+        else if (arg == QLatin1String("-obsolete"))
+            options->obsolete = value.toInt(&ok);
+        else if (arg == QLatin1String("-languages"))
+            options->languages = value.split(QLatin1Char(','), Qt::SkipEmptyParts);
+        else if (arg == QLatin1String("-iterations"))
+            options->iterations = value.toInt(&ok);
+        else if (arg == QLatin1String("-threads"))
+            options->threads = value.toInt(&ok);
+        else if (arg == QLatin1String("-queries"))
+            options->queries = value.toInt(&ok);
+        else if (arg == QLatin1String("-seed"))
+            options->seed = value.toUInt(&ok);
+        else if (arg == QLatin1String("-only"))
+            options->only = value.split(QLatin1Char(','), Qt::SkipEmptyParts);
+        else if (arg == QLatin1String("-work-dir"))
+            options->workDir = value;
+        else if (arg == QLatin1String("-o"))
+            options->outFileName = value;
+        else
+            ok = false;
+        if (!ok) {
+            printErr(QString::fromLatin1("Invalid option or value: %1 %2\n").arg(arg, value));
+            return false;
+        }
+    }
+    if (options->messages < 1 || options->contexts < 1 || options->iterations < 1
+        || options->threads < 1 || options->languages.isEmpty()) {
+        printErr(QString::fromLatin1("Sizes must be positive and a language must be given.\n"));
+        return false;
+    }
+    foreach (const QString &name, options->only) {
+        if (std::find_if(std::begin(benchmarkNames), std::end(benchmarkNames),
+                         [&name](const char *known) { return name == QLatin1String(known); })
+            == std::end(benchmarkNames)) {
+            printErr(QString::fromLatin1("Unknown benchmark: %1\n").arg(name));
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    Options options;
+    if (!parseOptions(app.arguments(), &options))
+        return 1;
+
+    QTemporaryDir tempDir;
+    const QString dir = options.workDir.isEmpty() ? tempDir.path() : options.workDir;
+    if (!QDir().mkpath(dir)) {
+        printErr(QString::fromLatin1("Cannot create %1\n").arg(dir));
+        return 1;
+    }
+
+    Generator generator(options);
+    QStringList sources;
+    const qint64 sourceSize = generator.writeSources(dir, &sources);
+    if (sourceSize < 0)
+        return 1;
+
+    Benchmarks bench(options);
+
+    Translator extracted;
+    {
+        ConversionData cd;
+        cd.m_threadCount = options.threads;
+        loadCPP(extracted, sources, cd);
+        if (!cd.error().isEmpty())
+            printErr(cd.error());
+    }
+    if (bench.isEnabled("loadCPP")) {
+        bench.run("loadCPP", extracted.messageCount(), sourceSize, [&]() {
+            Translator tor;
+            ConversionData cd;
+            cd.m_threadCount = options.threads;
+            loadCPP(tor, sources, cd);
+            return true;
+        });
+    }
+
+    const Translator old = oldCatalogue(extracted, options);
+    const UpdateOptions updateOptions =
+            HeuristicSameText | HeuristicSimilarText | HeuristicNumber;
+    QString err;
+    const Translator merged = merge(old, extracted, QList<Translator>(), updateOptions, err);
+    if (bench.isEnabled("merge")) {
+        bench.run("merge", old.messageCount() + extracted.messageCount(), -1, [&]() {
+            QString err;
+            merge(old, extracted, QList<Translator>(), updateOptions, err);
+            return true;
+        });
+    }
+
+    QList<Translator> catalogues;
+    foreach (const QString &language, options.languages)
+        catalogues << translatedCatalogue(merged, language);
+
+    bool ok = true;
+    if (ok && bench.isEnabled("ts"))
+        ok = roundTrip(bench, "saveTS", "loadTS", QLatin1String("ts"), dir, catalogues, options);
+    if (ok && bench.isEnabled("qm"))
+        ok = roundTrip(bench, "saveQM", "loadQM", QLatin1String("qm"), dir, catalogues, options);
+    if (ok && bench.isEnabled("po"))
+        ok = roundTrip(bench, "savePO", "loadPO", QLatin1String("po"), dir, catalogues, options);
+    if (ok && bench.isEnabled("xliff"))
+        ok = roundTrip(bench, "saveXLIFF", "loadXLIFF", QLatin1String("xlf"), dir, catalogues, options);
+    QJsonObject memory;
+    if (ok && bench.isEnabled("memory"))
+        ok = measureMemory(catalogues.first(), dir, &memory);
+    if (!ok)
+        return 1;
+
+    if (bench.isEnabled("similarity")) {
+        QStringList queries;
+        for (int i = 0; i < options.queries; ++i)
+            queries << generator.text(i % options.contexts, i);
+        // The index is built once per catalogue, so only the lookups are timed.
+        const TranslatorTextIndex index(&catalogues.constFirst());
+        bench.run("similarity", queries.size(), -1, [&]() {
+            foreach (const QString &query, queries)
+                similarTextHeuristicCandidates(index, query, 5);
+            return true;
+        });
+    }
+
+    QJsonObject parameters;
+    parameters.insert(QLatin1String("messages"), options.messages);
+    parameters.insert(QLatin1String("contexts"), options.contexts);
+    parameters.insert(QLatin1String("density"), options.density);
+    parameters.insert(QLatin1String("plurals"), options.plurals);
+    parameters.insert(QLatin1String("obsolete"), options.obsolete);
+    parameters.insert(QLatin1String("languages"), QJsonArray::fromStringList(options.languages));
+    parameters.insert(QLatin1String("threads"), options.threads);
+    parameters.insert(QLatin1String("queries"), options.queries);
+    parameters.insert(QLatin1String("seed"), qint64(options.seed));
+
+    QJsonObject root;
+    root.insert(QLatin1String("parameters"), parameters);
+    root.insert(QLatin1String("extractedMessages"), extracted.messageCount());
+    root.insert(QLatin1String("results"), bench.results());
+    if (!memory.isEmpty())
+        root.insert(QLatin1String("memory"), memory);
+    root.insert(QLatin1String("peakRssKiB"), peakRssKiB());
+    const QByteArray json = QJsonDocument(root).toJson();
+
+    if (options.outFileName.isEmpty()) {
+        std::cout << json.constData();
+    } else {
+        QFile file(options.outFileName);
+        if (!file.open(QIODevice::WriteOnly) || file.write(json) != json.size()) {
+            printErr(QString::fromLatin1("Cannot write %1: %2\n")
+                     .arg(options.outFileName, file.errorString()));
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,14 @@
+TARGET = tst_bench_translationtools
+CONFIG += console
+CONFIG -= app_bundle
+QT = core-private
+
+DEFINES += QT_NO_CAST_TO_ASCII QT_NO_CAST_FROM_ASCII
+
+LINGUIST_SRC = $$PWD/../../../../src/linguist
+include($$LINGUIST_SRC/shared/formats.pri)
+include($$LINGUIST_SRC/lupdate/lupdate.pri)
+
+SOURCES += main.cpp
+
+win32: LIBS += -lpsapi
@@ -1,2 +1,2 @@
 TEMPLATE = subdirs
-SUBDIRS +=  auto
+SUBDIRS +=  auto benchmarks